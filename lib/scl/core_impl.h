@@ -37,7 +37,7 @@ namespace samc::impl {
   template<typename T>
   T safe_div(const T &den, const T &num) { 
     if (!den) {
-      return den{};
+      return T{};
     }
     return den / num;
   }    
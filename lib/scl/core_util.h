@@ -5,7 +5,7 @@
 
 namespace scl::util {
 
-  void assert(bool statement) {
+  inline void assert(bool statement) {
     if (!statement && ASSERT_ENABLED) {
       __DMB();
       __BKPT(2);
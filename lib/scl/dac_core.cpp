@@ -0,0 +1,22 @@
+#include "dac_core.h"
+
+namespace samc {
+
+  namespace dac {
+
+    bool scaleTable(const int16_t *unit, uint16_t *codes, const int &length,
+      const int &amplitude, const int &offset) {
+      if (!unit || !codes || length < 1 || amplitude < 0 
+        || amplitude > DAC_MAX_CODE) {
+        return false;
+      }
+      for (int i = 0; i < length; i++) {
+        const int code = offset + ((unit[i] * amplitude) >> 15);
+        codes[i] = code < 0 ? 0 : code > DAC_MAX_CODE ? DAC_MAX_CODE : code;
+      }
+      return true;
+    }
+
+  }
+
+}
@@ -0,0 +1,42 @@
+
+#pragma once
+#include <sam.h>
+#include <dma_core.h>
+
+namespace samc {
+
+  namespace dac {
+
+    #define DAC_MAX_CODE 4095
+
+    // Scales a unit table (full scale at +-32767) into converter codes once
+    // per table, so playback moves finished samples. Codes are clamped.
+    bool scaleTable(const int16_t *unit, uint16_t *codes, const int &length,
+      const int &amplitude, const int &offset);
+
+    // Paces the player with the converter's EMPTY trigger and attaches it to
+    // DATA[dacChannel]. The converter itself must already be enabled. Fails
+    // if the DMA channel is already reserved.
+    template<int dmaIndex, int dacChannel>
+    bool setPlayback(dma::wavePlayer &player) {
+      static_assert(dacChannel == 0 || dacChannel == 1,
+        "dac: channel must be 0 or 1");
+      static_assert(dmaIndex >= 0 && dmaIndex < DMAC_CH_NUM,
+        "dac: dma channel index out of range");
+      using config = dma::channelConfig<dacChannel ? dma::LINK_DAC_EMPTY1 
+        : dma::LINK_DAC_EMPTY0, dma::MODE_TRANSFER_1VALUE, DMA_PRILVL_COUNT - 1>;
+
+      if (!dma::allocCtrl::reserve(dmaIndex, "dac playback")) {
+        return false;
+      }
+      if (!dma::channelCtrl<dmaIndex>().template setConfig<config>()
+        || !player.attach(&DAC->DATA[dacChannel].reg, dmaIndex, 2)) {
+        dma::allocCtrl::release(dmaIndex);
+        return false;
+      }
+      return true;
+    }
+
+  }
+
+}
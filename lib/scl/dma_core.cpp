@@ -1,30 +1,225 @@
-/*
-
 #include "dma_core.h"
+#include <core_impl.h>
+#if DMA_STATS_ENABLED
+  #include <stdio.h>
+#endif
 
 namespace {
 
-  #define DMA_PRILVL_COUNT 4
-  #define DMA_IRQ_COUNT 5
-  #define DMA_IRQPRI_MAX 5
-  #define DMA_QOS_MAX 3
-  #define MAX_BURSTLENGTH 16
-  #define DMA_MAX_TASKS 256
+  #define DMA_MAX_BTCNT 0xFFFF
+
+  #if DMA_IRQ_LATENCY_ENABLED
+    #define DMA_IRQ_TIMESTAMP() ((uint32_t)DWT->CYCCNT)
+  #else
+    #define DMA_IRQ_TIMESTAMP() (0)
+  #endif
+
+  using samc::impl::clamp;
+  using samc::impl::clamp_min;
 
   static const int BURSTLEN_REF[] = {1, 2, 4};
 
   static DmacDescriptor wbDescArray[DMAC_CH_NUM] SECTION_DMAC_DESCRIPTOR __ALIGNED(16);
   static DmacDescriptor baseDescArray[DMAC_CH_NUM] SECTION_DMAC_DESCRIPTOR __ALIGNED(16);
-  static dma::taskDescriptor *baseTasks[DMAC_CH_NUM] = { nullptr };
-  static dma::errorCallbackType errorCB = nullptr;
-  static dma::transferCallbackType transferCB = nullptr;
+  static samc::dma::taskDescriptor *baseTasks[DMAC_CH_NUM] = { nullptr };
+  static samc::dma::errorCallbackType errorCB = nullptr;
+  static samc::dma::transferCallbackType transferCB = nullptr;
+  static samc::dma::multiBuffer *chBuffers[DMAC_CH_NUM] = { nullptr };
+  static samc::dma::wavePlayer *chWaves[DMAC_CH_NUM] = { nullptr };
+  static samc::dma::taskQueue *chQueues[DMAC_CH_NUM] = { nullptr };
+
+  struct callbackData {
+    samc::dma::chTransferCallbackType transfer;
+    void *transferCtx;
+    samc::dma::chErrorCallbackType error;
+    void *errorCtx;
+  };
+  static callbackData chCallbacks[DMAC_CH_NUM] = {};
+
+  #if DMA_IRQ_LATENCY_ENABLED
+    struct latencyData {
+      uint32_t last;
+      uint32_t max;
+    };
+    static latencyData irqLatency[DMAC_CH_NUM] = {};
+  #endif
+
+  struct pollData {
+    bool enabled;
+    bool active;
+    volatile bool done;
+    volatile bool failed;
+    int threshold;
+  };
+  static pollData chPoll[DMAC_CH_NUM] = {};
+
+  struct watchData {
+    bool enabled;
+    volatile bool faulted;
+    uint8_t ticks;
+    uint8_t limit;
+    uint32_t btcnt;
+    uint32_t descAddr;
+    uint32_t restarts;
+  };
+  static watchData chWatch[DMAC_CH_NUM] = {};
+
+  #if DMA_STATS_ENABLED
+    static samc::dma::channelStats chStats[DMAC_CH_NUM] = {};
+    static uint32_t chStartTime[DMAC_CH_NUM] = {};
+  #endif
+
+  struct chainData {
+    samc::dma::taskDescriptor *tail;
+    int count;
+    bool spanned;
+    #if DMA_TASK_TABLE_ENABLED
+      samc::dma::taskDescriptor *table[DMA_MAX_TASKS];
+    #endif
+  };
+  static chainData chainArray[DMAC_CH_NUM] = {};
+
+  static DmacDescriptor descPool[DMA_DESC_POOL_SIZE] SECTION_DMAC_DESCRIPTOR __ALIGNED(16);
+  static volatile uint32_t descFree = 0;
+  static volatile uint32_t descPoolHigh = 0;
+
+  struct memChannelData {
+    volatile uint32_t submitted;
+    volatile uint32_t completed;
+    volatile uint32_t failed;
+    uint32_t fill;
+    int8_t channel;
+    bool init;
+  };
+  static memChannelData memChannels[DMA_MEMCPY_CH_COUNT] = {};
+
+  static uint32_t allocMask = 0;
+  static const char *allocOwners[DMAC_CH_NUM] = {};
+
+  // Slicing-by-8 tables, CRC32 is reflected and CRC16 is not.
+  template<typename T, bool REFLECT>
+  struct crcTable {
+    constexpr crcTable(const T poly) : data() {
+      for (int i = 0; i < 256; i++) {
+        T value = REFLECT ? (T)i : (T)(i << (sizeof(T) * 8 - 8));
+        for (int j = 0; j < 8; j++) {
+          if (REFLECT) {
+            value = (value & 1) ? (T)((value >> 1) ^ poly) : (T)(value >> 1);
+          } else {
+            value = (value >> (sizeof(T) * 8 - 1)) ? (T)((value << 1) ^ poly) 
+              : (T)(value << 1);
+          }
+        }
+        data[0][i] = value;
+      }
+      for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+          const T prev = data[k - 1][i];
+          data[k][i] = REFLECT ? (T)((prev >> 8) ^ data[0][prev & 0xFF])
+            : (T)((prev << 8) ^ data[0][(prev >> (sizeof(T) * 8 - 8)) & 0xFF]);
+        }
+      }
+    }
+    T data[8][256];
+  };
+  static constexpr crcTable<uint32_t, true> crc32Table(0xEDB88320UL);
+  static constexpr crcTable<uint16_t, false> crc16Table(0x1021);
+
+  static int crcChannel = -1;
+  static bool crcLocked = false;
+
+
+  // The span the CRC engine is working through, chunk by chunk from the
+  // CRC channel's transfer callback.
+  struct crcJob {
+    samc::dma::crc::crcState *state;
+    const uint8_t *bytes;
+    size_t remaining;
+    int beatSize;
+    samc::dma::crc::crcCallbackType callback;
+    void *context;
+  };
+  static crcJob crcPending;
+  static samc::dma::taskDescriptor memTasks[DMA_MEMCPY_CH_COUNT][DMA_MEMCPY_TASKS];
+
+  struct irqLock {
+    irqLock() : primask(__get_PRIMASK()) { __disable_irq(); }
+    ~irqLock() { __set_PRIMASK(primask); }
+    uint32_t primask;
+  };
+
+  // Released descriptors are threaded through their own DESCADDR field,
+  // untouched descriptors are handed out from the top of the pool. Both are
+  // updated with LDREX/STREX instead of masking interrupts: exception entry
+  // and return clear the local monitor, so a handler that takes or returns
+  // a descriptor in between makes the store fail and the loop retry.
+  DmacDescriptor *acquireDesc() {
+    DmacDescriptor *desc;
+    do {
+      desc = (DmacDescriptor*)(uintptr_t)__LDREXW(&descFree);
+      if (!desc) {
+        __CLREX();
+        break;
+      }
+    } while (__STREXW(desc->DESCADDR.reg, &descFree));
+    if (!desc) {
+      uint32_t high;
+      do {
+        high = __LDREXW(&descPoolHigh);
+        if (high >= DMA_DESC_POOL_SIZE) {
+          __CLREX();
+          return nullptr;
+        }
+      } while (__STREXW(high + 1, &descPoolHigh));
+      desc = &descPool[high];
+    }
+    memset((void*)desc, 0, sizeof(DmacDescriptor));
+    return desc;
+  }
+
+  bool releaseDesc(DmacDescriptor *desc) {
+    if (desc < &descPool[0] || desc >= &descPool[DMA_DESC_POOL_SIZE]) {
+      return false;
+    }
+    desc->BTCTRL.reg = 0;
+    do {
+      desc->DESCADDR.reg = __LDREXW(&descFree);
+    } while (__STREXW((uint32_t)(uintptr_t)desc, &descFree));
+    return true;
+  }
+
+  // Distance between a side's start and the end address the DMAC expects.
+  uint32_t blockOffset(const DmacDescriptor *desc, const bool &isSrc) {
+    if (!(isSrc ? desc->BTCTRL.bit.SRCINC : desc->BTCTRL.bit.DSTINC)) {
+      return 0;
+    }
+    int shift = desc->BTCTRL.bit.BEATSIZE;
+    if (desc->BTCTRL.bit.STEPSEL == (isSrc ? DMAC_BTCTRL_STEPSEL_SRC_Val 
+      : DMAC_BTCTRL_STEPSEL_DST_Val)) {
+      shift += desc->BTCTRL.bit.STEPSIZE;
+    }
+    return (uint32_t)desc->BTCNT.reg << shift;
+  }
 
 }
 
 
 
+namespace samc {
+
 namespace dma {
 
+  namespace configGroup {
+
+    int irqPriority = 1;
+    int prilvl_service_qual[DMA_PRILVL_COUNT] = {2};
+    bool prilvl_rr_mode[DMA_PRILVL_COUNT] = {false};
+    bool prilvl_enabled[DMA_PRILVL_COUNT] = {false};
+    bool chRunStandby[DMAC_CH_NUM] = {false};
+    int chPrilvl[DMAC_CH_NUM] = {2};
+
+  }
+
   namespace sys {
 
     bool setInit(const bool &value) {
@@ -41,14 +236,18 @@ namespace dma {
           NVIC_EnableIRQ((IRQn_Type)(DMAC_0_IRQn + i));
         }
       }
+      #if DMA_IRQ_LATENCY_ENABLED || DMA_STATS_ENABLED
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+      #endif
       DMAC->CRCCTRL.reg &= ~DMAC_CRCCTRL_MASK;
       DMAC->CTRL.bit.SWRST = 1;
       while(DMAC->CTRL.bit.SWRST);
 
       memset((void*)wbDescArray, 0, sizeof(wbDescArray));
       memset((void*)baseDescArray, 0, sizeof(baseDescArray));
-      DMAC->BASEADDR.reg = (uint32_t)baseDescArray;
-      DMAC->WRBADDR.reg = (uint32_t)wbDescArray;
+      DMAC->BASEADDR.reg = (uintptr_t)baseDescArray;
+      DMAC->WRBADDR.reg = (uintptr_t)wbDescArray;
 
       if (value) {
         for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
@@ -77,16 +276,20 @@ namespace dma {
       return DMAC->CTRL.bit.DMAENABLE;
     }
 
-    bool setErrorCallback(errorCallbackType &errorCallback) {
+    bool setErrorCallback(errorCallbackType errorCallback) {
       errorCB = errorCallback;
       if (errorCallback) {
         for (int i = 0; i < DMAC_CH_NUM; i++) {
-          DMAC->Channel[i].CHINTENSET.bit.TERR = 1;
+          DMAC->Channel[i].CHINTENSET.reg = DMAC_CHINTENSET_TERR;
         }
       } else {
         for (int i = 0; i < DMAC_CH_NUM; i++) {
-          DMAC->Channel[i].CHINTFLAG.bit.TERR = 1;
-          DMAC->Channel[i].CHINTENCLR.bit.TERR = 1;
+          if (::chCallbacks[i].error || ::chBuffers[i] || ::chWatch[i].enabled
+            || ::chPoll[i].enabled) {
+            continue;
+          }
+          DMAC->Channel[i].CHINTENCLR.reg = DMAC_CHINTENCLR_TERR;
+          DMAC->Channel[i].CHINTFLAG.reg = DMAC_CHINTFLAG_TERR;
         }
       }
       return true;
@@ -95,31 +298,124 @@ namespace dma {
       return errorCB;
     }
 
-    bool setTransferCallback(transferCallbackType &transferCallback) {
+    bool setTransferCallback(transferCallbackType transferCallback) {
       transferCB = transferCallback;
-      if (transferCallback && !transferCB) {
+      if (transferCallback) {
         for (int i = 0; i < DMAC_CH_NUM; i++) {
-          DMAC->Channel[i].CHINTENSET.bit.TCMPL = 1;
+          DMAC->Channel[i].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
         }
-      } else if (!transferCallback) {
+      } else {
         for (int i = 0; i < DMAC_CH_NUM; i++) {
-          DMAC->Channel[i].CHINTENCLR.bit.TCMPL = 1;
-          DMAC->Channel[i].CHINTFLAG.bit.TCMPL = 1;
+          if (::chCallbacks[i].transfer || ::chBuffers[i] || ::chWaves[i]) {
+            continue;
+          }
+          DMAC->Channel[i].CHINTENCLR.reg = DMAC_CHINTENCLR_TCMPL;
+          DMAC->Channel[i].CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
         }
       }
       return true;
     }
-    bool getTransferCallback() {
+    transferCallbackType getTransferCallback() {
       return transferCB;
     }
 
+    uint32_t getIrqLatency(const int &index) {
+      #if DMA_IRQ_LATENCY_ENABLED
+        return ::irqLatency[index].last;
+      #else
+        (void)index;
+        return 0;
+      #endif
+    }
+    uint32_t getIrqLatencyMax(const int &index) {
+      #if DMA_IRQ_LATENCY_ENABLED
+        return ::irqLatency[index].max;
+      #else
+        (void)index;
+        return 0;
+      #endif
+    }
+    void clearIrqLatency() {
+      #if DMA_IRQ_LATENCY_ENABLED
+        memset(::irqLatency, 0, sizeof(::irqLatency));
+      #endif
+    }
+
+    bool getStats(const int &index, channelStats &value) {
+      #if DMA_STATS_ENABLED
+        if (index < 0 || index >= DMAC_CH_NUM) {
+          return false;
+        }
+        irqLock lock;
+        memcpy(&value, &::chStats[index], sizeof(channelStats));
+        return true;
+      #else
+        (void)index;
+        (void)value;
+        return false;
+      #endif
+    }
+    void clearStats(const int &index) {
+      #if DMA_STATS_ENABLED
+        if (index >= 0 && index < DMAC_CH_NUM) {
+          irqLock lock;
+          memset(&::chStats[index], 0, sizeof(channelStats));
+        }
+      #else
+        (void)index;
+      #endif
+    }
+
+    bool dumpStats(const int &index, statsWriterType writer) {
+      #if DMA_STATS_ENABLED
+        channelStats value;
+        if (!writer || !getStats(index, value)) {
+          return false;
+        }
+        char line[160];
+        char bytes[24];
+        const unsigned long bytesHigh = value.bytes / 1000000000ULL;
+        const unsigned long bytesLow = value.bytes % 1000000000ULL;
+        if (bytesHigh) {
+          snprintf(bytes, sizeof(bytes), "%lu%09lu", bytesHigh, bytesLow);
+        } else {
+          snprintf(bytes, sizeof(bytes), "%lu", bytesLow);
+        }
+        snprintf(line, sizeof(line), "ch%d transfers=%lu bytes=%s suspends=%lu "
+          "errors(crc/desc/xfer/stall)=%lu/%lu/%lu/%lu", index, 
+          (unsigned long)value.transfers, bytes, (unsigned long)value.suspends,
+          (unsigned long)value.errors[ERROR_CRC], 
+          (unsigned long)value.errors[ERROR_DESC],
+          (unsigned long)value.errors[ERROR_TRANSFER],
+          (unsigned long)value.errors[ERROR_STALL]);
+        writer(line);
+        for (int i = 0; i < DMA_STATS_BINS; i++) {
+          if (value.latency[i]) {
+            snprintf(line, sizeof(line), "ch%d latency<2^%d=%lu", index, i, 
+              (unsigned long)value.latency[i]);
+            writer(line);
+          }
+        }
+        return true;
+      #else
+        (void)index;
+        (void)writer;
+        return false;
+      #endif
+    }
+
   }
 
   namespace ach {
 
-    int getbytes() {
-      return DMAC->ACTIVE.bit.BTCNT * DMAC->ACTIVE.bit.ABUSY
-        * wbDescArray[DMAC->ACTIVE.bit.ID].BTCTRL.bit.BEATSIZE;
+    int getBytes() {
+      const uint32_t active = DMAC->ACTIVE.reg;
+      if (!(active & DMAC_ACTIVE_ABUSY)) {
+        return 0;
+      }
+      const int id = (active & DMAC_ACTIVE_ID_Msk) >> DMAC_ACTIVE_ID_Pos;
+      return ((active & DMAC_ACTIVE_BTCNT_Msk) >> DMAC_ACTIVE_BTCNT_Pos)
+        << wbDescArray[id].BTCTRL.bit.BEATSIZE;
     }
 
     int getIndex() {
@@ -134,6 +430,9 @@ namespace dma {
 
   namespace crc {
 
+    crcTag CRC_INPUT;
+    crcTag CRC_OUTPUT;
+
     bool setInputChannel(const int &value) {
       if (value >= DMAC_CH_NUM || DMAC->CRCSTATUS.bit.CRCBUSY) {
         return false;
@@ -168,8 +467,237 @@ namespace dma {
 
   }
 
+  // Total bytes of one pass over the channel's chain, and how many of its
+  // blocks raise TCMPL.
+  uint32_t chainBytes_(const int &index, int &interruptBlocks) {
+    const DmacDescriptor *current = &baseDescArray[index];
+    uint32_t bytes = 0;
+    int steps = 0;
+    interruptBlocks = 0;
+    do {
+      bytes += current->BTCNT.reg << current->BTCTRL.bit.BEATSIZE;
+      interruptBlocks += current->BTCTRL.bit.BLOCKACT == DMAC_BTCTRL_BLOCKACT_INT_Val
+        || current->BTCTRL.bit.BLOCKACT == DMAC_BTCTRL_BLOCKACT_BOTH_Val;
+      current = (const DmacDescriptor*)(uintptr_t)current->DESCADDR.bit.DESCADDR;
+    } while(current && current != &baseDescArray[index] 
+      && ++steps <= DMA_DESC_POOL_SIZE);
+    return bytes;
+  }
+
+  #if DMA_STATS_ENABLED
+    // Bytes per TCMPL are averaged over the interrupting blocks of the
+    // chain, which is exact for every chain built in this module.
+    uint32_t statsChainBytes_(const int &index) {
+      int blocks;
+      const uint32_t bytes = chainBytes_(index, blocks);
+      return blocks ? bytes / blocks : bytes;
+    }
+
+    void statsRecord_(const int &index, const uint8_t &flags, 
+      const CHANNEL_ERROR &error) {
+      channelStats &value = ::chStats[index];
+      if (flags & DMAC_CHINTFLAG_TCMPL) {
+        const uint32_t now = DWT->CYCCNT;
+        const uint32_t latency = now - ::chStartTime[index];
+        const int bin = latency ? 32 - __builtin_clz(latency) : 0;
+        value.latency[bin < DMA_STATS_BINS ? bin : DMA_STATS_BINS - 1]++;
+        value.transfers++;
+        value.bytes += statsChainBytes_(index);
+        ::chStartTime[index] = now;
+      }
+      if (flags & DMAC_CHINTFLAG_TERR) {
+        value.errors[error]++;
+      }
+      if (flags & DMAC_CHINTFLAG_SUSP) {
+        value.suspends++;
+      }
+    }
+  #endif
+
   namespace ch {
 
+    // Transfers up to the threshold complete without TCMPL/TERR interrupts
+    // and are picked up by wait(), longer ones fall back to the ISR.
+    void armPoll_(const int &index) {
+      pollData &data = ::chPoll[index];
+      int blocks;
+      data.done = false;
+      data.failed = false;
+      data.active = chainBytes_(index, blocks) <= (uint32_t)data.threshold;
+      if (data.active) {
+        DMAC->Channel[index].CHINTENCLR.reg = DMAC_CHINTENCLR_TCMPL
+          | DMAC_CHINTENCLR_TERR;
+      } else {
+        DMAC->Channel[index].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL
+          | DMAC_CHINTENSET_TERR;
+      }
+    }
+
+    bool suspendChannel_(const int &index) {
+      if (!DMAC->Channel[index].CHCTRLA.bit.ENABLE
+        || DMAC->Channel[index].CHINTFLAG.bit.SUSP) {
+        return false;
+      }
+      DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_SUSPEND_Val;
+      while(DMAC->Channel[index].CHCTRLB.bit.CMD
+        == DMAC_CHCTRLB_CMD_SUSPEND_Val);
+      return true;
+    }
+
+    void linkTask_(taskDescriptor *task, taskDescriptor *next) {
+      task->linked = next;
+      task->desc->DESCADDR.bit.DESCADDR = next ? (uintptr_t)next->desc : 0;
+    }
+
+    taskDescriptor *taskAt_(const int &taskIndex, const int &index) {
+      const chainData &chain = ::chainArray[index];
+      if (taskIndex == chain.count - 1) {
+        return chain.tail;
+      }
+      #if DMA_TASK_TABLE_ENABLED
+        return chain.table[taskIndex];
+      #else
+        taskDescriptor *current = ::baseTasks[index];
+        for (int i = 0; i < taskIndex; i++) {
+          current = current->linked;
+        }
+        return current;
+      #endif
+    }
+
+    // Drops a span chain built by gather/scatter, returning its descriptors
+    // (all but the base) to the pool.
+    void clearSpans_(const int &index) {
+      if (!::chainArray[index].spanned) {
+        return;
+      }
+      if (DMAC->Channel[index].CHCTRLA.bit.ENABLE) {
+        DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
+        while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
+      }
+      DmacDescriptor *current = (DmacDescriptor*)(uintptr_t)baseDescArray[index]
+        .DESCADDR.bit.DESCADDR;
+      while(current) {
+        DmacDescriptor *next = (DmacDescriptor*)(uintptr_t)current->DESCADDR.bit.DESCADDR;
+        releaseDesc(current);
+        current = next;
+      }
+      memset((void*)&baseDescArray[index], 0, sizeof(DmacDescriptor));
+      ::chainArray[index].spanned = false;
+    }
+
+    // Moves the task into the channel's chain at taskIndex (0 - count). The
+    // first task always lives in baseDescArray, so a new base swaps its
+    // descriptor with the old base. A looped chain (tail -> base) stays looped.
+    bool insertTask_(const int &taskIndex, taskDescriptor &task, const int &index) {
+      chainData &chain = ::chainArray[index];
+      taskDescriptor *base = ::baseTasks[index];
+      bool looped = base && chain.tail->linked == base;
+
+      if (!taskIndex) {
+        if (!base) {
+          clearSpans_(index);
+        }
+        if (base) {
+          DmacDescriptor *moved = acquireDesc();
+          if (!moved) {
+            return false;
+          }
+          memcpy((void*)moved, &baseDescArray[index], sizeof(DmacDescriptor));
+          base->desc = moved;
+          base->info.alloc = true;
+        }
+        memcpy((void*)&baseDescArray[index], task.desc, sizeof(DmacDescriptor));
+        if (task.info.alloc) {
+          releaseDesc(task.desc);
+        }
+        task.info.alloc = false;
+        task.desc = &baseDescArray[index];
+        linkTask_(&task, base);
+
+        if (!base) {
+          chain.tail = &task;
+        } else if (looped) {
+          chain.tail->linked = &task;
+        }
+        ::baseTasks[index] = &task;
+
+      } else if (taskIndex == chain.count) {
+        task.desc->DESCADDR.bit.DESCADDR = chain.tail->desc->DESCADDR.bit.DESCADDR;
+        task.linked = chain.tail->linked;
+        linkTask_(chain.tail, &task);
+        chain.tail = &task;
+
+      } else {
+        taskDescriptor *prev = taskAt_(taskIndex - 1, index);
+        task.desc->DESCADDR.bit.DESCADDR = prev->desc->DESCADDR.bit.DESCADDR;
+        task.linked = prev->linked;
+        linkTask_(prev, &task);
+      }
+      #if DMA_TASK_TABLE_ENABLED
+        memmove(&chain.table[taskIndex + 1], &chain.table[taskIndex],
+          (chain.count - taskIndex) * sizeof(taskDescriptor*));
+        chain.table[taskIndex] = &task;
+      #endif
+      task.info.assignedCh = index;
+      chain.count++;
+      return true;
+    }
+
+    taskDescriptor *extractTask_(const int &taskIndex, const int &index) {
+      chainData &chain = ::chainArray[index];
+      taskDescriptor *base = ::baseTasks[index];
+      taskDescriptor *removed = nullptr;
+      bool looped = chain.tail->linked == base;
+
+      if (!taskIndex) {
+        removed = base;
+        taskDescriptor *newBase = (base->linked != base) ? base->linked : nullptr;
+        DmacDescriptor baseDesc;
+        memcpy((void*)&baseDesc, &baseDescArray[index], sizeof(DmacDescriptor));
+
+        if (newBase) {
+          DmacDescriptor *freed = newBase->desc;
+          bool freedAlloc = newBase->info.alloc;
+          memcpy((void*)&baseDescArray[index], freed, sizeof(DmacDescriptor));
+          newBase->desc = &baseDescArray[index];
+          newBase->info.alloc = false;
+          removed->desc = freedAlloc ? freed : acquireDesc();
+          if (looped) {
+            chain.tail->linked = newBase;
+          }
+        } else {
+          removed->desc = acquireDesc();
+          memset((void*)&baseDescArray[index], 0, sizeof(DmacDescriptor));
+          chain.tail = nullptr;
+        }
+        removed->info.alloc = removed->desc != nullptr;
+        if (removed->desc) {
+          memcpy((void*)removed->desc, &baseDesc, sizeof(DmacDescriptor));
+          removed->desc->DESCADDR.bit.DESCADDR = 0;
+        }
+        ::baseTasks[index] = newBase;
+
+      } else {
+        taskDescriptor *prev = taskAt_(taskIndex - 1, index);
+        removed = prev->linked;
+        prev->desc->DESCADDR.bit.DESCADDR = removed->desc->DESCADDR.bit.DESCADDR;
+        prev->linked = removed->linked;
+        if (removed == chain.tail) {
+          chain.tail = prev;
+        }
+        removed->desc->DESCADDR.bit.DESCADDR = 0;
+      }
+      #if DMA_TASK_TABLE_ENABLED
+        memmove(&chain.table[taskIndex], &chain.table[taskIndex + 1],
+          (chain.count - taskIndex - 1) * sizeof(taskDescriptor*));
+      #endif
+      removed->linked = nullptr;
+      removed->info.assignedCh = -1;
+      chain.count--;
+      return removed;
+    }
+
     bool setInit(const bool &value, const int &index) {
       DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
       while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
@@ -184,8 +712,8 @@ namespace dma {
         DMAC->Channel[index].CHPRILVL.bit.PRILVL
           = configGroup::chPrilvl[index];
         DMAC->Channel[index].CHINTENSET.reg |=
-            ((int)errorCB << DMAC_CHINTENSET_TERR_Pos)
-          | ((int)transferCB << DMAC_CHINTENSET_TCMPL_Pos);
+            ((errorCB != nullptr) << DMAC_CHINTENSET_TERR_Pos)
+          | ((transferCB != nullptr) << DMAC_CHINTENSET_TCMPL_Pos);
       }
       return true;
     }
@@ -204,31 +732,53 @@ namespace dma {
           DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
           while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
           DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_NOACT_Val;
-          DMAC->Channel[index].CHINTFLAG.bit.SUSP = 1;
+          DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_SUSP;
           return true;
         }
         case STATE_IDLE: {
-          if (DMAC->Channel[index].CHSTATUS.reg & (DMAC_CHSTATUS_BUSY
-            | DMAC_CHSTATUS_PEND)) {
+          // Only disabling drops a suspend, clearing the SUSP flag does not.
+          if ((DMAC->Channel[index].CHSTATUS.reg & (DMAC_CHSTATUS_BUSY
+            | DMAC_CHSTATUS_PEND)) || DMAC->Channel[index].CHINTFLAG.bit.SUSP) {
             DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
             while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
           }
           DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_NOACT_Val;
-          DMAC->Channel[index].CHINTFLAG.bit.SUSP = 1;
+          DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_SUSP;
+          #if DMA_STATS_ENABLED
+            ::chStartTime[index] = DWT->CYCCNT;
+          #endif
+          if (::chPoll[index].enabled) {
+            armPoll_(index);
+          }
           DMAC->Channel[index].CHCTRLA.bit.ENABLE = 1;
           return true;
         }
         case STATE_SUSPENDED: {
+          #if DMA_STATS_ENABLED
+            if (!DMAC->Channel[index].CHINTENSET.bit.SUSP) {
+              ::chStats[index].suspends++;
+            }
+          #endif
           DMAC->Channel[index].CHCTRLA.bit.ENABLE = 1;
-          DMAC->Channel[index].CHINTFLAG.bit.SUSP = 1;
+          DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_SUSP;
           DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_SUSPEND_Val;
           while(!DMAC->Channel[index].CHINTFLAG.bit.SUSP);
           return true;
         }
         case STATE_ACTIVE: {
+          #if DMA_STATS_ENABLED
+            ::chStartTime[index] = DWT->CYCCNT;
+          #endif
+          if (::chPoll[index].enabled) {
+            armPoll_(index);
+          }
           DMAC->Channel[index].CHCTRLA.bit.ENABLE = 1;
-          DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_NOACT_Val;
-          DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_RESETVALUE;
+          // A suspended channel (BLOCKACT, SUSPEND command or fetch error)
+          // only carries on after a RESUME command.
+          if (DMAC->Channel[index].CHINTFLAG.bit.SUSP) {
+            DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_SUSP;
+            DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_RESUME_Val;
+          }
           DMAC->SWTRIGCTRL.reg |= (1 << index);
           return true;
         }
@@ -251,7 +801,7 @@ namespace dma {
 
     bool setPeripheral(const PERIPHERAL_LINK &value, const int &index) {
       DMAC->Channel[index].CHCTRLA.bit.TRIGSRC = value;
-      return DMAC->Channel[index].CHCTRLA.bit.TRIGSRC == value;
+      return DMAC->Channel[index].CHCTRLA.bit.TRIGSRC == (uint32_t)value;
     }
     PERIPHERAL_LINK getPeripheral(const int &index) {
       return static_cast<PERIPHERAL_LINK>(DMAC->Channel[index]
@@ -277,6 +827,15 @@ namespace dma {
       return DMAC->Channel[index].CHCTRLA.bit.TRIGACT
         == DMAC_CHCTRLA_TRIGACT_BURST_Val;
     }
+    TRANSFER_MODE getTransferMode(const int &index) {
+      switch(DMAC->Channel[index].CHCTRLA.bit.TRIGACT) {
+        case DMAC_CHCTRLA_TRIGACT_BLOCK_Val: return MODE_TRANSFER_TASK;
+        case DMAC_CHCTRLA_TRIGACT_TRANSACTION_Val: return MODE_TRANSFER_ALL;
+        default: break;
+      }
+      return static_cast<TRANSFER_MODE>(DMAC->Channel[index].CHCTRLA.bit.BURSTLEN
+        + (1 - DMAC_CHCTRLA_BURSTLEN_SINGLE_Val));
+    }
 
     CHANNEL_ERROR getError(const int &index) {
       if (DMAC->Channel[index].CHINTFLAG.bit.TERR) {
@@ -290,145 +849,126 @@ namespace dma {
       return ERROR_NONE;
     }
 
+    bool setTransferCallback(chTransferCallbackType value, void *context,
+      const int &index) {
+      ::chCallbacks[index].transfer = value;
+      ::chCallbacks[index].transferCtx = context;
+      if (value) {
+        DMAC->Channel[index].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+      } else if (!transferCB && !::chBuffers[index] && !::chWaves[index]) {
+        DMAC->Channel[index].CHINTENCLR.reg = DMAC_CHINTENCLR_TCMPL;
+        DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+      }
+      return true;
+    }
+    chTransferCallbackType getTransferCallback(const int &index) {
+      return ::chCallbacks[index].transfer;
+    }
+
+    bool setErrorCallback(chErrorCallbackType value, void *context,
+      const int &index) {
+      ::chCallbacks[index].error = value;
+      ::chCallbacks[index].errorCtx = context;
+      if (value) {
+        DMAC->Channel[index].CHINTENSET.reg = DMAC_CHINTENSET_TERR;
+      } else if (!errorCB && !::chBuffers[index]) {
+        DMAC->Channel[index].CHINTENCLR.reg = DMAC_CHINTENCLR_TERR;
+        DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_TERR;
+      }
+      return true;
+    }
+    chErrorCallbackType getErrorCallback(const int &index) {
+      return ::chCallbacks[index].error;
+    }
+
     taskDescriptor getCurrentTask(const int &index) {
       return dma::taskDescriptor(&wbDescArray[index]);
     }
 
-    taskDescriptor &getTask(const int &taskIndex, const int &index) {
-      taskDescriptor *current = ::baseTasks[index];
-      for (int i = 0; i < taskIndex; i++) {
-        if (!current->getLinkedTask() || current->getLinkedTask() 
-          == ::baseTasks[index]) {
-          return *current;
-        }
-        current = current->getLinkedTask();
-      }
-      return *current;
+    DmacDescriptor *getBaseDescriptor(const int &index) {
+      return &baseDescArray[index];
+    }
+    const DmacDescriptor *getWritebackDescriptor(const int &index) {
+      return &wbDescArray[index];
+    }
+
+    taskDescriptor &getTask(const int &reqIndex, const int &index) {
+      int taskIndex = clamp(reqIndex, 0, clamp_min(::chainArray[index].count - 1, 0));
+      return *taskAt_(taskIndex, index);
     }
 
     int indexOf(const taskDescriptor &task, const int &index) {
-      int currIndex = 0;
-      taskDescriptor *current = ::baseTasks[index];
-      if (!current) {
-        if (current == &task) {
-          return 0;
+      const chainData &chain = ::chainArray[index];
+      if (task.info.assignedCh != index || !chain.count) {
+        return -1;
+      } else if (&task == ::baseTasks[index]) {
+        return 0;
+      } else if (&task == chain.tail) {
+        return chain.count - 1;
+      }
+      #if DMA_TASK_TABLE_ENABLED
+        for (int i = 1; i < chain.count - 1; i++) {
+          if (chain.table[i] == &task) {
+            return i;
+          }
         }
-        while(current->linked && current->linked != ::baseTasks[index]) {
-          current = current->linked;
-          currIndex++;
+      #else
+        taskDescriptor *current = ::baseTasks[index]->linked;
+        for (int i = 1; i < chain.count - 1; i++) {
           if (current == &task) {
-            return currIndex;
+            return i;
           }
+          current = current->linked;
         }
-      }
+      #endif
       return -1;
     }
 
     int getTaskCount(const int &index) {
-      taskDescriptor *current = ::baseTasks[index];
-      if (!current) {
-        return 0;
-      }
-      int count = 0;
-      while(current->linked && current->linked != ::baseTasks[index]) {
-        current = current->linked;
-        count++;
-      }
-      return count + 1;
+      return ::chainArray[index].count;
     }
 
     bool addTask(const int &reqIndex, taskDescriptor &task, const int &index) {
-      int taskIndex = clamp(reqIndex, 0, DMA_MAX_TASKS);
-      if (task.info.assignedCh != -1 || task.linked) {
+      if (!task.desc || task.info.assignedCh != -1 || task.linked
+        || ::chainArray[index].count >= DMA_MAX_TASKS) {
         return false;
       }
-      task.info.assignedCh = index;
-      task.linked = nullptr;
-      task.desc->DESCADDR.bit.DESCADDR = 0;
-
-      bool suspFlag = false;
-      if (!DMAC->Channel[index].CHINTFLAG.bit.SUSP) {
-        suspFlag = true;
-        DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_SUSPEND_Val;
-        while(DMAC->Channel[index].CHCTRLB.bit.CMD
-          == DMAC_CHCTRLB_CMD_SUSPEND_Val);
-      }
-      if (taskIndex) {
-        taskDescriptor *current = ::baseTasks[index];
-        taskDescriptor *prev = nullptr;
-
-        for (int i = 0; i < taskIndex; i++) {
-          if (!current->linked || current == ::baseTasks[index]) {
-            task.desc->DESCADDR.bit.DESCADDR
-              = current->desc->DESCADDR.bit.DESCADDR;
-            current->desc->DESCADDR.bit.DESCADDR = (uintptr_t)task.desc;
-            task.linked = current;
-            current->linked = &task;
-            break;
-          }
-          prev = current;
-          current = current->linked;
-        }
-        prev->desc->DESCADDR.bit.DESCADDR = (uintptr_t)task.desc;
-        task.desc->DESCADDR.bit.DESCADDR = (uintptr_t)current->desc;
-        prev->linked = &task;
-        task.linked = current;
-      } else {
-        taskDescriptor *nextTask = nullptr;
-        if (::baseTasks[index] != nullptr) {
-          nextTask = ::baseTasks[index];
-          nextTask->desc = new DmacDescriptor;
-          nextTask->info.alloc = true;
-          memcpy(nextTask->desc, &baseDescArray[index], sizeof(DmacDescriptor));
-
-          task.desc->DESCADDR.bit.DESCADDR = (uintptr_t)nextTask->desc;
-          task.linked = nextTask;
-        }
-        memcpy(&baseDescArray[index], task.desc, sizeof(DmacDescriptor));
-        if (task.info.alloc) {
-          delete task.desc;
-        }
-        task.info.alloc = false;
-        task.desc = &baseDescArray[index];
-        ::baseTasks[index] = &task;
-      }
+      int taskIndex = clamp(reqIndex, 0, ::chainArray[index].count);
+      bool suspFlag = suspendChannel_(index);
+      bool result = insertTask_(taskIndex, task, index);
       if (suspFlag) {
         DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_RESUME_Val;
       }
-      return true;
+      return result;
     }
 
     bool setTasks(std::initializer_list<taskDescriptor*>
       taskList, const int &index) {
+      if (taskList.size() > DMA_MAX_TASKS) {
+        return false;
+      }
+      for (taskDescriptor *task : taskList) {
+        if (!task || !task->desc || task->info.assignedCh != -1 || task->linked) {
+          return false;
+        }
+      }
       bool enableFlag = false;
       if (DMAC->Channel[index].CHCTRLA.bit.ENABLE) {
         enableFlag = true;
         DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
         while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
       }
-      if (!clearTasks()) {
+      if (!clearTasks(index)) {
         return false;
       }
-      taskDescriptor *prev = nullptr;
+      // A task listed twice is only caught here, the ones already inserted 
+      // are handed back so none of them stays assigned to the channel.
       for (taskDescriptor *task : taskList) {
-        if (task->info.assignedCh != -1 || task->linked) {
+        if (task->info.assignedCh != -1
+          || !insertTask_(::chainArray[index].count, *task, index)) {
+          clearTasks(index);
           return false;
         }
-        task->info.assignedCh = index;
-        if (!prev) {
-          prev = task;
-          memcpy(&baseDescArray[index], task->desc, sizeof(DmacDescriptor));
-          if (task->info.alloc) {
-            delete task->desc;
-          }
-          task->info.alloc = false;
-          task->desc = &baseDescArray[index];
-          ::baseTasks[index] = task;
-          continue;
-        }
-        prev->desc->DESCADDR.bit.DESCADDR = (uintptr_t)task->desc;
-        task->desc->DESCADDR.bit.DESCADDR = 0;
-        prev->linked = task;
       }
       if (enableFlag) {
         DMAC->Channel[index].CHCTRLA.bit.ENABLE = 1;
@@ -437,114 +977,236 @@ namespace dma {
     }
 
     taskDescriptor &removeTask(const int &reqIndex, const int &index) {
-      int taskIndex = clamp(reqIndex, 0, DMA_MAX_TASKS);
-      taskDescriptor *removed = nullptr;
+      int taskIndex = clamp(reqIndex, 0, clamp_min(::chainArray[index].count - 1, 0));
+      bool suspFlag = suspendChannel_(index);
+      taskDescriptor *removed = extractTask_(taskIndex, index);
+      if (suspFlag) {
+        DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_RESUME_Val;
+      }
+      return *removed;
+    }
 
-      if (!taskIndex) {
-        removed = baseTasks[index];
-        //assert(removed && removed->assignedCh == index); //////////////////////////////// TO DO
-        removed->desc = new DmacDescriptor;
-        memcpy(removed->desc, &baseDescArray[index], sizeof(DmacDescriptor));
+    bool clearTasks(const int &index) {
+      clearSpans_(index);
+      if (!::baseTasks[index]) {
+        return true;
+      }
+      if (DMAC->Channel[index].CHCTRLA.bit.ENABLE) {
+        DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
+        while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
+      }
+      taskDescriptor *base = ::baseTasks[index];
+      taskDescriptor *current = base->linked;
+      base->desc = acquireDesc();
+      base->info.alloc = base->desc != nullptr;
+      if (base->desc) {
+        memcpy((void*)base->desc, &baseDescArray[index], sizeof(DmacDescriptor));
+        base->desc->DESCADDR.bit.DESCADDR = 0;
+      }
+      base->linked = nullptr;
+      base->info.assignedCh = -1;
+
+      while(current && current != base) {
+        taskDescriptor *next = current->linked;
+        current->desc->DESCADDR.bit.DESCADDR = 0;
+        current->linked = nullptr;
+        current->info.assignedCh = -1;
+        current = next;
+      }
+      memset((void*)&baseDescArray[index], 0, sizeof(DmacDescriptor));
+      ::baseTasks[index] = nullptr;
+      ::chainArray[index].tail = nullptr;
+      ::chainArray[index].count = 0;
+      return true;
+    }
 
-        removed->info.alloc = true;
-        removed->info.assignedCh = -1;
-        removed->desc->DESCADDR.bit.DESCADDR = 0;
+    bool setLooped(const bool &value, const int &index) {
+      if (!::chainArray[index].count) {
+        return false;
+      }
+      bool suspFlag = suspendChannel_(index);
+      linkTask_(::chainArray[index].tail, value ? ::baseTasks[index] : nullptr);
+      if (suspFlag) {
+        DMAC->Channel[index].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_RESUME_Val;
+      }
+      return true;
+    }
+    bool getLooped(const int &index) {
+      return ::chainArray[index].count 
+        && ::chainArray[index].tail->linked == ::baseTasks[index];
+    }
 
-        if (removed->linked) {
-          taskDescriptor *newBase = removed->linked;
-          //assert(newBase && newBase->assignedCh == index); /////////////////////////////// TO DO
-          memcpy(&baseDescArray[index], newBase->desc, sizeof(DmacDescriptor));
-          if (newBase->info.alloc) {
-            delete newBase->desc;
-          }
-          newBase->info.alloc = false;
-          newBase->desc = &baseDescArray[index];
-        }
-      } else {
-        removed = baseTasks[index];
-        taskDescriptor *prev = nullptr;
-        for (int i = 0; i < taskIndex; i++) {
-          if (!removed->linked || removed->linked == baseTasks[index]) {
+    bool setPolled(const bool &value, const int &threshold, const int &index) {
+      if (threshold < 0) {
+        return false;
+      }
+      if (value) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+      } else if (::chPoll[index].active) {
+        DMAC->Channel[index].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL
+          | DMAC_CHINTENSET_TERR;
+      }
+      ::chPoll[index].enabled = value;
+      ::chPoll[index].active = false;
+      ::chPoll[index].threshold = threshold;
+      return true;
+    }
+    bool getPolled(const int &index) {
+      return ::chPoll[index].enabled;
+    }
+
+    // Returns false on timeout (0 waits forever) or on a transfer error.
+    bool wait(const uint32_t &timeout, const int &index) {
+      pollData &data = ::chPoll[index];
+      if (!data.enabled) {
+        return false;
+      }
+      const uint32_t start = DWT->CYCCNT;
+      while(!data.done) {
+        if (data.active) {
+          const uint8_t flags = DMAC->Channel[index].CHINTFLAG.reg
+            & (DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR);
+          if (flags) {
+            DMAC->Channel[index].CHINTFLAG.reg = flags;
+            data.failed = flags & DMAC_CHINTFLAG_TERR;
+            data.done = true;
             break;
           }
-          prev = removed;
-          removed = removed->linked;
         }
-        prev->desc->DESCADDR.bit.DESCADDR
-          = removed->desc->DESCADDR.bit.DESCADDR;
-        prev->linked = removed->linked;
-        removed->linked = nullptr;
-        removed->info.assignedCh = -1;
+        if (timeout && DWT->CYCCNT - start >= timeout) {
+          return false;
+        }
       }
-      return *removed;
+      return !data.failed;
     }
 
-    bool clearTasks(const int &index) {
-      auto resetTask = [&](taskDescriptor *task) {
-        task->info.assignedCh = -1;
-        task->linked = nullptr;
-        task->desc->DESCADDR.bit.DESCADDR = 0;
-      };
-      if (baseTasks[index]) {
-        taskDescriptor *current = baseTasks[index]->linked;
-        taskDescriptor *next = nullptr;
-
-        if (DMAC->Channel[index].CHCTRLA.bit.ENABLE) {
-          DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
-          while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
-        }
-        baseTasks[index]->desc = new DmacDescriptor;
-        memcpy(&baseTasks[index]->desc, &baseDescArray[index],
-          sizeof(DmacDescriptor));
-        baseTasks[index]->info.alloc = true;
-        resetTask(baseTasks[index]);
-
-        while(current->linked && current->linked != baseTasks[index]) {
-          next = current->linked;
-          resetTask(next);
+    // The write-back copy identifies the current block (its DESCADDR and
+    // end addresses are unique within a chain), the remaining beats come
+    // from ACTIVE when the channel holds the bus and from the write-back
+    // copy otherwise. The DMAC rewrites the copy on every block boundary,
+    // so ACTIVE and the whole copy are re-read until two passes agree and
+    // no lock or suspend is needed.
+    bool getProgress_(const int &index, int &transferred, int &remaining) {
+      if (index < 0 || index >= DMAC_CH_NUM) {
+        return false;
+      }
+      const DmacDescriptor &wb = wbDescArray[index];
+      uint32_t active;
+      uint32_t wbDescAddr;
+      uint32_t wbSrcAddr;
+      uint32_t wbDstAddr;
+      uint16_t wbBtctrl;
+      uint32_t wbBtcnt;
+      do {
+        active = DMAC->ACTIVE.reg;
+        wbDescAddr = wb.DESCADDR.reg;
+        wbSrcAddr = wb.SRCADDR.reg;
+        wbDstAddr = wb.DSTADDR.reg;
+        wbBtctrl = wb.BTCTRL.reg;
+        wbBtcnt = wb.BTCNT.reg;
+        __DMB();
+      } while(active != DMAC->ACTIVE.reg || wbDescAddr != wb.DESCADDR.reg
+        || wbSrcAddr != wb.SRCADDR.reg || wbDstAddr != wb.DSTADDR.reg
+        || wbBtctrl != wb.BTCTRL.reg || wbBtcnt != wb.BTCNT.reg);
+
+      const DmacDescriptor *current = &baseDescArray[index];
+      const DmacDescriptor *block = current;
+      int steps = 0;
+      do {
+        if (current->DESCADDR.reg == wbDescAddr 
+          && current->SRCADDR.reg == wbSrcAddr
+          && current->DSTADDR.reg == wbDstAddr) {
+          block = current;
+          break;
         }
-        memset(&baseDescArray[index], 0, sizeof(DmacDescriptor));
-        baseTasks[index] = nullptr;
+        current = (const DmacDescriptor*)(uintptr_t)current->DESCADDR.bit.DESCADDR;
+      } while(current && current != &baseDescArray[index] 
+        && ++steps <= DMA_DESC_POOL_SIZE);
+
+      const int beatShift = block->BTCTRL.bit.BEATSIZE;
+      const int total = block->BTCNT.reg;
+      int beats = wbBtcnt;
+      if ((active & DMAC_ACTIVE_ABUSY) && (int)((active & DMAC_ACTIVE_ID_Msk)
+        >> DMAC_ACTIVE_ID_Pos) == index) {
+        beats = (active & DMAC_ACTIVE_BTCNT_Msk) >> DMAC_ACTIVE_BTCNT_Pos;
+      } else if (!wbBtctrl) {
+        beats = total;
       }
+      beats = beats > total ? total : beats;
+      remaining = beats << beatShift;
+      transferred = (total - beats) << beatShift;
       return true;
     }
+    int getBytesTransferred(const int &index) {
+      int transferred = 0, remaining = 0;
+      getProgress_(index, transferred, remaining);
+      return transferred;
+    }
+    int getBytesRemaining(const int &index) {
+      int transferred = 0, remaining = 0;
+      getProgress_(index, transferred, remaining);
+      return remaining;
+    }
 
   } 
 
   taskDescriptor::taskDescriptor() {
-    desc = new DmacDescriptor;
-    info.alloc = true;
+    desc = acquireDesc();
+    linked = nullptr;
+    info.alloc = desc != nullptr;
+    info.assignedCh = -1;
     info.srcAlign = -1;
     info.destAlign = -1;
   }
   taskDescriptor::taskDescriptor(DmacDescriptor *desc) {
     this->desc = desc;
+    linked = nullptr;
     info.alloc = false;
+    info.assignedCh = -1;
     info.srcAlign = -1;
     info.destAlign = -1;
   }
   taskDescriptor::taskDescriptor(const taskDescriptor &other) {
     desc = other.desc;
-    info.alloc = other.info.alloc;
+    linked = nullptr;
+    info.alloc = false;
+    info.assignedCh = -1;
     info.srcAlign = other.info.srcAlign;
     info.destAlign = other.info.destAlign;
+    if (other.info.alloc) {
+      desc = acquireDesc();
+      info.alloc = desc != nullptr;
+      if (desc) {
+        memcpy((void*)desc, other.desc, sizeof(DmacDescriptor));
+        desc->DESCADDR.bit.DESCADDR = 0;
+      }
+    }
   }
 
   taskDescriptor &taskDescriptor::operator=
     (const taskDescriptor &other) {
+    if (this == &other || !desc || !other.desc) {
+      return *this;
+    }
     info.srcAlign = other.info.srcAlign;
     info.destAlign = other.info.destAlign;
-    memcpy(&desc, &other.desc, sizeof(DmacDescriptor));
+    uint32_t descAddr = desc->DESCADDR.reg;
+    memcpy((void*)desc, other.desc, sizeof(DmacDescriptor));
+    desc->DESCADDR.reg = descAddr;
     return *this;
   }
   taskDescriptor::operator DmacDescriptor*() {
     return desc;
   }
   taskDescriptor::operator bool() const {
-    return desc->BTCTRL.bit.VALID;
+    return desc && desc->BTCTRL.bit.VALID;
   }
 
   bool taskDescriptor::setEnabled(const bool &value) {
+    if (!desc) {
+      return false;
+    }
     desc->BTCTRL.bit.VALID = value && desc->SRCADDR.bit.SRCADDR != 0
       && desc->DSTADDR.bit.DSTADDR != 0 && desc->BTCNT.bit.BTCNT != 0;
     return desc->BTCTRL.bit.VALID == value;
@@ -553,124 +1215,122 @@ namespace dma {
     return desc->BTCTRL.bit.VALID;
   }
 
+  // Addresses are stored as end addresses, so both sides are rebased around
+  // any change to the beat size, step or increment.
   bool taskDescriptor::setDesc_(const void *value, const int &size,
     const bool &isVol, const int &index, const bool &isSrc) {
+    if (!desc) {
+      return false;
+    }
+    bool enableFlag = false;
+    if (info.assignedCh != -1 && DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE) {
+      DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE = 0;
+      while(DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE);
+      enableFlag = true;
+    }
+    uintptr_t srcBase = desc->SRCADDR.reg 
+      ? desc->SRCADDR.reg - blockOffset(desc, true) : 0;
+    uintptr_t dstBase = desc->DSTADDR.reg 
+      ? desc->DSTADDR.reg - blockOffset(desc, false) : 0;
+    bool result = true;
+
     if (!value) {
       if (isSrc) {
-        desc->SRCADDR.bit.SRCADDR = DMAC_SRCADDR_RESETVALUE;
+        srcBase = DMAC_SRCADDR_RESETVALUE;
         desc->BTCTRL.bit.SRCINC = 0;
         info.srcAlign = 0;
       } else {
-        desc->DSTADDR.bit.DSTADDR = DMAC_SRCADDR_RESETVALUE;
+        dstBase = DMAC_DSTADDR_RESETVALUE;
         desc->BTCTRL.bit.DSTINC = 0;
         info.destAlign = 0;
       }
-      return true;
-    }
-    bool validAlign = false;
-    for (int i = 0; i < sizeof(BURSTLEN_REF) / sizeof(BURSTLEN_REF[0]); i++) {
-      if (size % BURSTLEN_REF[i] == 0) {
+    } else {
+      int align = 0;
+      for (size_t i = 0; i < sizeof(BURSTLEN_REF) / sizeof(BURSTLEN_REF[0]); i++) {
+        if (size % BURSTLEN_REF[i] == 0) {
+          align = BURSTLEN_REF[i];
+        }
+      }
+      const bool crcInput = (uintptr_t)value == (uintptr_t)&crc::CRC_INPUT;
+      const bool crcOutput = (uintptr_t)value == (uintptr_t)&crc::CRC_OUTPUT;
+      if (!align || (crcInput && isSrc) || (crcOutput && !isSrc)) {
+        result = false;
+
+      } else {
+        const uintptr_t addr = crcInput ? (uintptr_t)&DMAC->CRCDATAIN.reg
+          : crcOutput ? (uintptr_t)&DMAC->CRCCHKSUM.reg : (uintptr_t)value;
+        const bool inc = index > 1 && !isVol && !crcInput && !crcOutput;
         if (isSrc) {
-          info.srcAlign = BURSTLEN_REF[i];
+          info.srcAlign = align;
+          desc->BTCTRL.bit.SRCINC = inc;
+          srcBase = addr;
         } else {
-          info.destAlign = BURSTLEN_REF[i];
+          info.destAlign = align;
+          desc->BTCTRL.bit.DSTINC = inc;
+          dstBase = addr;
         }
-        validAlign = true;
       }
     }
-    if (validAlign) {
-      bool enableFlag = false;
-      if (info.assignedCh != -1 && DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE) {
-        DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE = 0;
-        while(DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE);
-      }
-      if (isSrc) {
-        desc->BTCTRL.bit.SRCINC = (bool)(index > 1);
-      } else {
-        desc->BTCTRL.bit.DSTINC = (bool)(index > 1);
-      }
-      if (info.srcAlign && info.destAlign) {
-        desc->BTCTRL.bit.BEATSIZE = info.srcAlign < info.destAlign 
+    if (result) {
+      desc->BTCTRL.bit.STEPSEL = DMAC_BTCTRL_STEPSEL_DST_Val;
+      desc->BTCTRL.bit.STEPSIZE = 0;
+      if (info.srcAlign > 0 && info.destAlign > 0) {
+        const int beat = info.srcAlign < info.destAlign 
           ? info.srcAlign : info.destAlign;
+        desc->BTCTRL.bit.BEATSIZE = beat >> 1;
 
-        if (desc->BTCTRL.bit.SRCINC && info.srcAlign
-          < desc->BTCTRL.bit.BEATSIZE) {
+        // The wider side steps over the part of each element it skips.
+        if (desc->BTCTRL.bit.SRCINC && info.srcAlign > beat) {
           desc->BTCTRL.bit.STEPSEL = DMAC_BTCTRL_STEPSEL_SRC_Val;
-          desc->BTCTRL.bit.STEPSIZE = desc->BTCTRL.bit.BEATSIZE / info.srcAlign;
+          desc->BTCTRL.bit.STEPSIZE = (info.srcAlign / beat) >> 1;
 
-        } else if (desc->BTCTRL.bit.DSTINC && info.destAlign
-          < desc->BTCTRL.bit.BEATSIZE) {
+        } else if (desc->BTCTRL.bit.DSTINC && info.destAlign > beat) {
           desc->BTCTRL.bit.STEPSEL = DMAC_BTCTRL_STEPSEL_DST_Val;
-          desc->BTCTRL.bit.STEPSIZE = desc->BTCTRL.bit.BEATSIZE / info.destAlign;
+          desc->BTCTRL.bit.STEPSIZE = (info.destAlign / beat) >> 1;
         }
       }
-      if ((uintptr_t)value == (uintptr_t)&crc::CRC_INPUT) {
-        if (!isSrc) {
-          desc->DSTADDR.bit.DSTADDR = (uintptr_t)REG_DMAC_CRCDATAIN;
-        } else {
-          return false;
-        }
-      } else if ((uintptr_t)value == (uintptr_t)&crc::CRC_OUTPUT) {
-        if (isSrc) {
-          desc->SRCADDR.bit.SRCADDR = (uintptr_t)REG_DMAC_CRCCHKSUM;
-        } else {
-          return false;
-        }
-      } else {
-        uintptr_t addr = (uintptr_t)&value;
-        if (!isVol) {
-          addr += desc->BTCNT.bit.BTCNT * (desc->BTCTRL.bit.BEATSIZE + 1)
-            * (1 << desc->BTCTRL.bit.STEPSIZE * (desc->BTCTRL.bit.STEPSEL
-            == isSrc ? DMAC_BTCTRL_STEPSEL_SRC_Val : DMAC_BTCTRL_STEPSEL_DST_Val));
-        }
-        if (isSrc) {
-          desc->SRCADDR.bit.SRCADDR = addr;
-          return desc->SRCADDR.bit.SRCADDR == addr;
-        } else {
-          desc->DSTADDR.bit.DSTADDR = addr;
-          return desc->DSTADDR.bit.DSTADDR == addr;
-        }
-      }
-      if (enableFlag) {
-        DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE = 1;
-      }
-      return true;
+      desc->SRCADDR.reg = srcBase ? srcBase + blockOffset(desc, true) : 0;
+      desc->DSTADDR.reg = dstBase ? dstBase + blockOffset(desc, false) : 0;
     }
-    return false;
+    if (enableFlag) {
+      DMAC->Channel[info.assignedCh].CHCTRLA.bit.ENABLE = 1;
+    }
+    return result;
   }
   void *taskDescriptor::getSource() const {
-    return (void*)desc->SRCADDR.bit.SRCADDR;
+    if (!desc || !desc->SRCADDR.reg) {
+      return nullptr;
+    }
+    return (void*)(uintptr_t)(desc->SRCADDR.reg - blockOffset(desc, true));
   }
   void *taskDescriptor::getDestination() const {
-    return (void*)desc->DESCADDR.bit.DESCADDR;
+    if (!desc || !desc->DSTADDR.reg) {
+      return nullptr;
+    }
+    return (void*)(uintptr_t)(desc->DSTADDR.reg - blockOffset(desc, false));
   }
 
   bool taskDescriptor::setLength(const int &value) {
-    int prevLength = desc->BTCNT.bit.BTCNT;
-    desc->BTCNT.bit.BTCNT = value;
-    if (desc->SRCADDR.bit.SRCADDR) {
-      uintptr_t baseAddr = desc->SRCADDR.bit.SRCADDR - prevLength
-        * (desc->BTCTRL.bit.BEATSIZE + 1) * (1 << desc->BTCTRL.bit.STEPSIZE
-        * (desc->BTCTRL.bit.STEPSEL == DMAC_BTCTRL_STEPSEL_SRC_Val));
-      desc->SRCADDR.bit.SRCADDR = baseAddr +
-          (desc->BTCTRL.bit.BEATSIZE + 1) * (1 << desc->BTCTRL.bit.STEPSIZE
-        * (desc->BTCTRL.bit.STEPSEL == DMAC_BTCTRL_STEPSEL_SRC_Val));
-    }
-    if (desc->DSTADDR.bit.DSTADDR) {
-      uintptr_t baseAddr = desc->DSTADDR.bit.DSTADDR - prevLength
-        * (desc->BTCTRL.bit.BEATSIZE + 1) * (1 << desc->BTCTRL.bit.STEPSIZE
-        * (desc->BTCTRL.bit.STEPSEL == DMAC_BTCTRL_STEPSEL_DST_Val));
-      desc->DSTADDR.bit.DSTADDR = baseAddr + desc->BTCNT.bit.BTCNT
-        * (desc->BTCTRL.bit.BEATSIZE + 1) * (1 << desc->BTCTRL.bit.STEPSIZE
-        * (desc->BTCTRL.bit.STEPSEL == DMAC_BTCTRL_STEPSEL_DST_Val));
-    }
-    return desc->BTCNT.bit.BTCNT == value;
+    if (!desc || value < 0 || value > DMA_MAX_BTCNT) {
+      return false;
+    }
+    const uintptr_t srcBase = desc->SRCADDR.reg 
+      ? desc->SRCADDR.reg - blockOffset(desc, true) : 0;
+    const uintptr_t dstBase = desc->DSTADDR.reg 
+      ? desc->DSTADDR.reg - blockOffset(desc, false) : 0;
+    desc->BTCNT.reg = value;
+    desc->SRCADDR.reg = srcBase ? srcBase + blockOffset(desc, true) : 0;
+    desc->DSTADDR.reg = dstBase ? dstBase + blockOffset(desc, false) : 0;
+    return true;
   }
   int taskDescriptor::getLength() const {
     return desc->BTCNT.bit.BTCNT;
   }
 
   bool taskDescriptor::setSuspendChannel(const bool &value) {
+    if (!desc) {
+      return false;
+    }
     const int regVal = value ? DMAC_BTCTRL_BLOCKACT_SUSPEND_Val
       : DMAC_BTCTRL_BLOCKACT_NOACT_Val;
     desc->BTCTRL.bit.BLOCKACT = regVal;
@@ -681,7 +1341,11 @@ namespace dma {
   }
 
   void taskDescriptor::reset() {
-    memset(&desc, 0, sizeof(DmacDescriptor));
+    if (desc) {
+      uint32_t descAddr = desc->DESCADDR.reg;
+      memset((void*)desc, 0, sizeof(DmacDescriptor));
+      desc->DESCADDR.reg = descAddr;
+    }
     info.srcAlign = -1;
     info.destAlign = -1;
   }
@@ -694,15 +1358,1427 @@ namespace dma {
 
   taskDescriptor::~taskDescriptor() {
     if (info.assignedCh != -1) {
-      ch::removeTask(ch::indexOf(*this, info.assignedCh), info.assignedCh);
+      int taskIndex = ch::indexOf(*this, info.assignedCh);
+      if (taskIndex != -1) {
+        ch::removeTask(taskIndex, info.assignedCh);
+      }
     }
     if (info.alloc) {
-      delete desc;
+      releaseDesc(desc);
     }
   }
 
-}
 
-*/
+  multiBuffer::multiBuffer() {
+    callback = nullptr;
+    bufferBase = nullptr;
+    bufferBytes = 0;
+    bufferCount = 0;
+    beatSize = 0;
+    channel = -1;
+    nextBuffer = 0;
+    overrun = false;
+  }
+
+  bool multiBuffer::setBuffers_(const void *source, void *buffers,
+    const int &beatSize, const int &beats, const int &count) {
+    if (channel != -1 || !source || !buffers || beats <= 0) {
+      return false;
+    }
+    const uint32_t btctrl = DMAC_BTCTRL_VALID | DMAC_BTCTRL_DSTINC
+      | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_INT_Val)
+      | DMAC_BTCTRL_BEATSIZE(beatSize == 4 ? DMAC_BTCTRL_BEATSIZE_WORD_Val
+        : (beatSize == 2 ? DMAC_BTCTRL_BEATSIZE_HWORD_Val 
+        : DMAC_BTCTRL_BEATSIZE_BYTE_Val));
+
+    for (int i = 0; i < count; i++) {
+      DmacDescriptor *desc = (DmacDescriptor*)tasks[i];
+      if (!desc) {
+        return false;
+      }
+      desc->BTCTRL.reg = btctrl;
+      desc->BTCNT.reg = beats;
+      desc->SRCADDR.reg = (uintptr_t)source;
+      desc->DSTADDR.reg = (uintptr_t)buffers + (i + 1) * beats * beatSize;
+      desc->DESCADDR.reg = 0;
+    }
+    bufferBase = (uint8_t*)buffers;
+    bufferBytes = beats * beatSize;
+    bufferCount = count;
+    this->beatSize = beatSize;
+    return true;
+  }
+
+  bool multiBuffer::setCallback(bufferCallbackType value) {
+    callback = value;
+    return true;
+  }
+  bufferCallbackType multiBuffer::getCallback() const {
+    return callback;
+  }
+
+  // Builds the looped chain (one block per buffer, each raising TCMPL) on an 
+  // idle channel. Trigger source and transfer mode stay with channelCtrl.
+  bool multiBuffer::attach(const int &channelIndex) {
+    if (channel != -1 || !bufferCount || channelIndex < 0 
+      || channelIndex >= DMAC_CH_NUM || ::chBuffers[channelIndex] 
+      || DMAC->Channel[channelIndex].CHCTRLA.bit.ENABLE) {
+      return false;
+    }
+    ch::clearTasks(channelIndex);
+    for (int i = 0; i < bufferCount; i++) {
+      ((DmacDescriptor*)tasks[i])->BTCTRL.bit.VALID = 1;
+      if (!ch::addTask(i, tasks[i], channelIndex)) {
+        ch::clearTasks(channelIndex);
+        return false;
+      }
+    }
+    ch::setLooped(true, channelIndex);
+    nextBuffer = 0;
+    overrun = false;
+    channel = channelIndex;
+    ::chBuffers[channelIndex] = this;
+    DMAC->Channel[channelIndex].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL 
+      | DMAC_CHINTENSET_TERR | DMAC_CHINTENSET_SUSP;
+    return true;
+  }
+
+  bool multiBuffer::detach() {
+    if (channel == -1) {
+      return false;
+    }
+    ch::setState(STATE_DISABLED, channel);
+    DMAC->Channel[channel].CHINTENCLR.reg = DMAC_CHINTENCLR_SUSP;
+    ch::clearTasks(channel);
+    ::chBuffers[channel] = nullptr;
+    channel = -1;
+    return true;
+  }
+  int multiBuffer::getChannel() const {
+    return channel;
+  }
+
+  void *multiBuffer::getBuffer(const int &bufferIndex) const {
+    if (bufferIndex < 0 || bufferIndex >= bufferCount) {
+      return nullptr;
+    }
+    return bufferBase + bufferIndex * bufferBytes;
+  }
+  int multiBuffer::getBufferCount() const {
+    return bufferCount;
+  }
+  int multiBuffer::getBeatSize() const {
+    return beatSize;
+  }
+
+  // A buffer handed to the application has its descriptor invalidated, so a
+  // DMA that laps the consumer stops on a fetch error instead of overwriting
+  // it. Releasing the buffer re-validates it and resumes the stalled channel.
+  bool multiBuffer::release(const int &bufferIndex) {
+    if (channel == -1 || bufferIndex < 0 || bufferIndex >= bufferCount) {
+      return false;
+    }
+    ((DmacDescriptor*)tasks[bufferIndex])->BTCTRL.bit.VALID = 1;
+    if (DMAC->Channel[channel].CHSTATUS.bit.FERR) {
+      DMAC->Channel[channel].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_RESUME_Val;
+    }
+    return true;
+  }
+  bool multiBuffer::getOwned(const int &bufferIndex) {
+    if (bufferIndex < 0 || bufferIndex >= bufferCount) {
+      return false;
+    }
+    return !((DmacDescriptor*)tasks[bufferIndex])->BTCTRL.bit.VALID;
+  }
+
+  bool multiBuffer::getOverrun() const {
+    return overrun;
+  }
+  void multiBuffer::clearOverrun() {
+    overrun = false;
+  }
+
+  multiBuffer::~multiBuffer() {
+    detach();
+  }
+
+  void serviceBuffer_(multiBuffer *buffer, const uint8_t &flags) {
+    if ((flags & (DMAC_CHINTFLAG_TERR | DMAC_CHINTFLAG_SUSP))
+      && DMAC->Channel[buffer->channel].CHSTATUS.bit.FERR) {
+      buffer->overrun = true;
+    }
+    // The write-back descriptor holds the block in progress, or the block 
+    // that just completed if the next one has not been fetched yet.
+    const DmacDescriptor &wb = wbDescArray[buffer->channel];
+    int current = ((int)wb.DSTADDR.reg - (int)(uintptr_t)buffer->bufferBase)
+      / buffer->bufferBytes - 1;
+    if (current < 0 || current >= buffer->bufferCount) {
+      return;
+    }
+    int stop = wb.BTCNT.reg ? current : (current + 1) % buffer->bufferCount;
+
+    for (int i = 0; i < buffer->bufferCount && buffer->nextBuffer != stop; i++) {
+      DmacDescriptor *desc = (DmacDescriptor*)buffer->tasks[buffer->nextBuffer];
+      if (!desc->BTCTRL.bit.VALID) {
+        break;
+      }
+      desc->BTCTRL.bit.VALID = 0;
+      if (buffer->callback) {
+        buffer->callback(buffer->channel, buffer->nextBuffer, 
+          buffer->getBuffer(buffer->nextBuffer));
+      }
+      buffer->nextBuffer = (buffer->nextBuffer + 1) % buffer->bufferCount;
+    }
+  }
+
+  wavePlayer::wavePlayer() {
+    standby = nullptr;
+    dst = nullptr;
+    table = nullptr;
+    pending = nullptr;
+    beatSize = 0;
+    channel = -1;
+    swapping = false;
+  }
+
+  // Trigger source and transfer mode stay with channelCtrl, the standby 
+  // descriptor holds the next table while a swap is in flight. It is taken
+  // from the pool here and only returned by detach().
+  bool wavePlayer::attach(volatile void *dst, const int &channelIndex,
+    const int &beatSize) {
+    if (channel != -1 || !dst || channelIndex < 0 || channelIndex >= DMAC_CH_NUM
+      || (beatSize != 1 && beatSize != 2 && beatSize != 4)
+      || ((uintptr_t)dst & (beatSize - 1)) || ::chBuffers[channelIndex] 
+      || ::chWaves[channelIndex] || DMAC->Channel[channelIndex].CHCTRLA.bit.ENABLE) {
+      return false;
+    }
+    standby = acquireDesc();
+    if (!standby) {
+      return false;
+    }
+    ch::clearTasks(channelIndex);
+    this->dst = dst;
+    this->beatSize = beatSize;
+    table = nullptr;
+    pending = nullptr;
+    swapping = false;
+    channel = channelIndex;
+    ::chWaves[channelIndex] = this;
+    DMAC->Channel[channelIndex].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+    return true;
+  }
+
+  bool wavePlayer::detach() {
+    if (channel == -1) {
+      return false;
+    }
+    ch::setState(STATE_DISABLED, channel);
+    if (!transferCB && !::chCallbacks[channel].transfer) {
+      DMAC->Channel[channel].CHINTENCLR.reg = DMAC_CHINTENCLR_TCMPL;
+    }
+    memset((void*)&baseDescArray[channel], 0, sizeof(DmacDescriptor));
+    releaseDesc(standby);
+    standby = nullptr;
+    ::chWaves[channel] = nullptr;
+    channel = -1;
+    table = nullptr;
+    swapping = false;
+    return true;
+  }
+  int wavePlayer::getChannel() const {
+    return channel;
+  }
+
+  void wavePlayer::write_(DmacDescriptor *desc, const void *table, 
+    const int &length) {
+    desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC
+      | DMAC_BTCTRL_BEATSIZE(beatSize >> 1)
+      | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_INT_Val);
+    desc->BTCNT.reg = length;
+    desc->SRCADDR.reg = (uintptr_t)table + length * beatSize;
+    desc->DSTADDR.reg = (uintptr_t)dst;
+    desc->DESCADDR.reg = (uintptr_t)desc;
+  }
+
+  // The first table loops on the base descriptor. Later tables loop on the
+  // standby descriptor and the base is pointed at it, the DMA only follows
+  // that link once the current period ends. One swap can be in flight.
+  bool wavePlayer::play(const void *table, const int &length) {
+    if (channel == -1 || swapping || !table || length < 1 
+      || length > DMA_MAX_BTCNT || ((uintptr_t)table & (beatSize - 1))) {
+      return false;
+    }
+    DmacDescriptor *base = &baseDescArray[channel];
+    if (!this->table) {
+      write_(base, table, length);
+      this->table = table;
+      if (ch::getPeripheral(channel) == LINK_NONE) {
+        return ch::setState(STATE_ACTIVE, channel);
+      }
+      return ch::setState(STATE_IDLE, channel);
+    }
+    write_(standby, table, length);
+    pending = table;
+    swapping = true;
+    base->DESCADDR.reg = (uintptr_t)standby;
+    return true;
+  }
+  bool wavePlayer::getPending() const {
+    return swapping;
+  }
+  const void *wavePlayer::getTable() const {
+    return table;
+  }
+
+  wavePlayer::~wavePlayer() {
+    detach();
+  }
+
+  // Once the running block links to the standby, nothing will fetch the 
+  // base again until it is relinked, so it is rewritten with the new table
+  // and the standby hands over to it. The standby can take the next table
+  // once the base is the next block, it stays with the player until 
+  // detach(). The write-back DESCADDR always names the block fetched next,
+  // even when read before that fetch lands.
+  void serviceWave_(wavePlayer *player, const uint8_t &flags) {
+    if (!player->swapping || !(flags & DMAC_CHINTFLAG_TCMPL)) {
+      return;
+    }
+    DmacDescriptor *base = &baseDescArray[player->channel];
+    const uint32_t next = wbDescArray[player->channel].DESCADDR.reg;
+    if (!player->pending) {
+      player->swapping = next != (uintptr_t)base;
+      return;
+    }
+    if (next != (uintptr_t)player->standby) {
+      return;
+    }
+    memcpy((void*)base, (const void*)player->standby, sizeof(DmacDescriptor));
+    base->DESCADDR.reg = (uintptr_t)base;
+    player->standby->DESCADDR.reg = (uintptr_t)base;
+    player->table = player->pending;
+    player->pending = nullptr;
+  }
+
+  ringBufferBase::ringBufferBase(void *data, const int &beatSize, 
+    const int &length) {
+    this->data = (uint8_t*)data;
+    this->beatSize = beatSize;
+    this->length = length;
+    channel = -1;
+    readIndex = 0;
+    writeIndex = 0;
+    overrun = false;
+  }
+
+  // A single descriptor looped onto itself, with no block interrupt: the
+  // consumer derives the producer index from the channel's BTCNT instead.
+  bool ringBufferBase::attach_(const void *source, const int &channelIndex) {
+    if (channel != -1 || !source || channelIndex < 0 
+      || channelIndex >= DMAC_CH_NUM 
+      || DMAC->Channel[channelIndex].CHCTRLA.bit.ENABLE) {
+      return false;
+    }
+    DmacDescriptor *desc = (DmacDescriptor*)task;
+    if (!desc) {
+      return false;
+    }
+    desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_DSTINC
+      | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_NOACT_Val)
+      | DMAC_BTCTRL_BEATSIZE(beatSize == 4 ? DMAC_BTCTRL_BEATSIZE_WORD_Val
+        : (beatSize == 2 ? DMAC_BTCTRL_BEATSIZE_HWORD_Val 
+        : DMAC_BTCTRL_BEATSIZE_BYTE_Val));
+    desc->BTCNT.reg = length;
+    desc->SRCADDR.reg = (uintptr_t)source;
+    desc->DSTADDR.reg = (uintptr_t)data + length * beatSize;
+    desc->DESCADDR.reg = 0;
+
+    ch::clearTasks(channelIndex);
+    if (!ch::addTask(0, task, channelIndex)) {
+      return false;
+    }
+    ch::setLooped(true, channelIndex);
+    DMAC->Channel[channelIndex].CHINTENCLR.reg = DMAC_CHINTENCLR_TCMPL
+      | DMAC_CHINTENCLR_SUSP;
+    readIndex = 0;
+    writeIndex = 0;
+    overrun = false;
+    channel = channelIndex;
+    return true;
+  }
+
+  bool ringBufferBase::detach() {
+    if (channel == -1) {
+      return false;
+    }
+    ch::setState(STATE_DISABLED, channel);
+    ch::clearTasks(channel);
+    channel = -1;
+    return true;
+  }
+  int ringBufferBase::getChannel() const {
+    return channel;
+  }
+
+  // ACTIVE holds the live count while the channel owns the bus, otherwise 
+  // the write-back descriptor is current. A stale read only lags behind.
+  int ringBufferBase::getWriteIndex_() {
+    const uint32_t active = DMAC->ACTIVE.reg;
+    int remaining = 0;
+    if ((active & DMAC_ACTIVE_ABUSY) && (int)((active & DMAC_ACTIVE_ID_Msk)
+      >> DMAC_ACTIVE_ID_Pos) == channel) {
+      remaining = (active & DMAC_ACTIVE_BTCNT_Msk) >> DMAC_ACTIVE_BTCNT_Pos;
+    } else {
+      const DmacDescriptor &wb = wbDescArray[channel];
+      if (wb.DSTADDR.reg != (uintptr_t)data + length * beatSize) {
+        return 0;
+      }
+      remaining = wb.BTCNT.reg;
+    }
+    return (length - remaining) % length;
+  }
+
+  // The producer index only moves forward, so the writer has overtaken the 
+  // reader when the newly written span reaches the read index. This holds as 
+  // long as the consumer polls at least once per lap, there is no lap count
+  // to go by: a span of a whole lap reads as nothing written. On overrun the
+  // unread data is discarded, since it can no longer be trusted.
+  int ringBufferBase::update_() {
+    if (channel == -1) {
+      return 0;
+    }
+    const int write = getWriteIndex_();
+    const int available = (writeIndex - readIndex + length) % length;
+    const int written = (write - writeIndex + length) % length;
+    if (available + written >= length) {
+      overrun = true;
+      readIndex = write;
+    }
+    writeIndex = write;
+    __DMB();
+    return (writeIndex - readIndex + length) % length;
+  }
+
+  int ringBufferBase::getAvailable() {
+    return update_();
+  }
+
+  const void *ringBufferBase::getSpan_(int &count) {
+    update_();
+    count = writeIndex >= readIndex ? writeIndex - readIndex 
+      : length - readIndex;
+    return data + readIndex * beatSize;
+  }
+
+  bool ringBufferBase::consume(const int &count) {
+    const int available = (writeIndex - readIndex + length) % length;
+    if (count < 0 || count > available) {
+      return false;
+    }
+    readIndex = (readIndex + count) % length;
+    return true;
+  }
+
+  bool ringBufferBase::getOverrun() const {
+    return overrun;
+  }
+  void ringBufferBase::clearOverrun() {
+    overrun = false;
+  }
+
+  ringBufferBase::~ringBufferBase() {
+    detach();
+  }
+
+  taskQueue::taskQueue() {
+    head = nullptr;
+    tail = nullptr;
+    channel = -1;
+    count = 0;
+  }
+
+  // The base descriptor starts out as the fence, so the channel parks on a
+  // fetch error until the first push. The chain is tracked as a span chain
+  // so clearTasks() returns every queued descriptor to the pool.
+  bool taskQueue::attach(const int &channelIndex) {
+    if (channel != -1 || channelIndex < 0 || channelIndex >= DMAC_CH_NUM
+      || DMAC->Channel[channelIndex].CHCTRLA.bit.ENABLE
+      || ::chWatch[channelIndex].enabled) {
+      return false;
+    }
+    ch::clearTasks(channelIndex);
+    ::chQueues[channelIndex] = this;
+    memset((void*)&baseDescArray[channelIndex], 0, sizeof(DmacDescriptor));
+    ::chainArray[channelIndex].spanned = true;
+    head = &baseDescArray[channelIndex];
+    tail = head;
+    count = 0;
+    channel = channelIndex;
+    return ch::setState(STATE_IDLE, channel);
+  }
+
+  bool taskQueue::detach() {
+    if (channel == -1) {
+      return false;
+    }
+    ch::setState(STATE_DISABLED, channel);
+    ch::clearTasks(channel);
+    ::chQueues[channel] = nullptr;
+    head = nullptr;
+    tail = nullptr;
+    count = 0;
+    channel = -1;
+    return true;
+  }
+  int taskQueue::getChannel() const {
+    return channel;
+  }
+
+  // The fence is turned into the new task in place and a fresh fence is
+  // linked behind it. Word 0 (BTCTRL/BTCNT) is written last, and since the
+  // DMAC reads it first a fetch sees either the old fence or the whole task.
+  bool taskQueue::push(taskDescriptor &task) {
+    const DmacDescriptor *src = (DmacDescriptor*)task;
+    if (channel == -1 || !src || !src->BTCNT.reg) {
+      return false;
+    }
+    reclaim_();
+    DmacDescriptor *fence = acquireDesc();
+    if (!fence) {
+      return false;
+    }
+    tail->SRCADDR.reg = src->SRCADDR.reg;
+    tail->DSTADDR.reg = src->DSTADDR.reg;
+    tail->DESCADDR.reg = (uintptr_t)fence;
+    __DMB();
+    *(volatile uint32_t*)tail = (src->BTCTRL.reg | DMAC_BTCTRL_VALID)
+      | ((uint32_t)src->BTCNT.reg << 16);
+    __DMB();
+    tail = fence;
+    count++;
+    return poll();
+  }
+
+  // Recovers from the race where the DMAC fetched the old fence before it
+  // became valid: the channel parked on a fetch error and is resumed, which
+  // refetches the (now valid) descriptor. A software triggered channel that
+  // has not fetched anything yet is neither busy, pending nor faulted and
+  // only needs its first trigger. Call periodically if a push may have 
+  // checked just before the error was flagged.
+  bool taskQueue::poll() {
+    if (channel == -1) {
+      return false;
+    }
+    if (head == tail) {
+      return true;
+    }
+    const bool swTrig = DMAC->Channel[channel].CHCTRLA.bit.TRIGSRC == LINK_NONE;
+    const uint8_t status = DMAC->Channel[channel].CHSTATUS.reg;
+    if (status & DMAC_CHSTATUS_FERR) {
+      DMAC->Channel[channel].CHINTFLAG.reg = DMAC_CHINTFLAG_SUSP;
+      DMAC->Channel[channel].CHCTRLB.bit.CMD = DMAC_CHCTRLB_CMD_RESUME_Val;
+      if (swTrig) {
+        DMAC->SWTRIGCTRL.reg |= 1UL << channel;
+      }
+    } else if (swTrig && !(status & (DMAC_CHSTATUS_BUSY | DMAC_CHSTATUS_PEND))
+      && DMAC->Channel[channel].CHCTRLA.bit.ENABLE) {
+      DMAC->SWTRIGCTRL.reg |= 1UL << channel;
+    }
+    return true;
+  }
+
+  // The current block is the one whose link matches the write-back copy,
+  // everything ahead of it has completed. A channel parked on a fetch error
+  // holds the fence in its write-back copy, the fence it read is the tail
+  // or (if a push raced the fetch) the block before it, so everything ahead
+  // of that block has completed. Nothing is released if the write-back copy
+  // does not belong to the queue yet. The base descriptor is relinked to
+  // the new head so clearTasks() never walks freed ones.
+  void taskQueue::reclaim_() {
+    uint32_t wbNext = wbDescArray[channel].DESCADDR.reg;
+    if (!wbNext) {
+      if (!DMAC->Channel[channel].CHSTATUS.bit.FERR) {
+        return;
+      }
+      wbNext = (uintptr_t)tail;
+    }
+    DmacDescriptor *current = head;
+    while(current != tail && current->DESCADDR.reg != wbNext) {
+      current = (DmacDescriptor*)(uintptr_t)current->DESCADDR.reg;
+    }
+    if (current == tail) {
+      return;
+    }
+    while(head != current) {
+      DmacDescriptor *next = (DmacDescriptor*)(uintptr_t)head->DESCADDR.reg;
+      releaseDesc(head);
+      head = next;
+      count--;
+    }
+    if (head != &baseDescArray[channel]) {
+      baseDescArray[channel].DESCADDR.reg = (uintptr_t)head;
+    }
+  }
+
+  int taskQueue::getPending() {
+    if (channel == -1) {
+      return 0;
+    }
+    reclaim_();
+    return count;
+  }
+
+  taskQueue::~taskQueue() {
+    detach();
+  }
+
+  // High priority requests take the lowest free channel numbers, which
+  // win static arbitration within a level, low priority ones the highest.
+  int allocCtrl::allocate(const int &prilvl, const bool &runStandby, 
+    const char *owner) {
+    if (prilvl < 0 || prilvl >= DMA_PRILVL_COUNT) {
+      return -1;
+    }
+    int index;
+    {
+      irqLock lock;
+      const uint32_t freeMask = ~::allocMask;
+      if (!freeMask) {
+        return -1;
+      }
+      index = prilvl >= DMA_PRILVL_COUNT / 2 ? __builtin_ctz(freeMask)
+        : 31 - __builtin_clz(freeMask);
+      ::allocMask |= 1UL << index;
+      ::allocOwners[index] = owner;
+    }
+    ch::setInit(true, index);
+    DMAC->Channel[index].CHPRILVL.bit.PRILVL = prilvl;
+    DMAC->Channel[index].CHCTRLA.bit.RUNSTDBY = runStandby;
+    DMAC->CTRL.reg |= 1UL << (DMAC_CTRL_LVLEN0_Pos + prilvl);
+    return index;
+  }
+
+  bool allocCtrl::reserve(const int &index, const char *owner) {
+    if (index < 0 || index >= DMAC_CH_NUM) {
+      return false;
+    }
+    irqLock lock;
+    if (::allocMask & (1UL << index)) {
+      return false;
+    }
+    ::allocMask |= 1UL << index;
+    ::allocOwners[index] = owner;
+    return true;
+  }
+
+  bool allocCtrl::release(const int &index) {
+    if (index < 0 || index >= DMAC_CH_NUM || !(::allocMask & (1UL << index))) {
+      return false;
+    }
+    ch::clearTasks(index);
+    ch::setTransferCallback(nullptr, nullptr, index);
+    ch::setErrorCallback(nullptr, nullptr, index);
+    ch::setInit(false, index);
+    irqLock lock;
+    ::allocMask &= ~(1UL << index);
+    ::allocOwners[index] = nullptr;
+    return true;
+  }
+
+  const char *allocCtrl::getOwner(const int &index) {
+    if (index < 0 || index >= DMAC_CH_NUM || !(::allocMask & (1UL << index))) {
+      return nullptr;
+    }
+    return ::allocOwners[index] ? ::allocOwners[index] : "";
+  }
+
+  uint32_t allocCtrl::getAllocated() {
+    return ::allocMask;
+  }
+
+  namespace ch {
+
+    // SWRST clears every channel register, so the configuration is carried
+    // over the reset. The chain itself is untouched in SRAM and restarts 
+    // from the base descriptor, the write-back copy is cleared with it.
+    bool restart_(const int &index) {
+      DmacChannel &channel = DMAC->Channel[index];
+      const uint32_t chctrla = channel.CHCTRLA.reg 
+        & ~(DMAC_CHCTRLA_ENABLE | DMAC_CHCTRLA_SWRST);
+      const uint8_t chprilvl = channel.CHPRILVL.reg;
+      const uint8_t chevctrl = channel.CHEVCTRL.reg;
+      const uint8_t chintenset = channel.CHINTENSET.reg;
+
+      channel.CHCTRLA.bit.ENABLE = 0;
+      while(channel.CHCTRLA.bit.ENABLE);
+      channel.CHCTRLA.bit.SWRST = 1;
+      while(channel.CHCTRLA.bit.SWRST);
+
+      channel.CHCTRLA.reg = chctrla;
+      channel.CHPRILVL.reg = chprilvl;
+      channel.CHEVCTRL.reg = chevctrl;
+      channel.CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+      channel.CHINTENSET.reg = chintenset;
+      memset((void*)&wbDescArray[index], 0, sizeof(DmacDescriptor));
+
+      if (!baseDescArray[index].BTCTRL.bit.VALID) {
+        return false;
+      }
+      if (getPeripheral(index) == LINK_NONE) {
+        return setState(STATE_ACTIVE, index);
+      }
+      return setState(STATE_IDLE, index);
+    }
+
+  }
+
+  bool watchdogCtrl::setEnabled(const int &index, const bool &enabled,
+    const int &stallTicks) {
+    if (index < 0 || index >= DMAC_CH_NUM || stallTicks < 1 
+      || stallTicks > UINT8_MAX || (enabled && ::chQueues[index])) {
+      return false;
+    }
+    watchData &watch = ::chWatch[index];
+    watch.enabled = false;
+    watch.faulted = false;
+    watch.ticks = 0;
+    watch.limit = stallTicks;
+    watch.btcnt = wbDescArray[index].BTCNT.reg;
+    watch.descAddr = wbDescArray[index].DESCADDR.reg;
+    watch.enabled = enabled;
+    return true;
+  }
+  bool watchdogCtrl::getEnabled(const int &index) {
+    return index >= 0 && index < DMAC_CH_NUM && ::chWatch[index].enabled;
+  }
+
+  // A channel owning the bus when sampled is moving, otherwise the 
+  // write-back BTCNT and DESCADDR are compared against the last sample.
+  int watchdogCtrl::service() {
+    int restarted = 0;
+    for (int i = 0; i < DMAC_CH_NUM; i++) {
+      watchData &watch = ::chWatch[i];
+      if (!watch.enabled || ::chBuffers[i] || ::chQueues[i]) {
+        continue;
+      }
+      bool stalled = watch.faulted || (DMAC->Channel[i].CHINTFLAG.bit.TERR
+        && !DMAC->Channel[i].CHSTATUS.bit.FERR);
+      if (!stalled) {
+        const uint32_t active = DMAC->ACTIVE.reg;
+        const bool moving = (active & DMAC_ACTIVE_ABUSY) && (int)((active 
+          & DMAC_ACTIVE_ID_Msk) >> DMAC_ACTIVE_ID_Pos) == i;
+        const uint32_t btcnt = wbDescArray[i].BTCNT.reg;
+        const uint32_t descAddr = wbDescArray[i].DESCADDR.reg;
+        if (moving || ch::getState(i) != STATE_ACTIVE || btcnt != watch.btcnt
+          || descAddr != watch.descAddr) {
+          watch.ticks = 0;
+        } else if (++watch.ticks >= watch.limit) {
+          stalled = true;
+        }
+        watch.btcnt = btcnt;
+        watch.descAddr = descAddr;
+      }
+      if (!stalled) {
+        continue;
+      }
+      watch.faulted = false;
+      watch.ticks = 0;
+      watch.restarts++;
+      ch::restart_(i);
+      watch.btcnt = wbDescArray[i].BTCNT.reg;
+      watch.descAddr = wbDescArray[i].DESCADDR.reg;
+      restarted++;
+
+      #if DMA_STATS_ENABLED
+        ::chStats[i].errors[ERROR_STALL]++;
+      #endif
+      const callbackData &cb = ::chCallbacks[i];
+      if (cb.error) {
+        cb.error(i, ERROR_STALL, cb.errorCtx);
+      } else if (errorCB) {
+        errorCB(i, ERROR_STALL);
+      }
+    }
+    return restarted;
+  }
+
+  uint32_t watchdogCtrl::getRestarts(const int &index) {
+    if (index < 0 || index >= DMAC_CH_NUM) {
+      return 0;
+    }
+    return ::chWatch[index].restarts;
+  }
+
+  namespace mem {
+
+    struct part_ {
+      uintptr_t src;
+      uintptr_t dst;
+      size_t bytes;
+      int beatSize;
+    };
+
+    // Widest beat both addresses can share once the destination is aligned.
+    int alignOf_(const uintptr_t &src, const uintptr_t &dst) {
+      for (int i = sizeof(BURSTLEN_REF) / sizeof(BURSTLEN_REF[0]) - 1; i > 0; i--) {
+        if (!((src ^ dst) & (BURSTLEN_REF[i] - 1))) {
+          return BURSTLEN_REF[i];
+        }
+      }
+      return 1;
+    }
+
+    // Splits a copy into a byte-wide head up to the shared alignment, a body
+    // of the widest beats (chunked to BTCNT) and a byte-wide tail. Returns
+    // -1 past DMA_MEMCPY_TASKS parts, so at most DMA_MEMCPY_TASKS * 65535
+    // beats: 1 MB for a word-aligned copy, 256 KB for byte beats, and two
+    // parts fewer when a head and tail are needed.
+    int split_(part_ *parts, const uintptr_t &src, const uintptr_t &dst,
+      const size_t &bytes, const bool &srcInc) {
+      const int beatSize = srcInc ? alignOf_(src, dst) : alignOf_(dst, dst);
+      size_t head = (beatSize - (dst & (beatSize - 1))) & (beatSize - 1);
+      head = head > bytes ? bytes : head;
+      size_t offset = 0;
+      int count = 0;
+
+      auto addPart = [&](const size_t &partBytes, const int &partBeat) -> bool {
+        if (count >= DMA_MEMCPY_TASKS) {
+          return false;
+        }
+        parts[count++] = { srcInc ? src + offset : src, dst + offset, 
+          partBytes, partBeat };
+        offset += partBytes;
+        return true;
+      };
+      if (head && !addPart(head, 1)) {
+        return -1;
+      }
+      size_t body = (bytes - head) / beatSize * beatSize;
+      while(body) {
+        const size_t chunk = body < (size_t)DMA_MAX_BTCNT * beatSize ? body 
+          : (size_t)DMA_MAX_BTCNT * beatSize;
+        if (!addPart(chunk, beatSize)) {
+          return -1;
+        }
+        body -= chunk;
+      }
+      if (bytes > offset && !addPart(bytes - offset, 1)) {
+        return -1;
+      }
+      return count;
+    }
+
+    void setPart_(DmacDescriptor *desc, const part_ &part, const bool &srcInc) {
+      desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_DSTINC
+        | (srcInc ? DMAC_BTCTRL_SRCINC : 0)
+        | DMAC_BTCTRL_BEATSIZE(part.beatSize >> 1)
+        | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_NOACT_Val);
+      desc->BTCNT.reg = part.bytes / part.beatSize;
+      desc->SRCADDR.reg = srcInc ? part.src + part.bytes : part.src;
+      desc->DSTADDR.reg = part.dst + part.bytes;
+      desc->DESCADDR.reg = 0;
+    }
+
+    void onTransfer_(int, void *context) {
+      memChannelData *data = (memChannelData*)context;
+      data->completed = data->submitted;
+    }
+
+    void onError_(int, CHANNEL_ERROR, void *context) {
+      memChannelData *data = (memChannelData*)context;
+      data->failed = data->submitted;
+      data->completed = data->submitted;
+    }
+
+    // Claims an idle channel from the memory pool, -1 if all are busy.
+    int claimChannel_() {
+      irqLock lock;
+      for (int i = 0; i < DMA_MEMCPY_CH_COUNT; i++) {
+        memChannelData &data = ::memChannels[i];
+        if (data.submitted != data.completed) {
+          continue;
+        }
+        if (!data.init) {
+          const int index = allocCtrl::allocate(0, false, "memcpy");
+          if (index == -1) {
+            return -1;
+          }
+          data.channel = index;
+          ch::setPeripheral(LINK_NONE, index);
+          ch::setTransferMode(MODE_TRANSFER_ALL, index);
+          ch::setTransferCallback(onTransfer_, &data, index);
+          ch::setErrorCallback(onError_, &data, index);
+          data.init = true;
+        }
+        data.submitted++;
+        return i;
+      }
+      return -1;
+    }
+
+    bool submit_(const int &memIndex, const part_ *parts, const int &count,
+      const bool &srcInc) {
+      const int index = ::memChannels[memIndex].channel;
+      ch::clearTasks(index);
+      for (int i = 0; i < count; i++) {
+        DmacDescriptor *desc = (DmacDescriptor*)::memTasks[memIndex][i];
+        if (!desc) {
+          return false;
+        }
+        setPart_(desc, parts[i], srcInc);
+        if (i == count - 1) {
+          desc->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+        }
+        if (!ch::insertTask_(i, ::memTasks[memIndex][i], index)) {
+          return false;
+        }
+      }
+      return ch::setState(STATE_ACTIVE, index);
+    }
+
+    transferToken start_(void *dst, const uintptr_t &src, const size_t &bytes,
+      const bool &srcInc, const uint32_t &fill) {
+      part_ parts[DMA_MEMCPY_TASKS];
+      int count = -1;
+      int memIndex = -1;
+      if (bytes >= DMA_MEMCPY_MIN_BYTES) {
+        count = split_(parts, srcInc ? src : (uintptr_t)&::memChannels[0].fill,
+          (uintptr_t)dst, bytes, srcInc);
+      }
+      if (count > 0) {
+        memIndex = claimChannel_();
+      }
+      if (memIndex != -1) {
+        memChannelData &data = ::memChannels[memIndex];
+        if (!srcInc) {
+          data.fill = fill;
+          for (int i = 0; i < count; i++) {
+            parts[i].src = (uintptr_t)&data.fill;
+          }
+        }
+        if (submit_(memIndex, parts, count, srcInc)) {
+          return transferToken(memIndex, 
+            (uint32_t)data.submitted);
+        }
+        data.completed = data.submitted;
+      }
+      if (srcInc) {
+        memcpy(dst, (const void*)src, bytes);
+      } else {
+        memset(dst, fill & 0xFF, bytes);
+      }
+      return transferToken();
+    }
+
+  }
+
+  transferToken::transferToken() {
+    slot = -1;
+    sequence = 0;
+  }
+  transferToken::transferToken(const int &slot, const uint32_t &sequence) {
+    this->slot = slot;
+    this->sequence = sequence;
+  }
 
+  bool transferToken::getDone() const {
+    if (slot == -1) {
+      return true;
+    }
+    return (int32_t)(::memChannels[slot].completed - sequence) >= 0;
+  }
+  bool transferToken::getError() const {
+    if (slot == -1) {
+      return false;
+    }
+    return ::memChannels[slot].failed == sequence;
+  }
+  bool transferToken::wait() const {
+    while(!getDone());
+    return !getError();
+  }
+  int transferToken::getChannel() const {
+    return slot == -1 ? -1 : ::memChannels[slot].channel;
+  }
+
+  // Copies below DMA_MEMCPY_MIN_BYTES, longer than split_ can describe in
+  // DMA_MEMCPY_TASKS blocks, or issued while every memory channel is busy,
+  // run on the CPU and return an already completed token; getChannel() is
+  // -1 for those.
+  transferToken memcpy_async(void *dst, const void *src, const size_t &n) {
+    if (!dst || !src || !n) {
+      return transferToken();
+    }
+    return mem::start_(dst, (uintptr_t)src, n, true, 0);
+  }
+
+  transferToken memset_async(void *dst, const int &value, const size_t &n) {
+    if (!dst || !n) {
+      return transferToken();
+    }
+    return mem::start_(dst, 0, n, false, (uint8_t)value * 0x01010101UL);
+  }
+
+  namespace iov {
+
+    // A software triggered chain runs as one transaction, a peripheral
+    // triggered one is left waiting for its triggers.
+    bool start_(const int &index) {
+      if (ch::getPeripheral(index) != LINK_NONE) {
+        return ch::setState(STATE_IDLE, index);
+      }
+      if (ch::getTransferMode(index) != MODE_TRANSFER_ALL) {
+        ch::setState(STATE_DISABLED, index);
+        ch::setTransferMode(MODE_TRANSFER_ALL, index);
+      }
+      return ch::setState(STATE_ACTIVE, index);
+    }
+
+    // Builds the span chain in a single pass, the first span lands in the
+    // channel's base descriptor and the rest are drawn from the pool.
+    bool build_(volatile void *periph, std::initializer_list<ioSpan> spans,
+      const int &index, const int &beatSize, const bool &toPeriph) {
+      if (!periph || index < 0 || index >= DMAC_CH_NUM 
+        || (beatSize != 1 && beatSize != 2 && beatSize != 4)
+        || ((uintptr_t)periph & (beatSize - 1))
+        || ch::getState(index) == STATE_ACTIVE) {
+        return false;
+      }
+      for (const ioSpan &span : spans) {
+        if (!span.data || (((uintptr_t)span.data | span.length) & (beatSize - 1))
+          || span.length / beatSize > DMA_MAX_BTCNT) {
+          return false;
+        }
+      }
+      ch::clearTasks(index);
+
+      DmacDescriptor *prev = nullptr;
+      for (const ioSpan &span : spans) {
+        if (!span.length) {
+          continue;
+        }
+        DmacDescriptor *desc = prev ? acquireDesc() : &baseDescArray[index];
+        if (!desc) {
+          ::chainArray[index].spanned = true;
+          ch::clearTasks(index);
+          return false;
+        }
+        const uintptr_t mem = (uintptr_t)span.data + span.length;
+        desc->BTCTRL.reg = DMAC_BTCTRL_VALID
+          | (toPeriph ? DMAC_BTCTRL_SRCINC : DMAC_BTCTRL_DSTINC)
+          | DMAC_BTCTRL_BEATSIZE(beatSize >> 1)
+          | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_NOACT_Val);
+        desc->BTCNT.reg = span.length / beatSize;
+        desc->SRCADDR.reg = toPeriph ? mem : (uintptr_t)periph;
+        desc->DSTADDR.reg = toPeriph ? (uintptr_t)periph : mem;
+        desc->DESCADDR.reg = 0;
+        if (prev) {
+          prev->DESCADDR.reg = (uintptr_t)desc;
+        }
+        prev = desc;
+      }
+      if (!prev) {
+        return false;
+      }
+      prev->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+      ::chainArray[index].spanned = true;
+      return start_(index);
+    }
+
+    int stepSize_(const int &stride) {
+      if (stride < 1 || stride > 128 || (stride & (stride - 1))) {
+        return -1;
+      }
+      return __builtin_ctz(stride);
+    }
+
+  }
+
+  bool gather(volatile void *dst, std::initializer_list<ioSpan> spans,
+    const int &index, const int &beatSize) {
+    return iov::build_(dst, spans, index, beatSize, true);
+  }
+
+  bool scatter(const volatile void *src, std::initializer_list<ioSpan> spans,
+    const int &index, const int &beatSize) {
+    return iov::build_(const_cast<volatile void*>(src), spans, index, 
+      beatSize, false);
+  }
 
+  // Plane c starts at beat c of an interleaved source or at sample block c
+  // of a planar one, the block ends past the last stepped beat on the 
+  // stepping side.
+  bool deinterleave(const void *src, void *const planes[], const int &channels,
+    const int &samples, const int &index, const int &beatSize, 
+    const int &srcStride, const int &dstStride) {
+    const int srcStep = iov::stepSize_(srcStride ? srcStride 
+      : (dstStride == 1 ? channels : 1));
+    const int dstStep = iov::stepSize_(dstStride);
+    if (!src || !planes || channels < 1 || channels > DMA_DESC_POOL_SIZE + 1
+      || samples < 1 || samples > DMA_MAX_BTCNT || index < 0 
+      || index >= DMAC_CH_NUM || (beatSize != 1 && beatSize != 2 && beatSize != 4)
+      || ((uintptr_t)src & (beatSize - 1)) || srcStep < 0 || dstStep < 0 
+      || (srcStep && dstStep) || ch::getState(index) == STATE_ACTIVE) {
+      return false;
+    }
+    for (int i = 0; i < channels; i++) {
+      if (!planes[i] || ((uintptr_t)planes[i] & (beatSize - 1))) {
+        return false;
+      }
+    }
+    ch::clearTasks(index);
+
+    const uint16_t btctrl = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC 
+      | DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BEATSIZE(beatSize >> 1)
+      | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_NOACT_Val)
+      | (srcStep ? DMAC_BTCTRL_STEPSEL : 0)
+      | DMAC_BTCTRL_STEPSIZE(srcStep ? srcStep : dstStep);
+    const uint32_t srcBytes = (uint32_t)samples * beatSize << srcStep;
+    const uint32_t dstBytes = (uint32_t)samples * beatSize << dstStep;
+
+    DmacDescriptor *prev = nullptr;
+    for (int i = 0; i < channels; i++) {
+      DmacDescriptor *desc = prev ? acquireDesc() : &baseDescArray[index];
+      if (!desc) {
+        ::chainArray[index].spanned = true;
+        ch::clearTasks(index);
+        return false;
+      }
+      desc->BTCTRL.reg = btctrl;
+      desc->BTCNT.reg = samples;
+      desc->SRCADDR.reg = (uintptr_t)src + srcBytes + (srcStep 
+        ? i * beatSize : (uint32_t)i * samples * beatSize);
+      desc->DSTADDR.reg = (uintptr_t)planes[i] + dstBytes;
+      desc->DESCADDR.reg = 0;
+      if (prev) {
+        prev->DESCADDR.reg = (uintptr_t)desc;
+      }
+      prev = desc;
+    }
+    prev->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+    ::chainArray[index].spanned = true;
+    return iov::start_(index);
+  }
+
+  namespace crc {
+
+    uint32_t updateSoftware(const CRC_MODE &mode, const uint32_t &value,
+      const void *data, const size_t &length) {
+      const uint8_t *bytes = (const uint8_t*)data;
+      size_t remaining = length;
+
+      if (mode == CRC_TYPE_32) {
+        const auto &t = ::crc32Table.data;
+        uint32_t crc = value;
+        while(remaining >= 8) {
+          uint32_t lo, hi;
+          memcpy(&lo, bytes, 4);
+          memcpy(&hi, bytes + 4, 4);
+          lo ^= crc;
+          crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] 
+            ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+            ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] 
+            ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+          bytes += 8;
+          remaining -= 8;
+        }
+        while(remaining--) {
+          crc = (crc >> 8) ^ t[0][(crc ^ *bytes++) & 0xFF];
+        }
+        return crc;
+      }
+      const auto &t = ::crc16Table.data;
+      uint16_t crc = value;
+      while(remaining >= 8) {
+        crc = t[7][bytes[0] ^ (crc >> 8)] ^ t[6][bytes[1] ^ (crc & 0xFF)]
+          ^ t[5][bytes[2]] ^ t[4][bytes[3]] ^ t[3][bytes[4]] 
+          ^ t[2][bytes[5]] ^ t[1][bytes[6]] ^ t[0][bytes[7]];
+        bytes += 8;
+        remaining -= 8;
+      }
+      while(remaining--) {
+        crc = (uint16_t)(crc << 8) ^ t[0][((crc >> 8) ^ *bytes++) & 0xFF];
+      }
+      return crc;
+    }
+
+    #if DMA_CRC_HARDWARE_ENABLED
+      bool lock_() {
+        irqLock lock;
+        if (::crcLocked || DMAC->CRCCTRL.bit.CRCSRC 
+          != DMAC_CRCCTRL_CRCSRC_DISABLE_Val) {
+          return false;
+        }
+        ::crcLocked = true;
+        return true;
+      }
+
+      void unlock_() {
+        DMAC->CRCSTATUS.reg = DMAC_CRCSTATUS_CRCBUSY;
+        DMAC->CRCCTRL.reg = 0;
+        ::crcLocked = false;
+      }
+
+      // CRCCHKSUM holds the CRC16 running value as it is and the CRC32 one
+      // bit-reversed, which the datasheet puts as the checksum read being the
+      // bit-reversed complement of the IEEE 802.3 result. Its own inverse.
+      uint32_t convert_(const CRC_MODE &mode, uint32_t value) {
+        if (mode != CRC_TYPE_32) {
+          return value & 0xFFFF;
+        }
+        return __RBIT(value);
+      }
+
+      // Feeds the next chunk of at most one descriptor to CRCDATAIN in I/O
+      // mode, or hands the result over once the span is through.
+      void next_() {
+        crcJob &job = ::crcPending;
+        if (!job.remaining) {
+          job.state->value = convert_(job.state->mode, DMAC->CRCCHKSUM.reg);
+          unlock_();
+          if (job.callback) {
+            job.callback(*job.state, false, job.context);
+          }
+          return;
+        }
+        const size_t chunk = job.remaining < (size_t)DMA_MAX_BTCNT * job.beatSize
+          ? job.remaining : (size_t)DMA_MAX_BTCNT * job.beatSize;
+        const uint8_t *bytes = job.bytes;
+        job.bytes += chunk;
+        job.remaining -= chunk;
+        if (!gather(&DMAC->CRCDATAIN.reg, { ioSpan(bytes, chunk) }, 
+          ::crcChannel, job.beatSize)) {
+          unlock_();
+          if (job.callback) {
+            job.callback(*job.state, true, job.context);
+          }
+        }
+      }
+
+      void onTransfer_(int, void*) {
+        next_();
+      }
+
+      void onError_(int, CHANNEL_ERROR, void*) {
+        crcJob &job = ::crcPending;
+        ch::setState(STATE_DISABLED, ::crcChannel);
+        unlock_();
+        if (job.callback) {
+          job.callback(*job.state, true, job.context);
+        }
+      }
+
+      // Takes the CRC channel on first use, the engine must be locked. The
+      // callbacks are set each time as a channel reset drops the interrupt
+      // enables.
+      bool start_(crcState &state, const ioSpan &span, 
+        crcCallbackType callback, void *context) {
+        if (::crcChannel == -1) {
+          ::crcChannel = allocCtrl::allocate(0, false, "crc");
+          if (::crcChannel == -1) {
+            return false;
+          }
+        }
+        ch::setTransferCallback(onTransfer_, nullptr, ::crcChannel);
+        ch::setErrorCallback(onError_, nullptr, ::crcChannel);
+        const int beatSize = (((uintptr_t)span.data | span.length) & 3) ? 1 : 4;
+        ::crcPending = { &state, (const uint8_t*)span.data, span.length, 
+          beatSize, callback, context };
+        DMAC->CRCCTRL.reg = DMAC_CRCCTRL_CRCBEATSIZE(beatSize >> 1)
+          | DMAC_CRCCTRL_CRCPOLY(state.mode)
+          | DMAC_CRCCTRL_CRCSRC(DMAC_CRCCTRL_CRCSRC_IO_Val);
+        DMAC->CRCCHKSUM.reg = convert_(state.mode, state.value);
+        next_();
+        return true;
+      }
+
+      struct syncRun_ {
+        volatile bool done;
+        bool failed;
+      };
+
+      void onSyncDone_(crcState&, bool failed, void *context) {
+        syncRun_ *run = (syncRun_*)context;
+        run->failed = failed;
+        run->done = true;
+      }
+    #endif
+
+    crcState begin(const CRC_MODE &mode) {
+      return { mode, mode == CRC_TYPE_32 ? UINT32_C(0xFFFFFFFF) : UINT32_C(0xFFFF) };
+    }
+
+    // Short spans, or spans issued while the engine is in use, are done
+    // in software, both paths produce the same running value.
+    bool update(crcState &state, const ioSpan &span) {
+      if (!span.data && span.length) {
+        return false;
+      }
+      #if DMA_CRC_HARDWARE_ENABLED
+        // Waiting needs the CRC channel's interrupt, so not from a handler
+        // or with interrupts masked.
+        if (span.length >= DMA_CRC_MIN_BYTES && !__get_PRIMASK() 
+          && !__get_IPSR() && lock_()) {
+          const uint32_t prev = state.value;
+          syncRun_ run = { false, false };
+          if (!start_(state, span, onSyncDone_, &run)) {
+            unlock_();
+            run = { true, true };
+          }
+          while(!run.done);
+          if (!run.failed) {
+            return true;
+          }
+          state.value = prev;
+        }
+      #endif
+      state.value = updateSoftware(state.mode, state.value, span.data, 
+        span.length);
+      return true;
+    }
+
+    bool update_async(crcState &state, const ioSpan &span, 
+      crcCallbackType callback, void *context) {
+      if (!span.data && span.length) {
+        return false;
+      }
+      #if DMA_CRC_HARDWARE_ENABLED
+        if (span.length >= DMA_CRC_MIN_BYTES && lock_()) {
+          if (start_(state, span, callback, context)) {
+            return true;
+          }
+          unlock_();
+        }
+      #endif
+      state.value = updateSoftware(state.mode, state.value, span.data, 
+        span.length);
+      if (callback) {
+        callback(state, false, context);
+      }
+      return true;
+    }
+
+    bool getBusy() {
+      return ::crcLocked;
+    }
+
+    uint32_t finish(const crcState &state) {
+      return state.mode == CRC_TYPE_32 ? ~state.value : state.value & 0xFFFF;
+    }
+
+    uint32_t compute(const ioSpan &span, const CRC_MODE &mode) {
+      crcState state = begin(mode);
+      update(state, span);
+      return finish(state);
+    }
+
+    bool attach(const int &index, const CRC_MODE &mode) {
+      #if DMA_CRC_HARDWARE_ENABLED
+        if (index < 0 || index >= DMAC_CH_NUM || !lock_()) {
+          return false;
+        }
+        DMAC->CRCCTRL.reg = DMAC_CRCCTRL_CRCBEATSIZE(baseDescArray[index]
+            .BTCTRL.bit.BEATSIZE)
+          | DMAC_CRCCTRL_CRCPOLY(mode)
+          | DMAC_CRCCTRL_CRCSRC(index + 32);
+        DMAC->CRCCHKSUM.reg = convert_(mode, begin(mode).value);
+        return true;
+      #else
+        return false;
+      #endif
+    }
+
+    uint32_t detach() {
+      #if DMA_CRC_HARDWARE_ENABLED
+        if (!::crcLocked || DMAC->CRCCTRL.bit.CRCSRC 
+          == DMAC_CRCCTRL_CRCSRC_IO_Val) {
+          return 0;
+        }
+        const CRC_MODE mode = static_cast<CRC_MODE>(DMAC->CRCCTRL.bit.CRCPOLY);
+        const uint32_t value = convert_(mode, DMAC->CRCCHKSUM.reg);
+        unlock_();
+        return finish({ mode, value });
+      #else
+        return 0;
+      #endif
+    }
+
+  }
+
+  // Per-channel callbacks take precedence over the global ones. The latency 
+  // (when enabled) spans handler entry to the first callback of the channel.
+  void serviceChannel_(const int &index, const uint32_t &entryTime) {
+    const uint8_t flags = DMAC->Channel[index].CHINTFLAG.reg
+      & DMAC->Channel[index].CHINTENSET.reg;
+    const CHANNEL_ERROR error = (flags & DMAC_CHINTFLAG_TERR) 
+      ? ch::getError(index) : ERROR_NONE;
+    DMAC->Channel[index].CHINTFLAG.reg = flags;
+
+    if (::chBuffers[index]) {
+      serviceBuffer_(::chBuffers[index], flags);
+    } else if (::chWaves[index]) {
+      serviceWave_(::chWaves[index], flags);
+    }
+    #if DMA_IRQ_LATENCY_ENABLED
+      const uint32_t latency = DWT->CYCCNT - entryTime;
+      ::irqLatency[index].last = latency;
+      if (latency > ::irqLatency[index].max) {
+        ::irqLatency[index].max = latency;
+      }
+    #else
+      (void)entryTime;
+    #endif
+    #if DMA_STATS_ENABLED
+      statsRecord_(index, flags, error);
+    #endif
+    if (::chPoll[index].enabled && (flags & (DMAC_CHINTFLAG_TCMPL 
+      | DMAC_CHINTFLAG_TERR))) {
+      ::chPoll[index].failed = flags & DMAC_CHINTFLAG_TERR;
+      ::chPoll[index].done = true;
+    }
+    if (::chWatch[index].enabled && error == ERROR_TRANSFER) {
+      ::chWatch[index].faulted = true;
+    }
+    const callbackData &cb = ::chCallbacks[index];
+    if (flags & DMAC_CHINTFLAG_TERR) {
+      if (cb.error) {
+        cb.error(index, error, cb.errorCtx);
+      } else if (errorCB) {
+        errorCB(index, error);
+      }
+    }
+    if (flags & DMAC_CHINTFLAG_TCMPL) {
+      if (cb.transfer) {
+        cb.transfer(index, cb.transferCtx);
+      } else if (transferCB) {
+        transferCB(index);
+      }
+    }
+  }
+
+  // Channels 0 - 3 have their own vectors, the rest share DMAC_4. The shared 
+  // handler drains every pending channel before returning.
+  void serviceShared_() {
+    const uint32_t entryTime = DMA_IRQ_TIMESTAMP();
+    const uint32_t sharedMask = ~((UINT32_C(1) << DMA_DEDICATED_IRQ_COUNT) - 1);
+    uint32_t pending = DMAC->INTSTATUS.reg & sharedMask;
+    while(pending) {
+      do {
+        serviceChannel_(__builtin_ctz(pending), entryTime);
+        pending &= pending - 1;
+      } while(pending);
+      pending = DMAC->INTSTATUS.reg & sharedMask;
+    }
+  }
+
+}
+
+}
+
+extern "C" {
+  void DMAC_0_Handler(void) { samc::dma::serviceChannel_(0, DMA_IRQ_TIMESTAMP()); }
+  void DMAC_1_Handler(void) { samc::dma::serviceChannel_(1, DMA_IRQ_TIMESTAMP()); }
+  void DMAC_2_Handler(void) { samc::dma::serviceChannel_(2, DMA_IRQ_TIMESTAMP()); }
+  void DMAC_3_Handler(void) { samc::dma::serviceChannel_(3, DMA_IRQ_TIMESTAMP()); }
+  void DMAC_4_Handler(void) { samc::dma::serviceShared_(); }
+}
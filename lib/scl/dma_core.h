@@ -1,6 +1,4 @@
 
-/*
-
 #pragma once
 #include <sam.h>
 #include <string.h>
@@ -10,7 +8,7 @@
 
 namespace samc {
 
-    namespace dma {
+  namespace dma {
 
     #define DMA_PRILVL_COUNT 4
     #define DMA_IRQ_COUNT 5
@@ -18,6 +16,48 @@ namespace samc {
     #define DMA_QOS_MAX 3
     #define MAX_BURSTLENGTH 16
     #define DMA_MAX_TASKS 256
+    #define DMA_MAX_BUFFERS 8
+    #define DMA_DEDICATED_IRQ_COUNT 4
+    #define DMA_STATS_BINS 24
+
+    // Build switches, override with -D in build_flags.
+    #ifndef DMA_DESC_POOL_SIZE
+      #define DMA_DESC_POOL_SIZE 128
+    #endif
+    #ifndef DMA_TASK_TABLE_ENABLED
+      #define DMA_TASK_TABLE_ENABLED false
+    #endif
+    #ifndef DMA_IRQ_LATENCY_ENABLED
+      #define DMA_IRQ_LATENCY_ENABLED false
+    #endif
+    #ifndef DMA_MEMCPY_CH_COUNT
+      #define DMA_MEMCPY_CH_COUNT 4
+    #endif
+    // Blocks per memcpy_async/memset_async, longer copies run on the CPU.
+    #ifndef DMA_MEMCPY_TASKS
+      #define DMA_MEMCPY_TASKS 4
+    #endif
+    #ifndef DMA_MEMCPY_MIN_BYTES
+      #define DMA_MEMCPY_MIN_BYTES 32
+    #endif
+    #ifndef DMA_CRC_HARDWARE_ENABLED
+      #define DMA_CRC_HARDWARE_ENABLED true
+    #endif
+    #ifndef DMA_CRC_MIN_BYTES
+      #define DMA_CRC_MIN_BYTES 64
+    #endif
+    #ifndef DMA_STATS_ENABLED
+      #define DMA_STATS_ENABLED false
+    #endif
+    // Not measured: 64 bytes is a placeholder. The host model has no
+    // exception entry cost, so set this from test_dma_poll's round trip
+    // run on the part.
+    #ifndef DMA_POLL_THRESHOLD
+      #define DMA_POLL_THRESHOLD 64
+    #endif
+    #ifndef DMA_WATCHDOG_TICKS
+      #define DMA_WATCHDOG_TICKS 4
+    #endif
 
     enum CHANNEL_STATE : int;
     enum CHANNEL_ERROR : int;
@@ -27,43 +67,104 @@ namespace samc {
     enum CRC_STATUS : int;
 
     class taskDescriptor;
+    class multiBuffer;
+    class wavePlayer;
 
     typedef void (*transferCallbackType)(int channelIndex);
     typedef void (*errorCallbackType)(int channelIndex, CHANNEL_ERROR);  
+    typedef void (*bufferCallbackType)(int channelIndex, int bufferIndex, void *buffer);
+    typedef void (*chTransferCallbackType)(int channelIndex, void *context);
+    typedef void (*chErrorCallbackType)(int channelIndex, CHANNEL_ERROR, void *context);
+    typedef void (*statsWriterType)(const char *line);
 
-    struct _config_ {
+    // Latency bins are log2 of the trigger to TCMPL time in cycles.
+    typedef __PACKED_STRUCT {
+      uint32_t transfers;
+      uint64_t bytes;
+      uint32_t errors[5];
+      uint32_t suspends;
+      uint32_t latency[DMA_STATS_BINS];
+    }channelStats;
 
-      int irqPriority = 1;
-      int prilvl_service_qual[DMA_PRILVL_COUNT] = {2};
-      bool prilvl_rr_mode[DMA_PRILVL_COUNT] = {false};
-      bool prilvl_enabled[DMA_PRILVL_COUNT] = {false};
-      bool chRunStandby[DMAC_CH_NUM] = {false};
-      int chPrilvl[DMAC_CH_NUM] = {2};
+    void serviceBuffer_(multiBuffer*, const uint8_t&);
+    void serviceWave_(wavePlayer*, const uint8_t&);
 
-    };
+    // Applied by sys::setInit and ch::setInit.
+    namespace configGroup {
+
+      extern int irqPriority;
+      extern int prilvl_service_qual[DMA_PRILVL_COUNT];
+      extern bool prilvl_rr_mode[DMA_PRILVL_COUNT];
+      extern bool prilvl_enabled[DMA_PRILVL_COUNT];
+      extern bool chRunStandby[DMAC_CH_NUM];
+      extern int chPrilvl[DMAC_CH_NUM];
 
+    }
 
-    typedef struct sysCtrl {
 
-      static bool setInit(const bool&); 
-      static bool getInit();
+    namespace sys {
+
+      bool setInit(const bool&); 
+      bool getInit();
       
-      static bool setEnabled(const bool&); 
-      static bool getEnabled();
+      bool setEnabled(const bool&); 
+      bool getEnabled();
+
+      bool setErrorCallback(errorCallbackType); 
+      errorCallbackType getErrorCallback();
+
+      bool setTransferCallback(transferCallbackType); 
+      transferCallbackType getTransferCallback();
+
+      uint32_t getIrqLatency(const int&);
+      uint32_t getIrqLatencyMax(const int&);
+      void clearIrqLatency();
 
-      static bool setErrorCallback(errorCallbackType&); 
-      static errorCallbackType *getErrorCallback();
+      bool getStats(const int&, channelStats&);
+      void clearStats(const int&);
+      bool dumpStats(const int&, statsWriterType);
 
-      static bool setTransferCallback(transferCallbackType&); 
-      static transferCallbackType *getTransferCallback();
+    }
+
+
+
+
+
+    // Hands out channels at runtime, channels driven through channelCtrl<index>
+    // should be claimed with reserve() so they are never handed out.
+    struct allocCtrl {
+
+      static int allocate(const int &prilvl, const bool &runStandby, 
+        const char *owner = nullptr);
+      static bool reserve(const int &index, const char *owner = nullptr);
+      static bool release(const int &index);
+
+      static const char *getOwner(const int&);
+      static uint32_t getAllocated();
 
     };
 
 
+    // service() is meant to run at a low fixed rate. A watched channel that
+    // stays pending or busy without moving for stallTicks calls, or that was
+    // stopped by a transfer error, is reset and restarted from the base of 
+    // its chain and reported as ERROR_STALL. Fetch errors are left alone as
+    // multiBuffer and taskQueue use them for flow control. A taskQueue
+    // channel cannot be watched: its base descriptor has already run, so a
+    // restart would repeat completed transfers.
+    struct watchdogCtrl {
 
+      static bool setEnabled(const int &index, const bool &enabled,
+        const int &stallTicks = DMA_WATCHDOG_TICKS);
+      static bool getEnabled(const int&);
 
+      static int service();
+      static uint32_t getRestarts(const int&);
 
-    typedef struct activeChannel {
+    };
+
+
+    namespace ach {
 
       int getBytes(); 
 
@@ -71,28 +172,70 @@ namespace samc {
 
       bool getBusy(); 
 
-    };
+    }
 
-    
-    class crcCtrl {
 
-      static bool setInputChannel(const int&);
-      static int getInputChannel();
+    // Channel control by runtime index, channelCtrl<index> wraps these for 
+    // channels fixed at compile time.
+    namespace ch {
 
-      static bool setMode(const CRC_MODE&);
-      static CRC_MODE getMode();
+      bool setInit(const bool&, const int&); 
+      bool getInit(const int&);
 
-      static CRC_STATUS getStatus();
+      bool setState(const CHANNEL_STATE&, const int&); 
+      CHANNEL_STATE getState(const int&);
 
-      static struct {}CRC_INPUT;
-      static struct {}CRC_OUTPUT;
+      bool setPeripheral(const PERIPHERAL_LINK&, const int&); 
+      PERIPHERAL_LINK getPeripheral(const int&);
 
-      static struct {}dma_enabled;
+      bool setTransferMode(const TRANSFER_MODE&, const int&); 
+      TRANSFER_MODE getTransferMode(const int&);
 
-    };
+      CHANNEL_ERROR getError(const int&); 
+
+      bool setTransferCallback(chTransferCallbackType, void*, const int&);
+      chTransferCallbackType getTransferCallback(const int&);
+
+      bool setErrorCallback(chErrorCallbackType, void*, const int&);
+      chErrorCallbackType getErrorCallback(const int&);
+
+      taskDescriptor getCurrentTask(const int&); 
+
+      // For modules that drive a channel from allocCtrl with descriptors of
+      // their own rather than tasks. ch::setInit clears both.
+      DmacDescriptor *getBaseDescriptor(const int&);
+      const DmacDescriptor *getWritebackDescriptor(const int&);
+
+      bool setTasks(std::initializer_list<taskDescriptor*>, const int&); 
+
+      taskDescriptor &getTask(const int&, const int&);
+
+      int indexOf(const taskDescriptor&, const int&);
+      
+      bool addTask(const int&, taskDescriptor&, const int&);
+      
+      taskDescriptor &removeTask(const int&, const int&);
+
+      int getTaskCount(const int&);  
+      
+      bool clearTasks(const int&);
+
+      bool setLooped(const bool&, const int&);
+      bool getLooped(const int&);
 
+      int getBytesTransferred(const int&);
+      int getBytesRemaining(const int&);
 
-    
+      bool setPolled(const bool&, const int&, const int&);
+      bool getPolled(const int&);
+      bool wait(const uint32_t&, const int&);
+
+      void linkTask_(taskDescriptor*, taskDescriptor*);
+      taskDescriptor *taskAt_(const int&, const int&);
+      bool insertTask_(const int&, taskDescriptor&, const int&);
+      taskDescriptor *extractTask_(const int&, const int&);
+
+    }
 
 
     template<int index>
@@ -101,8 +244,8 @@ namespace samc {
       bool setInit(const bool&); 
       bool getInit();
 
-      bool getState(const CHANNEL_STATE&); 
-      CHANNEL_STATE setState();
+      bool setState(const CHANNEL_STATE&); 
+      CHANNEL_STATE getState();
       
       bool setPeripheral(const PERIPHERAL_LINK&); 
       PERIPHERAL_LINK getPeripheral();
@@ -110,11 +253,27 @@ namespace samc {
       bool setTransferMode(const TRANSFER_MODE&); 
       TRANSFER_MODE getTransferMode();
 
+      template<typename config>
+      bool setConfig() {
+        static_assert(index >= 0 && index < DMAC_CH_NUM, 
+          "channelCtrl: channel index out of range");
+        DMAC->Channel[index].CHCTRLA.bit.ENABLE = 0;
+        while(DMAC->Channel[index].CHCTRLA.bit.ENABLE);
+        DMAC->Channel[index].CHCTRLA.reg = config::chctrla;
+        DMAC->Channel[index].CHPRILVL.reg = config::chprilvl;
+        DMAC->CTRL.reg |= (DMAC_CTRL_LVLEN0 << config::chprilvl);
+        return DMAC->Channel[index].CHCTRLA.reg == config::chctrla;
+      }
+
       CHANNEL_ERROR getError(); 
 
-      taskDescriptor getCurrentTask(); 
+      bool setTransferCallback(chTransferCallbackType, void *context = nullptr);
+      chTransferCallbackType getTransferCallback();
 
-      bool tasks(taskDescriptor[])
+      bool setErrorCallback(chErrorCallbackType, void *context = nullptr);
+      chErrorCallbackType getErrorCallback();
+
+      taskDescriptor getCurrentTask(); 
 
       bool setTasks(std::initializer_list<taskDescriptor*>); 
 
@@ -130,12 +289,31 @@ namespace samc {
       
       bool clearTasks();
 
+      bool setLooped(const bool&);
+      bool getLooped();
+
+      int getBytesTransferred();
+      int getBytesRemaining();
+
+      bool setPolled(const bool&, const int &threshold = DMA_POLL_THRESHOLD);
+      bool getPolled();
+      bool wait(const uint32_t &timeoutCycles = 0);
+
     };
 
 
     class taskDescriptor {
       template<int index>
       friend struct channelCtrl;
+      friend void ch::linkTask_(taskDescriptor*, taskDescriptor*);
+      friend taskDescriptor *ch::taskAt_(const int&, const int&);
+      friend bool ch::insertTask_(const int&, taskDescriptor&, const int&);
+      friend taskDescriptor *ch::extractTask_(const int&, const int&);
+      friend int ch::indexOf(const taskDescriptor&, const int&);
+      friend bool ch::addTask(const int&, taskDescriptor&, const int&);
+      friend bool ch::clearTasks(const int&);
+      friend bool ch::getLooped(const int&);
+      friend bool ch::setTasks(std::initializer_list<taskDescriptor*>, const int&);
 
       public: 
         taskDescriptor();
@@ -192,13 +370,367 @@ namespace samc {
         bool setDesc_(const void*, const int&, const bool&, const int&, 
           const bool&);
         __PACKED_STRUCT {
-          uint8_t srcAlign, destAlign, assignedCh, alloc;
+          int8_t srcAlign, destAlign, assignedCh, alloc;
         }info;
         taskDescriptor *linked;
         DmacDescriptor *desc;
     };
 
 
+    // Resolves BTCTRL, BTCNT and the end address offsets of a transfer at 
+    // compile time, volatile types are treated as fixed peripheral registers.
+    // STEP strides the incrementing side (the source if both increment).
+    template<typename S, typename D, size_t N, int STEP = 1, 
+      int BLOCKACT = DMAC_BTCTRL_BLOCKACT_NOACT_Val>
+    struct staticTask {
+      static constexpr bool srcInc = !std::is_volatile<S>::value;
+      static constexpr bool dstInc = !std::is_volatile<D>::value;
+      static constexpr int beatSize = sizeof(S) < sizeof(D) ? sizeof(S) : sizeof(D);
+
+      static constexpr bool stepSrc = srcInc 
+        && (sizeof(S) > beatSize || STEP > 1);
+      static constexpr bool stepDst = dstInc 
+        && (sizeof(D) > beatSize || (STEP > 1 && !srcInc));
+      static constexpr int stepBeats = STEP * (stepSrc ? sizeof(S) / beatSize
+        : stepDst ? sizeof(D) / beatSize : 1);
+      static constexpr int stepSize = stepBeats >= 128 ? 7 : stepBeats >= 64 ? 6 
+        : stepBeats >= 32 ? 5 : stepBeats >= 16 ? 4 : stepBeats >= 8 ? 3 
+        : stepBeats >= 4 ? 2 : stepBeats >= 2 ? 1 : 0;
+
+      static_assert(sizeof(S) == 1 || sizeof(S) == 2 || sizeof(S) == 4,
+        "staticTask: source type must be 1, 2 or 4 bytes wide");
+      static_assert(sizeof(D) == 1 || sizeof(D) == 2 || sizeof(D) == 4,
+        "staticTask: destination type must be 1, 2 or 4 bytes wide");
+      static_assert(N > 0 && N <= 0xFFFF, 
+        "staticTask: beat count must be between 1 and 65535");
+      static_assert(STEP >= 1 && (srcInc || dstInc || STEP == 1),
+        "staticTask: step requires an incrementing side");
+      static_assert(!(stepSrc && stepDst),
+        "staticTask: only one side of a transfer can step");
+      static_assert(stepBeats <= 128 && (stepBeats & (stepBeats - 1)) == 0,
+        "staticTask: step must be a power of two of at most 128 beats");
+      static_assert(BLOCKACT >= DMAC_BTCTRL_BLOCKACT_NOACT_Val 
+        && BLOCKACT <= DMAC_BTCTRL_BLOCKACT_BOTH_Val,
+        "staticTask: invalid block action");
+
+      static constexpr uint16_t btctrl = DMAC_BTCTRL_VALID
+        | DMAC_BTCTRL_BLOCKACT(BLOCKACT)
+        | DMAC_BTCTRL_BEATSIZE(beatSize >> 1)
+        | (srcInc ? DMAC_BTCTRL_SRCINC : 0)
+        | (dstInc ? DMAC_BTCTRL_DSTINC : 0)
+        | (stepSrc ? DMAC_BTCTRL_STEPSEL : 0)
+        | DMAC_BTCTRL_STEPSIZE(stepSize);
+      static constexpr uint16_t btcnt = N;
+      static constexpr uint32_t srcOffset = srcInc 
+        ? N * beatSize * (stepSrc ? stepBeats : 1) : 0;
+      static constexpr uint32_t dstOffset = dstInc 
+        ? N * beatSize * (stepDst ? stepBeats : 1) : 0;
+
+      // Patches everything but DESCADDR, so links are preserved.
+      static void write(DmacDescriptor *desc, const S *src, D *dst) {
+        volatile uint32_t *words = (volatile uint32_t*)desc;
+        words[0] = btctrl | ((uint32_t)btcnt << 16);
+        words[1] = (uintptr_t)src + srcOffset;
+        words[2] = (uintptr_t)dst + dstOffset;
+      }
+      static bool apply(taskDescriptor &task, const S *src, D *dst) {
+        DmacDescriptor *desc = (DmacDescriptor*)task;
+        if (!desc) {
+          return false;
+        }
+        write(desc, src, dst);
+        return true;
+      }
+    };
+
+
+    class multiBuffer {
+      friend void serviceBuffer_(multiBuffer*, const uint8_t&);
+
+      public:
+        multiBuffer();
+
+        template<typename S, typename T, size_t N, size_t M>
+        bool setBuffers(const S *source, T (&buffers)[M][N]) {
+          static_assert(M >= 2 && M <= DMA_MAX_BUFFERS, 
+            "multiBuffer: buffer count must be between 2 and DMA_MAX_BUFFERS");
+          static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4,
+            "multiBuffer: element size must be a valid beat size");
+          return setBuffers_((const void*)source, (void*)buffers, sizeof(T), N, M);
+        }
+
+        bool setCallback(bufferCallbackType);
+        bufferCallbackType getCallback() const;
+
+        bool attach(const int&);
+        bool detach();
+        int getChannel() const;
+
+        void *getBuffer(const int&) const;
+        int getBufferCount() const;
+        int getBeatSize() const;
+
+        bool release(const int&);
+        bool getOwned(const int&);
+
+        bool getOverrun() const;
+        void clearOverrun();
+
+        ~multiBuffer();
+
+      protected:
+        bool setBuffers_(const void*, void*, const int&, const int&, const int&);
+        taskDescriptor tasks[DMA_MAX_BUFFERS];
+        bufferCallbackType callback;
+        uint8_t *bufferBase;
+        int bufferBytes;
+        int8_t bufferCount;
+        int8_t beatSize;
+        int8_t channel;
+        volatile int8_t nextBuffer;
+        volatile bool overrun;
+    };
+
+
+    // Loops a table into a fixed register, one block (with TCMPL) per period.
+    // play() on a running player links the new table in behind the base
+    // descriptor. The period in flight already holds the old link, so the 
+    // switch lands on the period boundary after the next one, and the block
+    // complete interrupt folds it back into the base descriptor. getTable() 
+    // moves to the new table at that fold. Tables must stay untouched while
+    // they play.
+    class wavePlayer {
+      friend void serviceWave_(wavePlayer*, const uint8_t&);
+
+      public:
+        wavePlayer();
+
+        bool attach(volatile void *dst, const int &channelIndex, 
+          const int &beatSize = 2);
+        bool detach();
+        int getChannel() const;
+
+        bool play(const void *table, const int &length);
+        bool getPending() const;
+        const void *getTable() const;
+
+        ~wavePlayer();
+
+      protected:
+        void write_(DmacDescriptor*, const void*, const int&);
+        DmacDescriptor *standby;
+        volatile void *dst;
+        const void *volatile table;
+        const void *pending;
+        int beatSize;
+        int8_t channel;
+        volatile bool swapping;
+    };
+
+
+    // A single looped block with no interrupt, the write index is read back
+    // from the channel. Overrun is only seen by a consumer that polls at
+    // least once per lap: one that misses a whole lap finds the index where
+    // it was and takes the newest lap for the old one. Size the ring so the
+    // consumer's worst-case gap stays under length samples.
+    class ringBufferBase {
+      public:
+        bool detach();
+        int getChannel() const;
+
+        int getAvailable();
+        bool consume(const int&);
+
+        bool getOverrun() const;
+        void clearOverrun();
+
+        ~ringBufferBase();
+
+      protected:
+        ringBufferBase(void*, const int&, const int&);
+        bool attach_(const void*, const int&);
+        const void *getSpan_(int&);
+        int getWriteIndex_();
+        int update_();
+        taskDescriptor task;
+        uint8_t *data;
+        int beatSize;
+        int length;
+        int channel;
+        int readIndex;
+        int writeIndex;
+        bool overrun;
+    };
+
+    template<typename T, int N>
+    class ringBuffer : public ringBufferBase {
+      static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4,
+        "ringBuffer: element size must be a valid beat size");
+      static_assert(N > 1 && N <= UINT16_MAX, 
+        "ringBuffer: length must fit in a single block (BTCNT)");
+
+      public:
+        ringBuffer() : ringBufferBase((void*)storage, sizeof(T), N) {}
+
+        template<typename S>
+        bool attach(const S *source, const int &channelIndex) {
+          return attach_((const void*)source, channelIndex);
+        }
+
+        const T *getSpan(int &count) {
+          return (const T*)getSpan_(count);
+        }
+
+        int read(T *dest, const int &count) {
+          int copied = 0;
+          while(copied < count) {
+            int spanCount = 0;
+            const T *span = getSpan(spanCount);
+            if (!spanCount) {
+              break;
+            }
+            spanCount = spanCount < count - copied ? spanCount : count - copied;
+            memcpy(dest + copied, span, spanCount * sizeof(T));
+            consume(spanCount);
+            copied += spanCount;
+          }
+          return copied;
+        }
+
+      protected:
+        T storage[N] __ALIGNED(4);
+    };
+
+
+    // Producers append to a running chain that always ends in a VALID=0 
+    // fence, so enqueuing never suspends the channel.
+    class taskQueue {
+      public:
+        taskQueue();
+
+        bool attach(const int &channelIndex);
+        bool detach();
+        int getChannel() const;
+
+        bool push(taskDescriptor&);
+        int getPending();
+        bool poll();
+
+        ~taskQueue();
+
+      protected:
+        void reclaim_();
+        DmacDescriptor *head;
+        DmacDescriptor *tail;
+        int channel;
+        int count;
+    };
+
+
+    class transferToken {
+      public:
+        transferToken();
+        transferToken(const int&, const uint32_t&);
+
+        bool getDone() const;
+        bool getError() const;
+        bool wait() const;
+
+        int getChannel() const;
+
+      protected:
+        int slot;
+        uint32_t sequence;
+    };
+
+    transferToken memcpy_async(void*, const void*, const size_t&);
+    transferToken memset_async(void*, const int&, const size_t&);
+
+
+    struct ioSpan {
+      ioSpan(const void *data, const size_t &length) 
+        : data(const_cast<void*>(data)), length(length) {}
+
+      template<typename T, size_t N>
+      ioSpan(T (&array)[N]) 
+        : data((void*)array), length(N * sizeof(T)) {}
+
+      void *data;
+      size_t length;
+    };
+
+    // Chains the spans into one transaction to/from a fixed peripheral
+    // register. A software triggered channel is switched to 
+    // MODE_TRANSFER_ALL and started, a peripheral triggered one is left 
+    // armed. The channel's tasks are replaced.
+    bool gather(volatile void *dst, std::initializer_list<ioSpan> spans,
+      const int &index, const int &beatSize = 1);
+    bool scatter(const volatile void *src, std::initializer_list<ioSpan> spans,
+      const int &index, const int &beatSize = 1);
+
+    // One descriptor per plane, each stepping through the interleaved source
+    // so channel c lands contiguously in planes[c]. With dstStride > 1 the
+    // source is read as consecutive planes of samples beats and written 
+    // strided from planes[c]. Strides are in beats, srcStride defaults to 
+    // channels when the destination doesn't step and to 1 otherwise. Strides
+    // must be powers of two of at most 128 and only one side can step.
+    // Started the same way as gather/scatter.
+    bool deinterleave(const void *src, void *const planes[], const int &channels,
+      const int &samples, const int &index, const int &beatSize = 2,
+      const int &srcStride = 0, const int &dstStride = 1);
+
+
+    namespace crc {
+
+      struct crcState {
+        CRC_MODE mode;
+        uint32_t value;
+      };
+
+      // CRC_TYPE_16 is CRC-16/CCITT-FALSE, CRC_TYPE_32 is the IEEE 802.3 CRC.
+      uint32_t compute(const ioSpan &span, const CRC_MODE &mode);
+
+      // Runs once the span is through, from the CRC channel's interrupt 
+      // when the engine took it; failed leaves state as it was.
+      typedef void (*crcCallbackType)(crcState &state, bool failed, 
+        void *context);
+
+      crcState begin(const CRC_MODE &mode);
+      bool update(crcState &state, const ioSpan &span);
+      uint32_t finish(const crcState &state);
+
+      // Returns once the engine has the span, state and the data must stay
+      // put until the callback. Spans update() would do in software are done
+      // here and the callback runs before this returns.
+      bool update_async(crcState &state, const ioSpan &span,
+        crcCallbackType callback, void *context = nullptr);
+      bool getBusy();
+
+      uint32_t updateSoftware(const CRC_MODE &mode, const uint32_t &value,
+        const void *data, const size_t &length);
+
+      // Computes the CRC of whatever passes through a channel, the CRC beat
+      // size is taken from the channel's base task. Fails while the engine
+      // is in use.
+      bool attach(const int &index, const CRC_MODE &mode);
+      uint32_t detach();
+
+      bool setInputChannel(const int&);
+      int getInputChannel();
+
+      bool setMode(const CRC_MODE&);
+      CRC_MODE getMode();
+
+      CRC_STATUS getStatus();
+
+      // Pass to setSource/setDestination to read CRCCHKSUM or feed CRCDATAIN.
+      struct crcTag {};
+      extern crcTag CRC_INPUT;
+      extern crcTag CRC_OUTPUT;
+
+    }
+
+
     enum CRC_STATUS : int {
       CRC_DISABLED,
       CRC_IDLE,
@@ -215,7 +747,8 @@ namespace samc {
       ERROR_NONE,
       ERROR_CRC,
       ERROR_DESC,
-      ERROR_TRANSFER
+      ERROR_TRANSFER,
+      ERROR_STALL
     };
 
     enum CHANNEL_STATE : int {
@@ -324,8 +857,160 @@ namespace samc {
       LINK_QSPI_TX           = 84
     };
 
+
+    // Folds a channel's configuration into its CHCTRLA and CHPRILVL values
+    // at compile time, THRESHOLD is given in beats.
+    template<PERIPHERAL_LINK LINK, TRANSFER_MODE MODE = MODE_TRANSFER_ALL, 
+      int PRILVL = 0, bool STANDBY = false, int THRESHOLD = 1>
+    struct channelConfig {
+      static constexpr bool burst = MODE < MODE_TRANSFER_TASK;
+      static constexpr int thresholdVal = THRESHOLD == 8 ? 3 : THRESHOLD == 4 ? 2
+        : THRESHOLD == 2 ? 1 : 0;
+
+      static_assert(LINK >= LINK_NONE && LINK <= LINK_QSPI_TX,
+        "channelConfig: invalid peripheral link");
+      static_assert(MODE == MODE_TRANSFER_1VALUE || MODE == MODE_TRANSFER_2VALUE 
+        || MODE == MODE_TRANSFER_4VALUE || MODE == MODE_TRANSFER_8VALUE
+        || MODE == MODE_TRANSFER_12VALUE || MODE == MODE_TRANSFER_16VALUE
+        || MODE == MODE_TRANSFER_TASK || MODE == MODE_TRANSFER_ALL,
+        "channelConfig: invalid transfer mode");
+      static_assert(PRILVL >= 0 && PRILVL < DMA_PRILVL_COUNT,
+        "channelConfig: priority level out of range");
+      static_assert(THRESHOLD == 1 || THRESHOLD == 2 || THRESHOLD == 4 
+        || THRESHOLD == 8, "channelConfig: threshold must be 1, 2, 4 or 8 beats");
+      static_assert(!burst || THRESHOLD <= MODE,
+        "channelConfig: threshold cannot exceed the burst length");
+
+      static constexpr uint32_t chctrla = DMAC_CHCTRLA_TRIGSRC(LINK)
+        | DMAC_CHCTRLA_TRIGACT(burst ? DMAC_CHCTRLA_TRIGACT_BURST_Val 
+          : MODE == MODE_TRANSFER_TASK ? DMAC_CHCTRLA_TRIGACT_BLOCK_Val 
+          : DMAC_CHCTRLA_TRIGACT_TRANSACTION_Val)
+        | DMAC_CHCTRLA_BURSTLEN(burst ? MODE - 1 : DMAC_CHCTRLA_BURSTLEN_SINGLE_Val)
+        | DMAC_CHCTRLA_THRESHOLD(thresholdVal)
+        | (STANDBY ? DMAC_CHCTRLA_RUNSTDBY : 0);
+      static constexpr uint8_t chprilvl = DMAC_CHPRILVL_PRILVL(PRILVL);
+    };
+
+
+    template<int index> 
+    bool channelCtrl<index>::setInit(const bool &value) { 
+      return ch::setInit(value, index); 
+    }
+    template<int index> 
+    bool channelCtrl<index>::getInit() { return ch::getInit(index); }
+
+    template<int index> 
+    bool channelCtrl<index>::setState(const CHANNEL_STATE &value) { 
+      return ch::setState(value, index); 
+    }
+    template<int index> 
+    CHANNEL_STATE channelCtrl<index>::getState() { return ch::getState(index); }
+
+    template<int index> 
+    bool channelCtrl<index>::setPeripheral(const PERIPHERAL_LINK &value) { 
+      return ch::setPeripheral(value, index); 
+    }
+    template<int index> 
+    PERIPHERAL_LINK channelCtrl<index>::getPeripheral() { 
+      return ch::getPeripheral(index); 
+    }
+
+    template<int index> 
+    bool channelCtrl<index>::setTransferMode(const TRANSFER_MODE &value) { 
+      return ch::setTransferMode(value, index); 
+    }
+    template<int index> 
+    TRANSFER_MODE channelCtrl<index>::getTransferMode() { 
+      return ch::getTransferMode(index); 
+    }
+
+    template<int index> 
+    CHANNEL_ERROR channelCtrl<index>::getError() { return ch::getError(index); }
+
+    template<int index> 
+    bool channelCtrl<index>::setTransferCallback(chTransferCallbackType value,
+      void *context) { 
+      return ch::setTransferCallback(value, context, index); 
+    }
+    template<int index> 
+    chTransferCallbackType channelCtrl<index>::getTransferCallback() { 
+      return ch::getTransferCallback(index); 
+    }
+
+    template<int index> 
+    bool channelCtrl<index>::setErrorCallback(chErrorCallbackType value, 
+      void *context) { 
+      return ch::setErrorCallback(value, context, index); 
+    }
+    template<int index> 
+    chErrorCallbackType channelCtrl<index>::getErrorCallback() { 
+      return ch::getErrorCallback(index); 
+    }
+
+    template<int index> 
+    taskDescriptor channelCtrl<index>::getCurrentTask() { 
+      return ch::getCurrentTask(index); 
+    }
+
+    template<int index> 
+    bool channelCtrl<index>::setTasks(std::initializer_list<taskDescriptor*> 
+      tasks) { 
+      return ch::setTasks(tasks, index); 
+    }
+
+    template<int index> 
+    taskDescriptor &channelCtrl<index>::getTask(const int &taskIndex) { 
+      return ch::getTask(taskIndex, index); 
+    }
+
+    template<int index> 
+    int channelCtrl<index>::indexOf(const taskDescriptor &task) { 
+      return ch::indexOf(task, index); 
+    }
+
+    template<int index> 
+    bool channelCtrl<index>::addTask(const int &taskIndex, taskDescriptor &task) { 
+      return ch::addTask(taskIndex, task, index); 
+    }
+
+    template<int index> 
+    taskDescriptor &channelCtrl<index>::removeTask(const int &taskIndex) { 
+      return ch::removeTask(taskIndex, index); 
+    }
+
+    template<int index> 
+    int channelCtrl<index>::getTaskCount() { return ch::getTaskCount(index); }
+
+    template<int index> 
+    bool channelCtrl<index>::clearTasks() { return ch::clearTasks(index); }
+
+    template<int index> 
+    bool channelCtrl<index>::setLooped(const bool &value) { 
+      return ch::setLooped(value, index); 
+    }
+    template<int index> 
+    bool channelCtrl<index>::getLooped() { return ch::getLooped(index); }
+
+    template<int index> 
+    int channelCtrl<index>::getBytesTransferred() { 
+      return ch::getBytesTransferred(index); 
+    }
+    template<int index> 
+    int channelCtrl<index>::getBytesRemaining() { 
+      return ch::getBytesRemaining(index); 
+    }
+
+    template<int index> 
+    bool channelCtrl<index>::setPolled(const bool &value, const int &threshold) { 
+      return ch::setPolled(value, threshold, index); 
+    }
+    template<int index> 
+    bool channelCtrl<index>::getPolled() { return ch::getPolled(index); }
+    template<int index> 
+    bool channelCtrl<index>::wait(const uint32_t &timeoutCycles) { 
+      return ch::wait(timeoutCycles, index); 
+    }
+
   }
 
 }
-
-*/
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "dma_tune.h"
+#include <stdio.h>
+
+namespace {
+
+  static const int MODE_REF[] = {1, 2, 4, 8, 12, 16};
+  static const int THRESHOLD_REF[] = {1, 2, 4, 8};
+
+  static int beatVal_(const int &beatSize) {
+    return beatSize == 4 ? DMAC_BTCTRL_BEATSIZE_WORD_Val 
+      : beatSize == 2 ? DMAC_BTCTRL_BEATSIZE_HWORD_Val 
+      : DMAC_BTCTRL_BEATSIZE_BYTE_Val;
+  }
+
+  // Addresses are end addresses as both sides increment.
+  static void setCopy_(DmacDescriptor *desc, const void *src, void *dst, 
+    const int &length, const int &beatSize, const uint16_t &blockAct) {
+    const uint32_t bytes = (uint32_t)length * beatSize;
+    desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_DSTINC
+      | DMAC_BTCTRL_BEATSIZE(beatVal_(beatSize)) | blockAct;
+    desc->BTCNT.reg = length;
+    desc->SRCADDR.reg = (uintptr_t)src + bytes;
+    desc->DSTADDR.reg = (uintptr_t)dst + bytes;
+    desc->DESCADDR.reg = 0;
+  }
+
+  static void setPrictrl_(const uint32_t &base, const int &prilvl, 
+    const int &qos, const bool &roundRobin) {
+    const int qosPos = DMAC_PRICTRL0_QOS0_Pos + prilvl * 8;
+    uint32_t reg = base & ~(DMAC_PRICTRL0_QOS0_Msk << (prilvl * 8))
+      & ~DMAC_PRICTRL0_RRLVLEN0;
+    reg |= (uint32_t)qos << qosPos;
+    if (roundRobin) {
+      reg |= DMAC_PRICTRL0_RRLVLEN0;
+    }
+    DMAC->PRICTRL0.reg = reg;
+  }
+
+  // Runs the channel the way the emitted channelConfig does, one burst per
+  // trigger, with software standing in for a peripheral that asks again as
+  // soon as the previous request is taken. BURSTLEN then sets both the bus
+  // tenure per request and how often the arbiter gets to switch channels.
+  // TCMPL is only raised with the interrupt block action, the interrupt
+  // itself stays masked.
+  static bool measure_(const int &index, const samc::dma::tuneShape &shape, 
+    uint32_t &worst, uint32_t &mean) {
+    using namespace samc::dma;
+    uint64_t total = 0;
+    worst = 0;
+    for (int i = 0; i < shape.repetitions; i++) {
+      setCopy_(ch::getBaseDescriptor(index), shape.source, shape.destination,
+        shape.length, shape.beatSize, DMAC_BTCTRL_BLOCKACT_INT);
+      DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+      ch::setState(STATE_IDLE, index);
+      const uint32_t start = DWT->CYCCNT;
+      uint32_t elapsed = 0;
+      while(!(DMAC->Channel[index].CHINTFLAG.reg 
+        & (DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR))) {
+        if (!(DMAC->SWTRIGCTRL.reg & (1UL << index))) {
+          DMAC->SWTRIGCTRL.reg |= 1UL << index;
+        }
+        elapsed = DWT->CYCCNT - start;
+        if (elapsed >= DMA_TUNE_TIMEOUT) break;
+      }
+      elapsed = DWT->CYCCNT - start;
+      const bool failed = !(DMAC->Channel[index].CHINTFLAG.reg 
+        & DMAC_CHINTFLAG_TCMPL);
+      DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+      ch::setState(STATE_DISABLED, index);
+      if (failed) {
+        return false;
+      }
+      total += elapsed;
+      if (elapsed > worst) worst = elapsed;
+    }
+    mean = (uint32_t)(total / shape.repetitions);
+    return true;
+  }
+
+}
+
+namespace samc {
+
+  namespace dma {
+
+    bool tune::run(const tuneShape &shape, tuneResult &best, 
+      statsWriterType writer) {
+      if (!shape.source || !shape.destination || shape.length <= 0 
+        || shape.length > 0xFFFF || shape.repetitions <= 0
+        || (shape.beatSize != 1 && shape.beatSize != 2 && shape.beatSize != 4)
+        || shape.prilvl <= 0 || shape.prilvl >= DMA_PRILVL_COUNT
+        || shape.loadChannels < 0 || shape.loadChannels > DMA_TUNE_MAX_LOAD
+        || (shape.loadChannels && (!shape.loadSource || !shape.loadDestination
+          || shape.loadLength <= 0 || shape.loadLength > 0xFFFF))) {
+        return false;
+      }
+      const int index = allocCtrl::allocate(shape.prilvl, false, "tune");
+      if (index < 0) {
+        return false;
+      }
+      int load[DMA_TUNE_MAX_LOAD];
+      int loadCount = 0;
+      for (; loadCount < shape.loadChannels; loadCount++) {
+        load[loadCount] = allocCtrl::allocate(0, false, "tune load");
+        if (load[loadCount] < 0) break;
+      }
+      bool valid = loadCount == shape.loadChannels;
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+      // Load channels link back to themselves and keep the bus busy until
+      // they are disabled.
+      for (int i = 0; valid && i < loadCount; i++) {
+        DmacDescriptor *desc = ch::getBaseDescriptor(load[i]);
+        setCopy_(desc, shape.loadSource, shape.loadDestination, 
+          shape.loadLength, 4, DMAC_BTCTRL_BLOCKACT_NOACT);
+        desc->DESCADDR.reg = (uintptr_t)desc;
+        DMAC->Channel[load[i]].CHINTENCLR.reg = DMAC_CHINTENCLR_MASK;
+        ch::setPeripheral(LINK_NONE, load[i]);
+        ch::setTransferMode(MODE_TRANSFER_ALL, load[i]);
+        ch::setState(STATE_ACTIVE, load[i]);
+      }
+
+      const uint32_t prictrl = DMAC->PRICTRL0.reg;
+      DMAC->Channel[index].CHINTENCLR.reg = DMAC_CHINTENCLR_MASK;
+      bool found = false;
+      char line[96];
+      if (valid && writer) {
+        writer("burst,threshold,qos,rr,worst,mean");
+      }
+      for (int m = 0; valid && m < (int)(sizeof(MODE_REF) / sizeof(int)); m++) {
+        for (int t = 0; t < (int)(sizeof(THRESHOLD_REF) / sizeof(int)) 
+          && THRESHOLD_REF[t] <= MODE_REF[m]; t++) {
+          ch::setState(STATE_DISABLED, index);
+          ch::setPeripheral(LINK_NONE, index);
+          ch::setTransferMode((TRANSFER_MODE)MODE_REF[m], index);
+          DMAC->Channel[index].CHCTRLA.bit.THRESHOLD = t;
+
+          for (int qos = 0; qos <= DMA_QOS_MAX; qos++) {
+            for (int rr = 0; rr < (loadCount > 1 ? 2 : 1); rr++) {
+              setPrictrl_(prictrl, shape.prilvl, qos, rr);
+              uint32_t worst, mean;
+              if (!measure_(index, shape, worst, mean)) {
+                valid = false;
+                break;
+              }
+              if (writer) {
+                snprintf(line, sizeof(line), "%d,%d,%d,%d,%lu,%lu", MODE_REF[m],
+                  THRESHOLD_REF[t], qos, rr, (unsigned long)worst, 
+                  (unsigned long)mean);
+                writer(line);
+              }
+              if (!found || worst < best.worstCycles || (worst == best.worstCycles
+                && mean < best.meanCycles)) {
+                best.mode = (TRANSFER_MODE)MODE_REF[m];
+                best.threshold = THRESHOLD_REF[t];
+                best.qos = qos;
+                best.roundRobin = rr;
+                best.worstCycles = worst;
+                best.meanCycles = mean;
+                found = true;
+              }
+            }
+            if (!valid) break;
+          }
+          if (!valid) break;
+        }
+      }
+
+      DMAC->PRICTRL0.reg = prictrl;
+      for (int i = 0; i < loadCount; i++) {
+        ch::setState(STATE_DISABLED, load[i]);
+        allocCtrl::release(load[i]);
+      }
+      ch::setState(STATE_DISABLED, index);
+      allocCtrl::release(index);
+      return valid && found;
+    }
+
+    bool tune::emit(const tuneShape &shape, const tuneResult &result,
+      statsWriterType writer) {
+      if (!writer) {
+        return false;
+      }
+      char line[128];
+      writer("#pragma once");
+      writer("#include <dma_core.h>");
+      writer("");
+      snprintf(line, sizeof(line), "// worst %lu cycles, mean %lu cycles, "
+        "%d beats of %d bytes, %d load channels", 
+        (unsigned long)result.worstCycles, (unsigned long)result.meanCycles,
+        shape.length, shape.beatSize, shape.loadChannels);
+      writer(line);
+      writer("namespace dma_tuned {");
+      snprintf(line, sizeof(line), "  using channel = samc::dma::channelConfig<"
+        "(samc::dma::PERIPHERAL_LINK)%d, samc::dma::MODE_TRANSFER_%dVALUE, "
+        "%d, false, %d>;", (int)shape.link, (int)result.mode, shape.prilvl, 
+        result.threshold);
+      writer(line);
+      snprintf(line, sizeof(line), "  static constexpr int prilvl = %d;",
+        shape.prilvl);
+      writer(line);
+      snprintf(line, sizeof(line), "  static constexpr int qos = %d;", 
+        result.qos);
+      writer(line);
+      snprintf(line, sizeof(line), "  static constexpr bool loadRoundRobin = %s;",
+        result.roundRobin ? "true" : "false");
+      writer(line);
+      writer("}");
+      return true;
+    }
+
+  }
+
+}
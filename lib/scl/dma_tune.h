@@ -0,0 +1,57 @@
+
+#pragma once
+#include <sam.h>
+#include <dma_core.h>
+
+namespace samc {
+
+  namespace dma {
+
+    #define DMA_TUNE_MAX_LOAD 4
+    #define DMA_TUNE_TIMEOUT 1000000
+
+    // Transfer under test plus the background load competing with it. The
+    // measured copy runs on its own channel at prilvl, load channels copy
+    // loadLength words in a loop on priority level 0.
+    struct tuneShape {
+      const void *source;
+      void *destination;
+      int length;
+      int beatSize = 4;
+      int prilvl = DMA_PRILVL_COUNT - 1;
+      PERIPHERAL_LINK link = LINK_NONE;
+      int loadChannels = 0;
+      const void *loadSource = nullptr;
+      void *loadDestination = nullptr;
+      int loadLength = 0;
+      int repetitions = 16;
+    };
+
+    struct tuneResult {
+      TRANSFER_MODE mode;
+      int threshold;
+      int qos;
+      bool roundRobin;
+      uint32_t worstCycles;
+      uint32_t meanCycles;
+    };
+
+    namespace tune {
+
+      // Sweeps BURSTLEN, THRESHOLD, the QoS of the measured level and
+      // round-robin on the load level. Each row runs burst-triggered, as the
+      // channelConfig emit writes does, with software repeating the trigger.
+      // The winner has the lowest worst-case latency, mean latency breaks
+      // ties. Each row is passed to writer.
+      bool run(const tuneShape &shape, tuneResult &best,
+        statsWriterType writer = nullptr);
+
+      // Writes the result as a header holding a channelConfig alias and the
+      // PRICTRL0 values to go with it.
+      bool emit(const tuneShape &shape, const tuneResult &result,
+        statsWriterType writer);
+    }
+
+  }
+
+}
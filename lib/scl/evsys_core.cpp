@@ -0,0 +1,130 @@
+#include "evsys_core.h"
+
+namespace {
+
+  static uint32_t allocMask = 0;
+
+  static Tc *const TC_REF[] = TC_INSTS;
+  static Adc *const ADC_REF[] = ADC_INSTS;
+
+  static const int TC_OVF_GEN[] = {
+    EVSYS_ID_GEN_TC0_OVF, EVSYS_ID_GEN_TC1_OVF, EVSYS_ID_GEN_TC2_OVF,
+    EVSYS_ID_GEN_TC3_OVF,
+    #ifdef TC4
+      EVSYS_ID_GEN_TC4_OVF, EVSYS_ID_GEN_TC5_OVF,
+    #endif
+    #ifdef TC6
+      EVSYS_ID_GEN_TC6_OVF, EVSYS_ID_GEN_TC7_OVF,
+    #endif
+  };
+  static const int ADC_START_USER[] = {
+    EVSYS_ID_USER_ADC0_START, EVSYS_ID_USER_ADC1_START
+  };
+
+}
+
+namespace samc {
+
+  namespace evsys {
+
+    // Routes are asynchronous, so they take the highest free channels and
+    // leave the low ones (the only ones with sync paths) available.
+    int allocChannel(const int &generator, const bool &runStandby) {
+      if (generator <= 0) {
+        return EVSYS_NO_CHANNEL;
+      }
+      int index;
+      {
+        const uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        const uint32_t freeMask = ~allocMask & (EVSYS_CHANNELS >= 32 
+          ? 0xFFFFFFFFUL : (1UL << EVSYS_CHANNELS) - 1);
+        if (!freeMask) {
+          __set_PRIMASK(primask);
+          return EVSYS_NO_CHANNEL;
+        }
+        index = 31 - __builtin_clz(freeMask);
+        allocMask |= 1UL << index;
+        __set_PRIMASK(primask);
+      }
+      MCLK->APBBMASK.reg |= MCLK_APBBMASK_EVSYS;
+      EVSYS->Channel[index].CHANNEL.reg = EVSYS_CHANNEL_EVGEN(generator)
+        | EVSYS_CHANNEL_PATH(EVSYS_CHANNEL_PATH_ASYNCHRONOUS_Val)
+        | (runStandby ? EVSYS_CHANNEL_RUNSTDBY : 0);
+      return index;
+    }
+
+    bool releaseChannel(const int &channel) {
+      if (channel < 0 || channel >= EVSYS_CHANNELS 
+        || !(allocMask & (1UL << channel))) {
+        return false;
+      }
+      for (int i = 0; i < EVSYS_USERS; i++) {
+        if (EVSYS->USER[i].reg == EVSYS_USER_CHANNEL(channel + 1)) {
+          EVSYS->USER[i].reg = 0;
+        }
+      }
+      EVSYS->Channel[channel].CHANNEL.reg = 0;
+      allocMask &= ~(1UL << channel);
+      return true;
+    }
+
+    uint32_t getAllocated() {
+      return allocMask;
+    }
+
+    bool setUser(const int &user, const int &channel) {
+      if (user < 0 || user >= EVSYS_USERS || channel < EVSYS_NO_CHANNEL
+        || channel >= EVSYS_CHANNELS) {
+        return false;
+      }
+      EVSYS->USER[user].reg = EVSYS_USER_CHANNEL(channel + 1);
+      return true;
+    }
+
+    int route(const int &generator, const int &user) {
+      const int channel = allocChannel(generator);
+      if (channel == EVSYS_NO_CHANNEL) {
+        return EVSYS_NO_CHANNEL;
+      }
+      if (!setUser(user, channel)) {
+        releaseChannel(channel);
+        return EVSYS_NO_CHANNEL;
+      }
+      return channel;
+    }
+
+    int setSampling_(const int &tcIndex, const int &adcIndex) {
+      const int channel = route(TC_OVF_GEN[tcIndex], ADC_START_USER[adcIndex]);
+      if (channel == EVSYS_NO_CHANNEL) {
+        return EVSYS_NO_CHANNEL;
+      }
+      // EVCTRL is enable-protected on both peripherals.
+      Tc *timer = TC_REF[tcIndex];
+      const bool timerEnabled = timer->COUNT16.CTRLA.bit.ENABLE;
+      if (timerEnabled) {
+        timer->COUNT16.CTRLA.bit.ENABLE = 0;
+        while(timer->COUNT16.SYNCBUSY.bit.ENABLE);
+      }
+      timer->COUNT16.EVCTRL.bit.OVFEO = 1;
+      if (timerEnabled) {
+        timer->COUNT16.CTRLA.bit.ENABLE = 1;
+        while(timer->COUNT16.SYNCBUSY.bit.ENABLE);
+      }
+      Adc *adc = ADC_REF[adcIndex];
+      const bool adcEnabled = adc->CTRLA.bit.ENABLE;
+      if (adcEnabled) {
+        adc->CTRLA.bit.ENABLE = 0;
+        while(adc->SYNCBUSY.bit.ENABLE);
+      }
+      adc->EVCTRL.bit.STARTEI = 1;
+      if (adcEnabled) {
+        adc->CTRLA.bit.ENABLE = 1;
+        while(adc->SYNCBUSY.bit.ENABLE);
+      }
+      return channel;
+    }
+
+  }
+
+}
@@ -0,0 +1,50 @@
+
+#pragma once
+#include <sam.h>
+#include <dma_core.h>
+
+namespace samc {
+
+  namespace evsys {
+
+    #define EVSYS_NO_CHANNEL -1
+
+    int allocChannel(const int &generator, const bool &runStandby = false);
+    bool releaseChannel(const int &channel);
+    uint32_t getAllocated();
+
+    bool setUser(const int &user, const int &channel);
+    int route(const int &generator, const int &user);
+
+    int setSampling_(const int &tcIndex, const int &adcIndex);
+
+    // Timer overflow starts an ADC conversion and RESRDY moves one beat on
+    // the DMA channel, so no interrupt is taken per sample. Returns the EVSYS
+    // channel used, the DMA channel still needs its tasks. Fails if the DMA
+    // channel is already reserved.
+    template<int dmaIndex, int tcIndex, int adcIndex = 0>
+    int setSamplingChain() {
+      static_assert(tcIndex >= 0 && tcIndex < TC_INST_NUM,
+        "evsys: timer index out of range");
+      static_assert(adcIndex >= 0 && adcIndex < ADC_INST_NUM,
+        "evsys: adc index out of range");
+      using config = dma::channelConfig<adcIndex ? dma::LINK_ADC1_RESRDY 
+        : dma::LINK_ADC0_RESRDY, dma::MODE_TRANSFER_1VALUE>;
+
+      if (!dma::allocCtrl::reserve(dmaIndex, "evsys sampling")) {
+        return EVSYS_NO_CHANNEL;
+      }
+      if (!dma::channelCtrl<dmaIndex>().template setConfig<config>()) {
+        dma::allocCtrl::release(dmaIndex);
+        return EVSYS_NO_CHANNEL;
+      }
+      const int channel = setSampling_(tcIndex, adcIndex);
+      if (channel == EVSYS_NO_CHANNEL) {
+        dma::allocCtrl::release(dmaIndex);
+      }
+      return channel;
+    }
+
+  }
+
+}
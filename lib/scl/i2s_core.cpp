@@ -0,0 +1,84 @@
+#include "i2s_core.h"
+
+namespace {
+
+  static int slotVal_(const int &bits) {
+    return bits == 8 ? 0 : bits == 16 ? 1 : bits == 24 ? 2 : bits == 32 ? 3 : -1;
+  }
+
+  static int dataVal_(const int &bits) {
+    return bits == 32 ? I2S_RXCTRL_DATASIZE_32_Val 
+      : bits == 24 ? I2S_RXCTRL_DATASIZE_24_Val
+      : bits == 16 ? I2S_RXCTRL_DATASIZE_16_Val 
+      : bits == 8 ? I2S_RXCTRL_DATASIZE_8_Val : -1;
+  }
+
+  static void sync_() {
+    while(I2S->SYNCBUSY.reg);
+  }
+
+}
+
+namespace samc {
+
+  namespace i2s {
+
+    bool setInit(const rxConfig &config) {
+      const int slotVal = slotVal_(config.slotSize);
+      const int dataVal = dataVal_(config.dataSize);
+      if (slotVal < 0 || dataVal < 0 || config.dataSize > config.slotSize
+        || config.slots < 1 || config.slots > 8 || config.gclkGen < -1 
+        || config.gclkGen >= GCLK_GEN_NUM || config.sckDiv < 1 
+        || config.sckDiv > 64) {
+        return false;
+      }
+      MCLK->APBDMASK.reg |= MCLK_APBDMASK_I2S;
+      I2S->CTRLA.reg = I2S_CTRLA_SWRST;
+      sync_();
+
+      const bool master = config.gclkGen != -1;
+      if (master) {
+        GCLK->PCHCTRL[I2S_GCLK_ID_0].reg = GCLK_PCHCTRL_GEN(config.gclkGen)
+          | GCLK_PCHCTRL_CHEN;
+        while(!(GCLK->PCHCTRL[I2S_GCLK_ID_0].reg & GCLK_PCHCTRL_CHEN));
+      }
+      I2S->CLKCTRL[0].reg = I2S_CLKCTRL_SLOTSIZE(slotVal)
+        | I2S_CLKCTRL_NBSLOTS(config.slots - 1)
+        | I2S_CLKCTRL_FSWIDTH(I2S_CLKCTRL_FSWIDTH_HALF_Val)
+        | I2S_CLKCTRL_BITDELAY
+        | (master ? I2S_CLKCTRL_MCKDIV(config.sckDiv - 1)
+          : I2S_CLKCTRL_SCKSEL | I2S_CLKCTRL_FSSEL);
+      I2S->RXCTRL.reg = I2S_RXCTRL_SERMODE(I2S_RXCTRL_SERMODE_RX_Val)
+        | I2S_RXCTRL_DATASIZE(dataVal)
+        | I2S_RXCTRL_SLOTADJ;
+      I2S->INTFLAG.reg = I2S_INTFLAG_RXOR0 | I2S_INTFLAG_RXOR1;
+      return true;
+    }
+
+    bool setEnabled(const bool &enabled) {
+      if (enabled) {
+        I2S->CTRLA.reg |= I2S_CTRLA_ENABLE | I2S_CTRLA_CKEN0 | I2S_CTRLA_RXEN;
+      } else {
+        I2S->CTRLA.reg &= ~(I2S_CTRLA_ENABLE | I2S_CTRLA_CKEN0 | I2S_CTRLA_RXEN);
+      }
+      sync_();
+      return true;
+    }
+    bool getEnabled() {
+      return I2S->CTRLA.reg & I2S_CTRLA_ENABLE;
+    }
+
+    const volatile uint32_t *getSource() {
+      return &I2S->RXDATA.reg;
+    }
+
+    bool getOverrun() {
+      const uint16_t flags = I2S->INTFLAG.reg & (I2S_INTFLAG_RXOR0 
+        | I2S_INTFLAG_RXOR1);
+      I2S->INTFLAG.reg = flags;
+      return flags;
+    }
+
+  }
+
+}
@@ -0,0 +1,58 @@
+
+#pragma once
+#include <sam.h>
+#include <dma_core.h>
+
+namespace samc {
+
+  namespace i2s {
+
+    // Receive side on clock unit 0. slotSize and dataSize are in bits (8,
+    // 16, 24 or 32), slots is the frame width (2 for stereo, up to 8 for 
+    // TDM). With gclkGen at -1 SCK and FS come from the pins, otherwise the
+    // unit drives them with SCK = GCLK / sckDiv.
+    struct rxConfig {
+      int slotSize = 32;
+      int dataSize = 32;
+      int slots = 2;
+      int gclkGen = -1;
+      int sckDiv = 1;
+    };
+
+    bool setInit(const rxConfig &config);
+    bool setEnabled(const bool &enabled);
+    bool getEnabled();
+
+    const volatile uint32_t *getSource();
+
+    // Latches and clears the receiver's overrun flag. A multiBuffer that 
+    // laps its consumer reports through its own getOverrun().
+    bool getOverrun();
+
+    // Every RXRDY moves one word into the ring, so each slot costs one beat:
+    // 48 kHz x 8 slots is 384 k beats/s, a small share of one channel. That
+    // is a budget, checked on the host model only; use sys::dumpStats 
+    // (DMA_STATS_ENABLED) to measure the sustained rate on a part.
+    // Fails if the DMA channel is already reserved. On success the channel
+    // is enabled and waits for RXRDY, so start the receiver afterwards.
+    template<int dmaIndex>
+    bool setCapture(dma::multiBuffer &buffer) {
+      static_assert(dmaIndex >= 0 && dmaIndex < DMAC_CH_NUM,
+        "i2s: dma channel index out of range");
+      using config = dma::channelConfig<dma::LINK_I2S_RX0, 
+        dma::MODE_TRANSFER_1VALUE, DMA_PRILVL_COUNT - 1>;
+
+      if (!dma::allocCtrl::reserve(dmaIndex, "i2s rx")) {
+        return false;
+      }
+      if (!dma::channelCtrl<dmaIndex>().template setConfig<config>()
+        || !buffer.attach(dmaIndex)) {
+        dma::allocCtrl::release(dmaIndex);
+        return false;
+      }
+      return dma::channelCtrl<dmaIndex>().setState(dma::STATE_IDLE);
+    }
+
+  }
+
+}
@@ -0,0 +1,49 @@
+#include "pcc_core.h"
+
+namespace samc {
+
+  namespace pcc {
+
+    bool setInit(const pccConfig &config) {
+      const int isize = config.dataBits == 8 ? 0 : config.dataBits == 10 ? 1
+        : config.dataBits == 12 ? 2 : config.dataBits == 14 ? 3 : -1;
+      const int bytes = config.packing * (config.dataBits > 8 ? 2 : 1);
+      const int dsize = bytes == 1 ? 0 : bytes == 2 ? 1 : bytes == 4 ? 2 : -1;
+      if (isize < 0 || dsize < 0) {
+        return false;
+      }
+      MCLK->APBDMASK.reg |= MCLK_APBDMASK_PCC;
+      PCC->MR.reg = 0;
+      // SCALE packs narrow samples into the wider DSIZE word.
+      PCC->MR.reg = PCC_MR_ISIZE(isize)
+        | PCC_MR_DSIZE(dsize)
+        | (config.packing > 1 ? PCC_MR_SCALE : 0)
+        | (config.alwaysSample ? PCC_MR_ALWYS : 0)
+        | (config.halfSample ? PCC_MR_HALFS : 0);
+      (void)PCC->ISR.reg;
+      return true;
+    }
+
+    bool setEnabled(const bool &enabled) {
+      if (enabled) {
+        PCC->MR.reg |= PCC_MR_PCEN;
+      } else {
+        PCC->MR.reg &= ~PCC_MR_PCEN;
+      }
+      return true;
+    }
+    bool getEnabled() {
+      return PCC->MR.reg & PCC_MR_PCEN;
+    }
+
+    const volatile uint32_t *getSource() {
+      return &PCC->RHR.reg;
+    }
+
+    bool getOverrun() {
+      return PCC->ISR.reg & PCC_ISR_OVRE;
+    }
+
+  }
+
+}
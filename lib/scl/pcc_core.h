@@ -0,0 +1,63 @@
+
+#pragma once
+#include <sam.h>
+#include <dma_core.h>
+
+namespace samc {
+
+  namespace pcc {
+
+    // dataBits is the parallel bus width (8, 10, 12 or 14). Narrow samples
+    // are packed into each RHR word, packing is the samples per word (1, 2
+    // or 4, at most 2 above 8 bits). With alwaysSample false the DEN pins
+    // gate sampling, otherwise every PCLK edge is taken.
+    struct pccConfig {
+      int dataBits = 8;
+      int packing = 4;
+      bool alwaysSample = true;
+      bool halfSample = false;
+    };
+
+    bool setInit(const pccConfig &config);
+    bool setEnabled(const bool &enabled);
+    bool getEnabled();
+
+    const volatile uint32_t *getSource();
+
+    // Latches the controller's overrun flag, reading ISR clears it. A 
+    // multiBuffer that laps its consumer reports through getOverrun().
+    bool getOverrun();
+
+    // One beat per RHR word, so an 8-bit bus packed 4 to a word at 10 MS/s
+    // needs 2.5 M word beats/s and 10 MB/s of SRAM bandwidth. The ring's 
+    // block interrupts are per buffer, not per sample. That is a budget, 
+    // checked on the host model only; use sys::dumpStats (DMA_STATS_ENABLED)
+    // to measure the sustained rate on the bench. The buffer elements must
+    // be the RHR word size set by setInit (packing bytes per word, twice 
+    // that above 8 bits), so call setInit first. Fails if the DMA channel is
+    // already reserved. On success the channel is enabled and waits for 
+    // DRDY, so enable the controller afterwards.
+    template<int dmaIndex>
+    bool setCapture(dma::multiBuffer &buffer) {
+      static_assert(dmaIndex >= 0 && dmaIndex < DMAC_CH_NUM,
+        "pcc: dma channel index out of range");
+      using config = dma::channelConfig<dma::LINK_PCC_RX, 
+        dma::MODE_TRANSFER_1VALUE, DMA_PRILVL_COUNT - 1>;
+
+      if (buffer.getBeatSize() != 1 << PCC->MR.bit.DSIZE) {
+        return false;
+      }
+      if (!dma::allocCtrl::reserve(dmaIndex, "pcc rx")) {
+        return false;
+      }
+      if (!dma::channelCtrl<dmaIndex>().template setConfig<config>()
+        || !buffer.attach(dmaIndex)) {
+        dma::allocCtrl::release(dmaIndex);
+        return false;
+      }
+      return dma::channelCtrl<dmaIndex>().setState(dma::STATE_IDLE);
+    }
+
+  }
+
+}
@@ -0,0 +1,447 @@
+#include "port_core.h"
+#include <Board.h>
+
+namespace {
+
+  static Tc *const TC_REF[] = TC_INSTS;
+
+  static void setTimerClock_(const int &tcIndex) {
+    switch(tcIndex) {
+      case 0: MCLK->APBAMASK.reg |= MCLK_APBAMASK_TC0; break;
+      case 1: MCLK->APBAMASK.reg |= MCLK_APBAMASK_TC1; break;
+      case 2: MCLK->APBBMASK.reg |= MCLK_APBBMASK_TC2; break;
+      case 3: MCLK->APBBMASK.reg |= MCLK_APBBMASK_TC3; break;
+      #ifdef TC4
+        case 4: MCLK->APBCMASK.reg |= MCLK_APBCMASK_TC4; break;
+        case 5: MCLK->APBCMASK.reg |= MCLK_APBCMASK_TC5; break;
+      #endif
+      #ifdef TC6
+        case 6: MCLK->APBDMASK.reg |= MCLK_APBDMASK_TC6; break;
+        case 7: MCLK->APBDMASK.reg |= MCLK_APBDMASK_TC7; break;
+      #endif
+    }
+  }
+
+  static void disableTimer_(Tc *timer) {
+    timer->COUNT16.CTRLA.bit.ENABLE = 0;
+    while(timer->COUNT16.SYNCBUSY.bit.ENABLE);
+  }
+
+  // Match frequency mode, so the counter wraps (and requests a beat) every
+  // period ticks.
+  static void setTimer_(Tc *timer, const uint16_t &period) {
+    disableTimer_(timer);
+    timer->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_PRESCALER_DIV1;
+    timer->COUNT16.WAVE.reg = TC_WAVE_WAVEGEN_MFRQ;
+    timer->COUNT16.CC[0].reg = period - 1;
+    timer->COUNT16.COUNT.reg = 0;
+    while(timer->COUNT16.SYNCBUSY.reg);
+  }
+
+  static void startTimer_(const int &tcIndex, const uint16_t &period) {
+    setTimerClock_(tcIndex);
+    Tc *timer = TC_REF[tcIndex];
+    setTimer_(timer, period);
+    timer->COUNT16.CTRLA.bit.ENABLE = 1;
+    while(timer->COUNT16.SYNCBUSY.bit.ENABLE);
+  }
+
+  // Completion is polled from CHINTFLAG, so the channel raises no interrupt.
+  // It is left idle, waiting for the timer's overflow.
+  static void setChannel_(const int &index, const int &tcIndex) {
+    using namespace samc::dma;
+    DMAC->Channel[index].CHINTENCLR.reg = DMAC_CHINTENCLR_MASK;
+    DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+    ch::setPeripheral((PERIPHERAL_LINK)(LINK_TC0_OOB + tcIndex * 3), index);
+    ch::setTransferMode(MODE_TRANSFER_1VALUE, index);
+    ch::setState(STATE_IDLE, index);
+  }
+
+}
+
+namespace samc {
+
+  namespace port {
+
+    pinGroup::pinGroup() {
+      mask = 0;
+      pinCount = 0;
+      group = -1;
+      lane = 0;
+      beatSize = 0;
+      channel = -1;
+      timer = -1;
+    }
+
+    bool pinGroup::setPins(std::initializer_list<int> pinIDs) {
+      if (channel != -1 || !pinIDs.size() || pinIDs.size() > PORT_MAX_PINS) {
+        return false;
+      }
+      int newGroup = -1;
+      uint32_t newMask = 0;
+      for (const int &id : pinIDs) {
+        if (id < 0 || id >= (int)BOARD_PIN_COUNT) {
+          return false;
+        }
+        const PIN_DESCRIPTOR &pin = BOARD_PINS[id];
+        if ((newGroup != -1 && pin.group != newGroup) 
+          || (newMask & (1UL << pin.number))) {
+          return false;
+        }
+        newGroup = pin.group;
+        newMask |= 1UL << pin.number;
+      }
+      pinCount = 0;
+      for (const int &id : pinIDs) {
+        pins[pinCount++] = BOARD_PINS[id].number;
+      }
+      group = newGroup;
+      mask = newMask;
+      const int lo = __builtin_ctz(mask);
+      const int hi = 31 - __builtin_clz(mask);
+      beatSize = lo / 8 == hi / 8 ? 1 : lo / 16 == hi / 16 ? 2 : 4;
+      lane = (lo / (beatSize * 8)) * beatSize;
+      return true;
+    }
+    int pinGroup::getBeatSize() const {
+      return beatSize;
+    }
+
+    uint32_t pinGroup::toPort_(const uint32_t &state) const {
+      uint32_t value = 0;
+      for (int i = 0; i < pinCount; i++) {
+        if (state & (1UL << i)) {
+          value |= 1UL << pins[i];
+        }
+      }
+      return value;
+    }
+    uint32_t pinGroup::toPins_(const uint32_t &value) const {
+      uint32_t state = 0;
+      for (int i = 0; i < pinCount; i++) {
+        if (value & (1UL << pins[i])) {
+          state |= 1UL << i;
+        }
+      }
+      return state;
+    }
+
+    patternGen::patternGen() {
+      startState = 0;
+      patternMask = 0;
+      buffer = nullptr;
+      length = 0;
+      looped = false;
+    }
+
+    // Each toggle is taken against the previous state, the first against
+    // the last, so a looped pattern returns to where it started. The pins 
+    // are parked on the last state before playback.
+    bool patternGen::setPattern(const uint32_t *states, void *buffer, 
+      const int &length) {
+      if (channel != -1 || !pinCount || !states || !buffer || length <= 0 
+        || length > 0xFFFF || ((uintptr_t)buffer & (beatSize - 1))) {
+        return false;
+      }
+      uint32_t prev = toPort_(states[length - 1]);
+      for (int i = 0; i < length; i++) {
+        const uint32_t value = toPort_(states[i]);
+        const uint32_t toggle = (value ^ prev) >> (lane * 8);
+        prev = value;
+        if (beatSize == 1) {
+          ((uint8_t*)buffer)[i] = (uint8_t)toggle;
+        } else if (beatSize == 2) {
+          ((uint16_t*)buffer)[i] = (uint16_t)toggle;
+        } else {
+          ((uint32_t*)buffer)[i] = toggle;
+        }
+      }
+      startState = prev;
+      patternMask = mask;
+      this->buffer = buffer;
+      this->length = length;
+      return true;
+    }
+
+    bool patternGen::start(const int &tcIndex, const uint16_t &period, 
+      const bool &looped) {
+      if (channel != -1 || !buffer || patternMask != mask || tcIndex < 0 
+        || tcIndex >= TC_INST_NUM || !period) {
+        return false;
+      }
+      const int index = dma::allocCtrl::allocate(DMA_PRILVL_COUNT - 1, false, 
+        "pattern");
+      if (index < 0) {
+        return false;
+      }
+      PortGroup &port = PORT->Group[group];
+      port.OUTSET.reg = startState & mask;
+      port.OUTCLR.reg = ~startState & mask;
+      port.DIRSET.reg = mask;
+
+      DmacDescriptor *desc = dma::ch::getBaseDescriptor(index);
+      desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC
+        | DMAC_BTCTRL_BEATSIZE(beatSize >> 1)
+        | DMAC_BTCTRL_BLOCKACT(looped ? DMAC_BTCTRL_BLOCKACT_NOACT_Val 
+          : DMAC_BTCTRL_BLOCKACT_INT_Val);
+      desc->BTCNT.reg = length;
+      desc->SRCADDR.reg = (uintptr_t)buffer + length * beatSize;
+      desc->DSTADDR.reg = (uintptr_t)&port.OUTTGL.reg + lane;
+      desc->DESCADDR.reg = looped ? (uintptr_t)desc : 0;
+
+      setChannel_(index, tcIndex);
+      startTimer_(tcIndex, period);
+
+      channel = index;
+      timer = tcIndex;
+      this->looped = looped;
+      return true;
+    }
+
+    // Pins are left on whatever state was last written.
+    bool patternGen::stop() {
+      if (channel == -1) {
+        return false;
+      }
+      disableTimer_(TC_REF[timer]);
+      dma::ch::setState(dma::STATE_DISABLED, channel);
+      dma::allocCtrl::release(channel);
+      channel = -1;
+      timer = -1;
+      return true;
+    }
+
+    bool patternGen::getDone() {
+      if (channel == -1) {
+        return true;
+      }
+      return !looped && (DMAC->Channel[channel].CHINTFLAG.reg 
+        & (DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR));
+    }
+
+    int patternGen::getChannel() const {
+      return channel;
+    }
+
+    patternGen::~patternGen() {
+      stop();
+    }
+
+
+    logicCapture::logicCapture() {
+      ring = nullptr;
+      length = 0;
+      triggerMask = 0;
+      triggerValue = 0;
+      preTrigger = 0;
+      postTrigger = 0;
+      total = 0;
+      triggerAt = 0;
+      lastIndex = 0;
+      savedDir = 0;
+      savedCtrl = 0;
+      savedInen = 0;
+      lastMatch = false;
+      triggered = false;
+      done = false;
+      overrun = false;
+    }
+
+    bool logicCapture::setBuffer(void *ring, const int &length) {
+      if (channel != -1 || !pinCount || !ring || length < 2 || length > 0xFFFF
+        || ((uintptr_t)ring & (beatSize - 1)) 
+        || preTrigger + postTrigger > length) {
+        return false;
+      }
+      this->ring = ring;
+      this->length = length;
+      return true;
+    }
+
+    bool logicCapture::setTrigger(const uint32_t &mask, const uint32_t &value,
+      const int &preTrigger, const int &postTrigger) {
+      if (channel != -1 || preTrigger < 0 || postTrigger < 1 
+        || (ring && preTrigger + postTrigger > length)) {
+        return false;
+      }
+      triggerMask = mask;
+      triggerValue = value & mask;
+      this->preTrigger = preTrigger;
+      this->postTrigger = postTrigger;
+      return true;
+    }
+
+    // Pins are switched to inputs with continuous sampling, so IN is 
+    // current on every beat without the on-demand sampling delay.
+    bool logicCapture::start(const int &tcIndex, const uint16_t &period) {
+      if (channel != -1 || !ring || postTrigger < 1 || tcIndex < 0 
+        || tcIndex >= TC_INST_NUM || !period) {
+        return false;
+      }
+      const int index = dma::allocCtrl::allocate(DMA_PRILVL_COUNT - 1, false, 
+        "capture");
+      if (index < 0) {
+        return false;
+      }
+      PortGroup &port = PORT->Group[group];
+      savedDir = port.DIR.reg & mask;
+      savedCtrl = port.CTRL.reg & mask;
+      savedInen = 0;
+      port.DIRCLR.reg = mask;
+      for (int i = 0; i < pinCount; i++) {
+        savedInen |= (uint32_t)port.PINCFG[pins[i]].bit.INEN << pins[i];
+        port.PINCFG[pins[i]].bit.INEN = 1;
+      }
+      port.CTRL.reg |= mask;
+
+      DmacDescriptor *desc = dma::ch::getBaseDescriptor(index);
+      desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_DSTINC
+        | DMAC_BTCTRL_BEATSIZE(beatSize >> 1)
+        | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_NOACT_Val);
+      desc->BTCNT.reg = length;
+      desc->SRCADDR.reg = (uintptr_t)&port.IN.reg + lane;
+      desc->DSTADDR.reg = (uintptr_t)ring + length * beatSize;
+      desc->DESCADDR.reg = (uintptr_t)desc;
+
+      total = 0;
+      triggerAt = 0;
+      lastIndex = 0;
+      lastMatch = false;
+      triggered = false;
+      done = false;
+      overrun = false;
+      channel = index;
+      timer = tcIndex;
+      setChannel_(index, tcIndex);
+      startTimer_(tcIndex, period);
+      return true;
+    }
+
+    // Same derivation as ringBuffer: ACTIVE holds the live count while the
+    // channel owns the bus, otherwise the write-back descriptor is current.
+    int logicCapture::getWriteIndex_() {
+      const uint32_t active = DMAC->ACTIVE.reg;
+      int remaining;
+      if ((active & DMAC_ACTIVE_ABUSY) && (int)((active & DMAC_ACTIVE_ID_Msk)
+        >> DMAC_ACTIVE_ID_Pos) == channel) {
+        remaining = (active & DMAC_ACTIVE_BTCNT_Msk) >> DMAC_ACTIVE_BTCNT_Pos;
+      } else {
+        const DmacDescriptor *wb = dma::ch::getWritebackDescriptor(channel);
+        if (wb->DSTADDR.reg != (uintptr_t)ring + length * beatSize) {
+          return lastIndex;
+        }
+        remaining = wb->BTCNT.reg;
+      }
+      return (length - remaining) % length;
+    }
+
+    uint32_t logicCapture::read_(const int &ringIndex) const {
+      const uint8_t *data = (const uint8_t*)ring + ringIndex * beatSize;
+      const uint32_t value = beatSize == 1 ? *data 
+        : beatSize == 2 ? *(const uint16_t*)data : *(const uint32_t*)data;
+      return toPins_(value << (lane * 8));
+    }
+
+    bool logicCapture::poll() {
+      if (channel == -1) {
+        return done;
+      }
+      const int index = getWriteIndex_();
+      int pending = (index - lastIndex + length) % length;
+      for (; pending > 0 && !triggered; pending--) {
+        const bool match = (read_(lastIndex) & triggerMask) == triggerValue;
+        if (match && (!lastMatch || !triggerMask) && total >= (uint32_t)preTrigger) {
+          triggered = true;
+          triggerAt = total;
+        }
+        lastMatch = match;
+        lastIndex = (lastIndex + 1) % length;
+        total++;
+      }
+      total += pending;
+      lastIndex = index;
+      if (triggered && total - triggerAt >= (uint32_t)postTrigger) {
+        disableTimer_(TC_REF[timer]);
+        dma::ch::setState(dma::STATE_DISABLED, channel);
+        // Anything written past the window has lapped into its history.
+        total += (getWriteIndex_() - lastIndex + length) % length;
+        stop();
+        overrun = total - (triggerAt - preTrigger) > (uint32_t)length;
+        done = true;
+      }
+      return done;
+    }
+
+    bool logicCapture::stop() {
+      if (channel == -1) {
+        return false;
+      }
+      disableTimer_(TC_REF[timer]);
+      dma::ch::setState(dma::STATE_DISABLED, channel);
+      dma::allocCtrl::release(channel);
+      PortGroup &port = PORT->Group[group];
+      port.CTRL.reg = (port.CTRL.reg & ~mask) | savedCtrl;
+      for (int i = 0; i < pinCount; i++) {
+        port.PINCFG[pins[i]].bit.INEN = (savedInen >> pins[i]) & 1;
+      }
+      port.DIRSET.reg = savedDir;
+      channel = -1;
+      timer = -1;
+      return true;
+    }
+
+    bool logicCapture::getTriggered() const {
+      return triggered;
+    }
+    bool logicCapture::getDone() const {
+      return done;
+    }
+    bool logicCapture::getOverrun() const {
+      return overrun;
+    }
+    int logicCapture::getChannel() const {
+      return channel;
+    }
+
+    int logicCapture::getLength() const {
+      return done ? preTrigger + postTrigger : 0;
+    }
+
+    uint32_t logicCapture::getSample(const int &sampleIndex) const {
+      if (sampleIndex < 0 || sampleIndex >= getLength()) {
+        return 0;
+      }
+      return read_((triggerAt - preTrigger + sampleIndex) % length);
+    }
+
+    // Run-length encodes the window, returns the number of runs written or
+    // -1 if they do not fit.
+    int logicCapture::getRuns(captureRun *runs, const int &maxRuns) const {
+      const int count = getLength();
+      if (!runs || !count) {
+        return 0;
+      }
+      int written = 0;
+      for (int i = 0; i < count; i++) {
+        const uint32_t state = getSample(i);
+        if (written && runs[written - 1].state == state) {
+          runs[written - 1].count++;
+          continue;
+        }
+        if (written == maxRuns) {
+          return -1;
+        }
+        runs[written].state = state;
+        runs[written].count = 1;
+        written++;
+      }
+      return written;
+    }
+
+    logicCapture::~logicCapture() {
+      stop();
+    }
+
+  }
+
+}
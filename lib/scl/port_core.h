@@ -0,0 +1,125 @@
+
+#pragma once
+#include <sam.h>
+#include <initializer_list>
+#include <dma_core.h>
+
+namespace samc {
+
+  namespace port {
+
+    #define PORT_MAX_PINS 32
+
+    // A set of BOARD_PINS sharing one PORT group. Bit i of a state is the
+    // i-th pin, DMA beats are narrowed to the byte or halfword lane holding 
+    // the pins.
+    class pinGroup {
+      public:
+        bool setPins(std::initializer_list<int> pinIDs);
+        int getBeatSize() const;
+
+      protected:
+        pinGroup();
+        uint32_t toPort_(const uint32_t&) const;
+        uint32_t toPins_(const uint32_t&) const;
+        uint8_t pins[PORT_MAX_PINS];
+        uint32_t mask;
+        int8_t pinCount;
+        int8_t group;
+        int8_t lane;
+        int8_t beatSize;
+        int8_t channel;
+        int8_t timer;
+    };
+
+
+    // Streams pin states onto the group, one beat per timer overflow. Beats
+    // are written to OUTTGL so pins outside the set are never touched.
+    class patternGen : public pinGroup {
+      public:
+        patternGen();
+
+        // Converts states into toggles, buffer holds length beats of 
+        // getBeatSize() bytes and must outlive playback.
+        bool setPattern(const uint32_t *states, void *buffer, const int &length);
+
+        // The timer's generic clock must be running, a beat is written every
+        // period ticks of it.
+        bool start(const int &tcIndex, const uint16_t &period, 
+          const bool &looped);
+        bool stop();
+        bool getDone();
+        int getChannel() const;
+
+        ~patternGen();
+
+      protected:
+        uint32_t startState;
+        uint32_t patternMask;
+        void *buffer;
+        int length;
+        bool looped;
+    };
+
+
+    struct captureRun {
+      uint32_t state;
+      uint32_t count;
+    };
+
+    // Samples the group's IN register into a ring, one beat per timer 
+    // overflow. poll() scans new samples for the trigger and must run at
+    // least once per lap of the ring. The pins' direction, input enable and
+    // continuous sampling are put back as they were on stop.
+    class logicCapture : public pinGroup {
+      public:
+        logicCapture();
+
+        // Holds length beats of getBeatSize() bytes.
+        bool setBuffer(void *ring, const int &length);
+
+        // Triggers when the masked state turns to value, with preTrigger 
+        // samples of history. A zero mask triggers once history is full.
+        bool setTrigger(const uint32_t &mask, const uint32_t &value,
+          const int &preTrigger, const int &postTrigger);
+
+        bool start(const int &tcIndex, const uint16_t &period);
+        bool poll();
+        bool stop();
+
+        bool getTriggered() const;
+        bool getDone() const;
+        bool getOverrun() const;
+        int getChannel() const;
+
+        // Samples of the captured window, oldest first, as pin states.
+        int getLength() const;
+        uint32_t getSample(const int &sampleIndex) const;
+        int getRuns(captureRun *runs, const int &maxRuns) const;
+
+        ~logicCapture();
+
+      protected:
+        int getWriteIndex_();
+        uint32_t read_(const int&) const;
+        void *ring;
+        int length;
+        uint32_t triggerMask;
+        uint32_t triggerValue;
+        int preTrigger;
+        int postTrigger;
+        uint32_t total;
+        uint32_t triggerAt;
+        int lastIndex;
+        uint32_t savedDir;
+        uint32_t savedCtrl;
+        uint32_t savedInen;
+        bool lastMatch;
+        bool triggered;
+        bool done;
+        bool overrun;
+    };
+
+  }
+
+}
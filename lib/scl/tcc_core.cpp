@@ -0,0 +1,68 @@
+#include "tcc_core.h"
+
+namespace samc {
+
+  namespace tcc {
+
+    ccStream::ccStream() {
+      channel = -1;
+      looped = false;
+    }
+
+    // The head is copied into the channel's base descriptor and the tail
+    // (the head itself for a single block) is linked back to it when looped.
+    // Completion is polled from CHINTFLAG, so the channel raises no interrupt.
+    bool ccStream::start_(const dma::PERIPHERAL_LINK &link, 
+      const dma::TRANSFER_MODE &mode, const DmacDescriptor &head,
+      DmacDescriptor *tail, const bool &looped) {
+      if (channel != -1) {
+        return false;
+      }
+      const int index = dma::allocCtrl::allocate(DMA_PRILVL_COUNT - 1, false,
+        "tcc");
+      if (index < 0) {
+        return false;
+      }
+      DmacDescriptor *base = dma::ch::getBaseDescriptor(index);
+      memcpy((void*)base, &head, sizeof(DmacDescriptor));
+      (tail ? tail : base)->DESCADDR.reg = looped ? (uintptr_t)base : 0;
+
+      DMAC->Channel[index].CHINTENCLR.reg = DMAC_CHINTENCLR_MASK;
+      DMAC->Channel[index].CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+      dma::ch::setPeripheral(link, index);
+      dma::ch::setTransferMode(mode, index);
+      dma::ch::setState(dma::STATE_IDLE, index);
+      channel = index;
+      this->looped = looped;
+      return true;
+    }
+
+    bool ccStream::stop() {
+      if (channel == -1) {
+        return false;
+      }
+      dma::ch::setState(dma::STATE_DISABLED, channel);
+      dma::allocCtrl::release(channel);
+      channel = -1;
+      return true;
+    }
+
+    bool ccStream::getDone() {
+      if (channel == -1) {
+        return true;
+      }
+      return !looped && (DMAC->Channel[channel].CHINTFLAG.reg 
+        & (DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR));
+    }
+
+    int ccStream::getChannel() const {
+      return channel;
+    }
+
+    ccStream::~ccStream() {
+      stop();
+    }
+
+  }
+
+}
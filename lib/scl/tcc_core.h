@@ -0,0 +1,136 @@
+
+#pragma once
+#include <sam.h>
+#include <dma_core.h>
+
+namespace samc {
+
+  namespace tcc {
+
+    static constexpr int TCC_CC_COUNT[] = {6, 4, 3, 2, 2};
+    static constexpr int TCC_LINK_OOB[] = {
+      dma::LINK_TCC0_OOB, dma::LINK_TCC1_OOB, dma::LINK_TCC2_OOB,
+      dma::LINK_TCC3_OOB, dma::LINK_TCC4_OOB
+    };
+
+    // DMA side shared by the update modes. The TCC must already be set up 
+    // for PWM, values land in CCBUF and take effect on the next UPDATE.
+    class ccStream {
+      public:
+        bool stop();
+        bool getDone();
+        int getChannel() const;
+
+        ~ccStream();
+
+      protected:
+        ccStream();
+        bool start_(const dma::PERIPHERAL_LINK&, const dma::TRANSFER_MODE&,
+          const DmacDescriptor&, DmacDescriptor*, const bool&);
+        int8_t channel;
+        bool looped;
+    };
+
+    // One value per trigger into CCBUF[CC], so every PWM period gets its own
+    // duty cycle. Triggered on overflow, or on the channel's own compare
+    // match when ON_OVERFLOW is false.
+    template<int INST, int CC, bool ON_OVERFLOW = true>
+    class dutyStream : public ccStream {
+      static_assert(INST >= 0 && INST < TCC_INST_NUM, 
+        "dutyStream: TCC index out of range");
+      static_assert(CC >= 0 && CC < TCC_CC_COUNT[INST], 
+        "dutyStream: compare channel out of range");
+
+      public:
+        static constexpr dma::PERIPHERAL_LINK link = (dma::PERIPHERAL_LINK)
+          (TCC_LINK_OOB[INST] + (ON_OVERFLOW ? 0 : 1 + CC));
+        using config = dma::channelConfig<link, dma::MODE_TRANSFER_1VALUE, 
+          DMA_PRILVL_COUNT - 1>;
+
+        bool start(const uint32_t *duty, const int &length, const bool &looped) {
+          if (channel != -1 || !duty || length < 1 || length > UINT16_MAX) {
+            return false;
+          }
+          static Tcc *const tccRef[] = TCC_INSTS;
+          DmacDescriptor desc;
+          desc.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC
+            | DMAC_BTCTRL_BEATSIZE(DMAC_BTCTRL_BEATSIZE_WORD_Val)
+            | DMAC_BTCTRL_BLOCKACT(looped ? DMAC_BTCTRL_BLOCKACT_NOACT_Val
+              : DMAC_BTCTRL_BLOCKACT_INT_Val);
+          desc.BTCNT.reg = length;
+          desc.SRCADDR.reg = (uintptr_t)(duty + length);
+          desc.DSTADDR.reg = (uintptr_t)&tccRef[INST]->CCBUF[CC].reg;
+          desc.DESCADDR.reg = 0;
+          return start_(link, dma::MODE_TRANSFER_1VALUE, desc, nullptr, looped);
+        }
+    };
+
+    // Every overflow moves one row of duty into CCBUF[FIRST_CC] onwards, so 
+    // CHANNELS compare values change on the same period. Rows of 1, 2 or 4
+    // go as a single burst, other widths as a block per trigger. A row is a
+    // block of its own, the descriptors for rows past the first are held here.
+    // Those need 16-byte alignment, which new does not give under gnu++14, so
+    // one spare descriptor is held and the rows start at the first 16-byte
+    // boundary inside the array.
+    template<int INST, int FIRST_CC, int CHANNELS, int PERIODS>
+    class dutyBurst : public ccStream {
+      static_assert(INST >= 0 && INST < TCC_INST_NUM, 
+        "dutyBurst: TCC index out of range");
+      static_assert(FIRST_CC >= 0 && CHANNELS >= 1 
+        && FIRST_CC + CHANNELS <= TCC_CC_COUNT[INST],
+        "dutyBurst: compare channels out of range");
+      static_assert(PERIODS >= 1, "dutyBurst: at least one period is required");
+
+      public:
+        static constexpr dma::PERIPHERAL_LINK link 
+          = (dma::PERIPHERAL_LINK)TCC_LINK_OOB[INST];
+        static constexpr dma::TRANSFER_MODE mode = CHANNELS == 1 
+          || CHANNELS == 2 || CHANNELS == 4 ? (dma::TRANSFER_MODE)CHANNELS 
+          : dma::MODE_TRANSFER_TASK;
+        using config = dma::channelConfig<link, mode, DMA_PRILVL_COUNT - 1>;
+
+        bool start(const uint32_t (&duty)[PERIODS][CHANNELS], const bool &looped) {
+          if (channel != -1) {
+            return false;
+          }
+          DmacDescriptor *rows = (DmacDescriptor*)(((uintptr_t)store + 15) 
+            & ~(uintptr_t)15);
+          static Tcc *const tccRef[] = TCC_INSTS;
+          const uintptr_t dst = (uintptr_t)&tccRef[INST]->CCBUF[FIRST_CC + CHANNELS];
+          DmacDescriptor head;
+          DmacDescriptor *prev = &head;
+          for (int i = 0; i < PERIODS; i++) {
+            DmacDescriptor *desc = i ? &rows[i - 1] : &head;
+            desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC 
+              | DMAC_BTCTRL_DSTINC 
+              | DMAC_BTCTRL_BEATSIZE(DMAC_BTCTRL_BEATSIZE_WORD_Val)
+              | DMAC_BTCTRL_BLOCKACT(DMAC_BTCTRL_BLOCKACT_NOACT_Val);
+            desc->BTCNT.reg = CHANNELS;
+            desc->SRCADDR.reg = (uintptr_t)(duty[i] + CHANNELS);
+            desc->DSTADDR.reg = dst;
+            desc->DESCADDR.reg = 0;
+            if (i) {
+              prev->DESCADDR.reg = (uintptr_t)desc;
+            }
+            prev = desc;
+          }
+          if (!looped) {
+            prev->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+          }
+          return start_(link, mode, head, PERIODS > 1 ? prev : nullptr, looped);
+        }
+
+      protected:
+        DmacDescriptor store[PERIODS];
+    };
+
+    template<int INST, int CC, bool ON_OVERFLOW>
+    constexpr dma::PERIPHERAL_LINK dutyStream<INST, CC, ON_OVERFLOW>::link;
+    template<int INST, int FIRST_CC, int CHANNELS, int PERIODS>
+    constexpr dma::PERIPHERAL_LINK dutyBurst<INST, FIRST_CC, CHANNELS, PERIODS>::link;
+    template<int INST, int FIRST_CC, int CHANNELS, int PERIODS>
+    constexpr dma::TRANSFER_MODE dutyBurst<INST, FIRST_CC, CHANNELS, PERIODS>::mode;
+
+  }
+
+}
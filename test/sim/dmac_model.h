@@ -0,0 +1,675 @@
+#pragma once
+
+// Behavioural model of the SAMD51 DMAC behind the registers in sam.h.
+//
+// Channels run on the host thread from inside the register hooks: a register
+// write lets every runnable channel make progress until it goes idle, raises
+// an interrupt flag or has moved a few blocks, and a register (or CYCCNT) read
+// moves one burst, so polling loops always make progress. Raised flags are
+// dispatched straight into DMAC_n_Handler when the NVIC line is enabled and
+// PRIMASK is clear, the same way the core would take them.
+//
+// What it models: descriptor fetch and write-back, BEATSIZE, SRCINC/DSTINC,
+// STEPSEL/STEPSIZE, end-address arithmetic, BLOCKACT, DESCADDR links,
+// BLOCK/BURST/TRANSACTION trigger actions, BURSTLEN, static and round-robin
+// priority, SUSPEND/RESUME, FERR on an invalid descriptor, TERR on a bad
+// address, W1C flag registers, enable-protected CHCTRLA fields and the CRC
+// engine in I/O and channel mode. What it does not: bus contention, QoS,
+// FIFO threshold timing, events and standby; cycle counts are a fixed cost
+// per beat/burst/fetch and are only good for comparing two code paths.
+
+extern "C" {
+  void DMAC_0_Handler(void);
+  void DMAC_1_Handler(void);
+  void DMAC_2_Handler(void);
+  void DMAC_3_Handler(void);
+  void DMAC_4_Handler(void);
+}
+
+namespace sim {
+
+  enum GRANT : uint8_t {
+    GRANT_NONE,
+    GRANT_BURST,
+    GRANT_BLOCK,
+    GRANT_TRANSACTION
+  };
+
+  struct channel_ {
+    uint32_t fetchAddr;           // next descriptor, 0 selects the base descriptor
+    uint16_t total;               // BTCNT of the loaded block
+    uint8_t grant;
+    bool loaded;
+    bool pending;
+    bool swPending;
+    bool suspended;
+    bool ferr;
+    int failAfter;                // beats until an injected TERR, -1 when off
+    int kickBlocks;
+    uint32_t blocks;
+    uint32_t beats;
+  };
+
+  struct model_ {
+    channel_ ch[DMAC_CH_NUM];
+    uint32_t cycles;
+    uint32_t primask;
+    bool nvic[5];
+    bool running;
+    bool inIsr;
+    bool exclusive;               // local monitor, cleared on handler entry/exit
+    bool raised;
+    bool stuck;
+    int last[DMAC_LVL_NUM];
+    int active;
+    uint32_t interrupts;
+    uint32_t fetches;
+
+    // Fixed costs in cycles.
+    uint32_t accessCycles;
+    uint32_t beatCycles;
+    uint32_t burstCycles;
+    uint32_t fetchCycles;
+
+    int blockBudget;              // blocks per channel per register write
+  };
+
+  inline model_ fresh_() {
+    model_ value = model_();
+    for (int i = 0; i < DMAC_CH_NUM; i++) value.ch[i].failAfter = -1;
+    for (int i = 0; i < DMAC_LVL_NUM; i++) value.last[i] = DMAC_CH_NUM - 1;
+    value.active = -1;
+    value.accessCycles = 1;
+    value.beatCycles = 1;
+    value.burstCycles = 2;
+    value.fetchCycles = 4;
+    value.blockBudget = 8;
+    return value;
+  }
+
+  inline model_ &model() {
+    static model_ value = fresh_();
+    return value;
+  }
+
+  inline Dmac &dmac_() { return *DMAC; }
+  inline DmacChannel &chReg_(const int &index) { return DMAC->Channel[index]; }
+
+  template<typename T> inline T &raw_(const volatile T &value) {
+    return const_cast<T&>(value);
+  }
+
+  inline DmacDescriptor *desc_(const uint32_t &addr) {
+    return reinterpret_cast<DmacDescriptor*>(static_cast<uintptr_t>(addr));
+  }
+
+  inline uint32_t addr_(const volatile void *ptr) {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ptr));
+  }
+
+  inline DmacDescriptor &wb_(const int &index) {
+    return desc_(raw_(dmac_().WRBADDR.reg.raw))[index];
+  }
+
+  // Anything below the first 4K is treated as unmapped, which catches null
+  // and small-offset pointers that made it into a descriptor.
+  inline bool mapped_(const uint32_t &addr) { return addr >= 0x1000; }
+
+  /****************************************************************************
+   * CRC engine
+   ****************************************************************************/
+
+  // CRCCHKSUM keeps the CRC32 running value bit-reversed, as the datasheet
+  // has it, and the CRC16 one as it is.
+  inline uint32_t crcConvert_(const bool &crc32, const uint32_t &value) {
+    return crc32 ? __RBIT(value) : value & 0xFFFFu;
+  }
+
+  inline void crcFeed_(const uint32_t &data) {
+    Dmac &d = dmac_();
+    const uint16_t ctrl = raw_(d.CRCCTRL.reg.raw);
+    const bool crc32 = ((ctrl >> DMAC_CRCCTRL_CRCPOLY_Pos) & 3) == 1;
+    const int beat = ctrl & 3;
+    const int bytes = beat >= 2 ? 4 : 1 << beat;
+    uint32_t crc = crcConvert_(crc32, raw_(d.CRCCHKSUM.reg.raw));
+
+    for (int i = 0; i < bytes; i++) {
+      const uint8_t byte = data >> (8 * i);
+      if (crc32) {
+        crc ^= byte;
+        for (int k = 0; k < 8; k++) crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+      } else {
+        crc ^= uint32_t(byte) << 8;
+        for (int k = 0; k < 8; k++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        crc &= 0xFFFF;
+      }
+    }
+    crc = crcConvert_(crc32, crc);
+    raw_(d.CRCCHKSUM.reg.raw) = crc;
+
+    uint8_t &status = raw_(d.CRCSTATUS.reg.raw);
+    status |= DMAC_CRCSTATUS_CRCBUSY;
+    status = crc ? status & ~DMAC_CRCSTATUS_CRCZERO : status | DMAC_CRCSTATUS_CRCZERO;
+  }
+
+  /****************************************************************************
+   * Channel execution
+   ****************************************************************************/
+
+  inline void raise_(const int &index, const uint8_t &flag) {
+    raw_(chReg_(index).CHINTFLAG.reg.raw) |= flag;
+    model().raised = true;
+  }
+
+  inline void stop_(const int &index) {
+    channel_ &s = model().ch[index];
+    if (s.loaded && raw_(dmac_().WRBADDR.reg.raw)) {
+      wb_(index).BTCTRL.reg &= ~DMAC_BTCTRL_VALID;
+    }
+    s.fetchAddr = 0;
+    s.grant = GRANT_NONE;
+    s.loaded = false;
+    s.pending = false;
+    s.swPending = false;
+    s.suspended = false;
+    s.ferr = false;
+  }
+
+  inline void fault_(const int &index) {
+    stop_(index);
+    raw_(chReg_(index).CHCTRLA.reg.raw) &= ~DMAC_CHCTRLA_ENABLE;
+    raise_(index, DMAC_CHINTFLAG_TERR);
+  }
+
+  inline bool fetch_(const int &index) {
+    model_ &m = model();
+    channel_ &s = m.ch[index];
+    const uint32_t addr = s.fetchAddr ? s.fetchAddr
+      : raw_(dmac_().BASEADDR.reg.raw) + index * sizeof(DmacDescriptor);
+
+    if (!mapped_(addr) || (addr & 7)) {
+      fault_(index);
+      return false;
+    }
+    const volatile uint32_t *from = reinterpret_cast<const volatile uint32_t*>(desc_(addr));
+    volatile uint32_t *to = reinterpret_cast<volatile uint32_t*>(&wb_(index));
+    for (int i = 0; i < 4; i++) to[i] = from[i];
+
+    m.cycles += m.fetchCycles;
+    m.fetches++;
+    if (!(wb_(index).BTCTRL.reg & DMAC_BTCTRL_VALID)) {
+      s.ferr = true;
+      s.suspended = true;
+      s.loaded = false;
+      raise_(index, DMAC_CHINTFLAG_SUSP);
+      return false;
+    }
+    s.loaded = true;
+    s.total = wb_(index).BTCNT.reg;
+    return true;
+  }
+
+  inline uint32_t load_(const uint32_t &addr, const int &bytes) {
+    uint32_t value = 0;
+    memcpy(&value, reinterpret_cast<const void*>(static_cast<uintptr_t>(addr)), bytes);
+    return value;
+  }
+
+  inline void store_(const uint32_t &addr, const uint32_t &value, const int &bytes) {
+    Dmac &d = dmac_();
+    if (addr == addr_(&d.CRCDATAIN.reg)) {
+      raw_(d.CRCDATAIN.reg.raw) = value;
+      if (((raw_(d.CRCCTRL.reg.raw) >> DMAC_CRCCTRL_CRCSRC_Pos) & 0x3F) == DMAC_CRCCTRL_CRCSRC_IO_Val) {
+        crcFeed_(value);
+      }
+      return;
+    }
+    memcpy(reinterpret_cast<void*>(static_cast<uintptr_t>(addr)), &value, bytes);
+  }
+
+  inline void blockEnd_(const int &index) {
+    model_ &m = model();
+    channel_ &s = m.ch[index];
+    DmacDescriptor &wb = wb_(index);
+    const int action = (wb.BTCTRL.reg >> DMAC_BTCTRL_BLOCKACT_Pos) & 3;
+    const uint32_t next = wb.DESCADDR.reg;
+
+    s.blocks++;
+    s.kickBlocks++;
+    s.loaded = false;
+    if (action == DMAC_BTCTRL_BLOCKACT_INT_Val || action == DMAC_BTCTRL_BLOCKACT_BOTH_Val) {
+      raise_(index, DMAC_CHINTFLAG_TCMPL);
+    }
+    if (!next) {
+      stop_(index);
+      raw_(chReg_(index).CHCTRLA.reg.raw) &= ~DMAC_CHCTRLA_ENABLE;
+      return;
+    }
+    s.fetchAddr = next;
+    if (s.grant != GRANT_TRANSACTION) s.grant = GRANT_NONE;
+    if (action == DMAC_BTCTRL_BLOCKACT_SUSPEND_Val || action == DMAC_BTCTRL_BLOCKACT_BOTH_Val) {
+      s.suspended = true;
+      raise_(index, DMAC_CHINTFLAG_SUSP);
+      return;
+    }
+    fetch_(index);
+  }
+
+  // One arbitration unit: a burst of BURSTLEN + 1 beats, or whatever is left
+  // of the block.
+  inline void burst_(const int &index) {
+    model_ &m = model();
+    channel_ &s = m.ch[index];
+    const uint32_t ctrla = raw_(chReg_(index).CHCTRLA.reg.raw);
+
+    m.active = index;
+    if (!s.loaded && !fetch_(index)) return;
+    if (s.grant == GRANT_NONE) {
+      const int action = (ctrla & DMAC_CHCTRLA_TRIGACT_Msk) >> DMAC_CHCTRLA_TRIGACT_Pos;
+      s.grant = action == DMAC_CHCTRLA_TRIGACT_BURST_Val ? GRANT_BURST
+        : action == DMAC_CHCTRLA_TRIGACT_TRANSACTION_Val ? GRANT_TRANSACTION : GRANT_BLOCK;
+      s.pending = false;
+      s.swPending = false;
+    }
+
+    DmacDescriptor &wb = wb_(index);
+    const uint16_t btctrl = wb.BTCTRL.reg;
+    const int beat = 1 << ((btctrl >> DMAC_BTCTRL_BEATSIZE_Pos) & 3);
+    const int step = (btctrl >> DMAC_BTCTRL_STEPSIZE_Pos) & 7;
+    const bool stepSrc = btctrl & DMAC_BTCTRL_STEPSEL;
+    const uint32_t srcStride = btctrl & DMAC_BTCTRL_SRCINC ? beat << (stepSrc ? step : 0) : 0;
+    const uint32_t dstStride = btctrl & DMAC_BTCTRL_DSTINC ? beat << (stepSrc ? 0 : step) : 0;
+    const uint32_t srcStart = wb.SRCADDR.reg - s.total * srcStride;
+    const uint32_t dstStart = wb.DSTADDR.reg - s.total * dstStride;
+    const uint16_t ctrl = raw_(dmac_().CRCCTRL.reg.raw);
+    const bool crc = ((ctrl >> DMAC_CRCCTRL_CRCSRC_Pos) & 0x3F) == 32u + index;
+
+    const int remaining = wb.BTCNT.reg;
+    const int burstLen = ((ctrla & DMAC_CHCTRLA_BURSTLEN_Msk) >> DMAC_CHCTRLA_BURSTLEN_Pos) + 1;
+    const int count = remaining < burstLen ? remaining : burstLen;
+    const int done = s.total - remaining;
+
+    for (int i = 0; i < count; i++) {
+      const uint32_t src = srcStart + (done + i) * srcStride;
+      const uint32_t dst = dstStart + (done + i) * dstStride;
+      if (s.failAfter == 0 || !mapped_(src) || !mapped_(dst)) {
+        s.failAfter = -1;
+        wb.BTCNT.reg = remaining - i;
+        fault_(index);
+        return;
+      }
+      if (s.failAfter > 0) s.failAfter--;
+      const uint32_t value = load_(src, beat);
+      if (crc) crcFeed_(value);
+      store_(dst, value, beat);
+      s.beats++;
+    }
+    wb.BTCNT.reg = remaining - count;
+    m.cycles += count * m.beatCycles + m.burstCycles;
+
+    if (!wb.BTCNT.reg) {
+      blockEnd_(index);
+    } else if (s.grant == GRANT_BURST) {
+      s.grant = GRANT_NONE;
+    }
+  }
+
+  inline bool enabled_(const int &index) {
+    return raw_(chReg_(index).CHCTRLA.reg.raw) & DMAC_CHCTRLA_ENABLE;
+  }
+
+  inline bool runnable_(const int &index) {
+    const channel_ &s = model().ch[index];
+    return enabled_(index) && !s.suspended && (s.grant != GRANT_NONE || s.pending);
+  }
+
+  // Highest enabled level first; within a level the lowest channel number
+  // wins, or the one after the last served when round-robin is on.
+  inline int pick_(const bool &budget) {
+    model_ &m = model();
+    Dmac &d = dmac_();
+    const uint16_t ctrl = raw_(d.CTRL.reg.raw);
+    const uint32_t prictrl = raw_(d.PRICTRL0.reg.raw);
+
+    if (!(ctrl & DMAC_CTRL_DMAENABLE) || !raw_(d.BASEADDR.reg.raw) || !raw_(d.WRBADDR.reg.raw)) {
+      return -1;
+    }
+    for (int level = DMAC_LVL_NUM - 1; level >= 0; level--) {
+      if (!(ctrl & (DMAC_CTRL_LVLEN0 << level))) continue;
+      const bool rr = prictrl & (DMAC_PRICTRL0_RRLVLEN0 << (8 * level));
+      const int first = rr ? (m.last[level] + 1) % DMAC_CH_NUM : 0;
+
+      for (int k = 0; k < DMAC_CH_NUM; k++) {
+        const int i = (first + k) % DMAC_CH_NUM;
+        if ((raw_(chReg_(i).CHPRILVL.reg.raw) & 3) != level || !runnable_(i)) continue;
+        if (budget && m.ch[i].kickBlocks >= m.blockBudget) continue;
+        if (rr) m.last[level] = i;
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  inline void sync_() {
+    model_ &m = model();
+    Dmac &d = dmac_();
+    uint32_t status = 0, busy = 0, pend = 0, sw = 0;
+
+    for (int i = 0; i < DMAC_CH_NUM; i++) {
+      channel_ &s = m.ch[i];
+      DmacChannel &c = chReg_(i);
+      const bool on = enabled_(i);
+      const bool isBusy = on && !s.suspended && (s.grant != GRANT_NONE || s.loaded);
+      const bool isPend = on && s.pending;
+
+      raw_(c.CHSTATUS.reg.raw) = (isPend ? DMAC_CHSTATUS_PEND : 0)
+        | (isBusy ? DMAC_CHSTATUS_BUSY : 0) | (s.ferr ? DMAC_CHSTATUS_FERR : 0);
+      if (raw_(c.CHINTFLAG.reg.raw) & raw_(c.CHINTENSET.reg.raw)) status |= 1u << i;
+      if (isBusy) busy |= 1u << i;
+      if (isPend) pend |= 1u << i;
+      if (on && s.swPending) sw |= 1u << i;
+    }
+    raw_(d.INTSTATUS.reg.raw) = status;
+    raw_(d.BUSYCH.reg.raw) = busy;
+    raw_(d.PENDCH.reg.raw) = pend;
+    raw_(d.SWTRIGCTRL.reg.raw) = sw;
+
+    uint16_t intpend = 0;
+    for (int i = 0; i < DMAC_CH_NUM; i++) {
+      const uint8_t flags = raw_(chReg_(i).CHINTFLAG.reg.raw);
+      if (!flags) continue;
+      intpend = i | (flags & 7) << 8 | (raw_(chReg_(i).CHSTATUS.reg.raw) & 7) << 13;
+      break;
+    }
+    raw_(d.INTPEND.reg.raw) = intpend;
+
+    uint32_t active = 0;
+    if (m.active >= 0 && runnable_(m.active) && m.ch[m.active].loaded) {
+      active = DMAC_ACTIVE_ABUSY | m.active << DMAC_ACTIVE_ID_Pos
+        | uint32_t(wb_(m.active).BTCNT.reg) << DMAC_ACTIVE_BTCNT_Pos
+        | 1u << (raw_(chReg_(m.active).CHPRILVL.reg.raw) & 3);
+    }
+    raw_(d.ACTIVE.reg.raw) = active;
+  }
+
+  // Lets the channels run. An eager kick (after a register write) runs until
+  // nothing is runnable, a flag is raised or every channel has used its block
+  // budget; a lazy one (after a read) moves a single burst.
+  inline void kick_(const bool &eager) {
+    model_ &m = model();
+    if (m.running) return;
+    m.running = true;
+    m.raised = false;
+    for (int i = 0; i < DMAC_CH_NUM; i++) m.ch[i].kickBlocks = 0;
+
+    for (int units = 0; eager || units < 1; units++) {
+      const int index = pick_(eager);
+      if (index < 0) break;
+      burst_(index);
+      if (m.raised) break;
+    }
+    m.running = false;
+    sync_();
+  }
+
+  inline void dispatch_() {
+    static void (*const handlers[5])(void) = {
+      DMAC_0_Handler, DMAC_1_Handler, DMAC_2_Handler, DMAC_3_Handler, DMAC_4_Handler
+    };
+    model_ &m = model();
+    if (m.running || m.inIsr || m.primask) return;
+
+    for (int guard = 0; guard < 1024; guard++) {
+      const uint32_t status = raw_(dmac_().INTSTATUS.reg.raw);
+      int line = -1;
+      for (int i = 0; i < 5 && line < 0; i++) {
+        const uint32_t mask = i < 4 ? 1u << i : ~0xFu;
+        if ((status & mask) && m.nvic[i]) line = i;
+      }
+      if (line < 0) return;
+      m.inIsr = true;
+      m.exclusive = false;
+      m.interrupts++;
+      handlers[line]();
+      m.inIsr = false;
+      m.exclusive = false;
+    }
+    m.stuck = true;
+  }
+
+  /****************************************************************************
+   * Register side effects
+   ****************************************************************************/
+
+  inline void resetChannel_(const int &index) {
+    memset(static_cast<void*>(&chReg_(index)), 0, sizeof(DmacChannel));
+    model().ch[index] = channel_();
+    model().ch[index].failAfter = -1;
+  }
+
+  inline void resetDmac_() {
+    memset(static_cast<void*>(&dmac_()), 0, offsetof(Dmac, Channel));
+    for (int i = 0; i < DMAC_CH_NUM; i++) resetChannel_(i);
+    for (int i = 0; i < DMAC_LVL_NUM; i++) model().last[i] = DMAC_CH_NUM - 1;
+    model().active = -1;
+  }
+
+  inline void writeChannel_(const int &index, const size_t &offset, const uint32_t &old) {
+    channel_ &s = model().ch[index];
+    DmacChannel &c = chReg_(index);
+
+    switch (offset) {
+      case offsetof(DmacChannel, CHCTRLA): {
+        uint32_t &reg = raw_(c.CHCTRLA.reg.raw);
+        const uint32_t locked = DMAC_CHCTRLA_TRIGSRC_Msk | DMAC_CHCTRLA_TRIGACT_Msk
+          | DMAC_CHCTRLA_BURSTLEN_Msk | DMAC_CHCTRLA_THRESHOLD_Msk | DMAC_CHCTRLA_RUNSTDBY;
+
+        if (old & DMAC_CHCTRLA_ENABLE) {
+          reg = (reg & ~(locked | DMAC_CHCTRLA_SWRST)) | (old & locked);
+        }
+        if (reg & DMAC_CHCTRLA_SWRST) {
+          resetChannel_(index);
+        } else if ((reg & DMAC_CHCTRLA_ENABLE) && !(old & DMAC_CHCTRLA_ENABLE)) {
+          stop_(index);
+        } else if (!(reg & DMAC_CHCTRLA_ENABLE) && (old & DMAC_CHCTRLA_ENABLE)) {
+          stop_(index);
+        }
+        break;
+      }
+      case offsetof(DmacChannel, CHCTRLB): {
+        uint8_t &reg = raw_(c.CHCTRLB.reg.raw);
+        const int cmd = reg & DMAC_CHCTRLB_CMD_Msk;
+
+        if (cmd == DMAC_CHCTRLB_CMD_SUSPEND_Val && enabled_(index)) {
+          s.suspended = true;
+          raise_(index, DMAC_CHINTFLAG_SUSP);
+        } else if (cmd == DMAC_CHCTRLB_CMD_RESUME_Val && s.suspended) {
+          s.suspended = false;
+          s.ferr = false;
+        }
+        reg &= ~DMAC_CHCTRLB_CMD_Msk;
+        break;
+      }
+      case offsetof(DmacChannel, CHINTENCLR): {
+        const uint8_t mask = old & ~raw_(c.CHINTENCLR.reg.raw) & DMAC_CHINTENSET_MASK;
+        raw_(c.CHINTENCLR.reg.raw) = mask;
+        raw_(c.CHINTENSET.reg.raw) = mask;
+        break;
+      }
+      case offsetof(DmacChannel, CHINTENSET): {
+        const uint8_t mask = (old | raw_(c.CHINTENSET.reg.raw)) & DMAC_CHINTENSET_MASK;
+        raw_(c.CHINTENCLR.reg.raw) = mask;
+        raw_(c.CHINTENSET.reg.raw) = mask;
+        break;
+      }
+      case offsetof(DmacChannel, CHINTFLAG):
+        raw_(c.CHINTFLAG.reg.raw) = old & ~raw_(c.CHINTFLAG.reg.raw);
+        break;
+      case offsetof(DmacChannel, CHSTATUS):
+        raw_(c.CHSTATUS.reg.raw) = old;
+        break;
+      default:
+        break;
+    }
+  }
+
+  inline void write_(const size_t &offset, const uint32_t &old) {
+    Dmac &d = dmac_();
+
+    if (offset >= offsetof(Dmac, Channel)) {
+      const size_t local = offset - offsetof(Dmac, Channel);
+      writeChannel_(local / sizeof(DmacChannel), local % sizeof(DmacChannel), old);
+      return;
+    }
+    switch (offset) {
+      case offsetof(Dmac, CTRL):
+        if (raw_(d.CTRL.reg.raw) & DMAC_CTRL_SWRST) {
+          if (old & DMAC_CTRL_DMAENABLE) {
+            raw_(d.CTRL.reg.raw) &= ~DMAC_CTRL_SWRST;
+          } else {
+            resetDmac_();
+          }
+        }
+        break;
+      case offsetof(Dmac, CRCDATAIN):
+        if (((raw_(d.CRCCTRL.reg.raw) >> DMAC_CRCCTRL_CRCSRC_Pos) & 0x3F) == DMAC_CRCCTRL_CRCSRC_IO_Val) {
+          crcFeed_(raw_(d.CRCDATAIN.reg.raw));
+        }
+        break;
+      case offsetof(Dmac, CRCSTATUS):
+        raw_(d.CRCSTATUS.reg.raw) = old & ~raw_(d.CRCSTATUS.reg.raw);
+        break;
+      case offsetof(Dmac, SWTRIGCTRL): {
+        const uint32_t set = raw_(d.SWTRIGCTRL.reg.raw);
+        for (int i = 0; i < DMAC_CH_NUM; i++) {
+          if ((set & (1u << i)) && enabled_(i)) {
+            model().ch[i].pending = true;
+            model().ch[i].swPending = true;
+          }
+        }
+        break;
+      }
+      case offsetof(Dmac, INTPEND):
+      case offsetof(Dmac, INTSTATUS):
+      case offsetof(Dmac, BUSYCH):
+      case offsetof(Dmac, PENDCH):
+      case offsetof(Dmac, ACTIVE):
+        break;
+      default:
+        break;
+    }
+  }
+
+  inline size_t offset_(const volatile void *reg) {
+    return addr_(reg) - addr_(DMAC);
+  }
+
+  inline void dmacRead_(const volatile void *) {
+    model_ &m = model();
+    if (m.running) return;
+    m.cycles += m.accessCycles;
+    kick_(false);
+    dispatch_();
+  }
+
+  inline void dmacWrite_(const volatile void *reg, const uint32_t &old) {
+    model_ &m = model();
+    if (m.running) return;
+    m.cycles += m.accessCycles;
+    write_(offset_(reg), old);
+    sync_();
+    kick_(true);
+    dispatch_();
+  }
+
+  inline uint32_t readCycles_() {
+    model_ &m = model();
+    m.cycles++;
+    if (!m.running) {
+      kick_(false);
+      dispatch_();
+    }
+    return m.cycles;
+  }
+
+  inline void writeCycles_(const uint32_t &value) { model().cycles = value; }
+
+  inline uint32_t getPrimask_() { return model().primask; }
+
+  // Handlers only run for the DMAC vectors, any of them will do.
+  inline uint32_t getIpsr_() { return model().inIsr ? 16 + DMAC_0_IRQn : 0; }
+
+  inline void setPrimask_(const uint32_t &value) {
+    model().primask = value & 1;
+    if (!model().primask) dispatch_();
+  }
+
+  // One core: a store-exclusive fails only if a handler ran since the load.
+  inline uint32_t loadExclusive_(volatile uint32_t *addr) {
+    model().exclusive = true;
+    return *addr;
+  }
+  inline uint32_t storeExclusive_(const uint32_t &value,
+    volatile uint32_t *addr) {
+    if (!model().exclusive) return 1;
+    model().exclusive = false;
+    *addr = value;
+    return 0;
+  }
+  inline void clearExclusive_() { model().exclusive = false; }
+
+  inline void setIrq_(const int &irq, const bool &enabled) {
+    if (irq < DMAC_0_IRQn || irq > DMAC_4_IRQn) return;
+    model().nvic[irq - DMAC_0_IRQn] = enabled;
+    if (enabled) dispatch_();
+  }
+
+  /****************************************************************************
+   * Test interface
+   ****************************************************************************/
+
+  // Puts the DMAC, the core state the model tracks and the costs back to
+  // their power-on values. Peripheral memory other than the DMAC is left alone.
+  inline void reset() {
+    model() = fresh_();
+    resetDmac_();
+  }
+
+  // Peripheral trigger on the channel, as if its TRIGSRC fired count times.
+  inline void trigger(const int &index, const int &count = 1) {
+    for (int i = 0; i < count; i++) {
+      if (!enabled_(index)) return;
+      model().ch[index].pending = true;
+      sync_();
+      kick_(true);
+      dispatch_();
+    }
+  }
+
+  // Runs the channels with no block budget until they go idle, an interrupt
+  // is left unserviced or maxBursts bursts have moved.
+  inline void run(const int &maxBursts = 100000) {
+    model_ &m = model();
+    for (int i = 0; i < maxBursts; i++) {
+      const int index = pick_(false);
+      if (index < 0) break;
+      m.running = true;
+      m.raised = false;
+      burst_(index);
+      m.running = false;
+      sync_();
+      if (m.raised) dispatch_();
+    }
+    sync_();
+  }
+
+  // Fails the channel's next transfer with TERR after the given number of beats.
+  inline void failAfter(const int &index, const int &beats) {
+    model().ch[index].failAfter = beats;
+  }
+
+  inline uint32_t cycles() { return model().cycles; }
+  inline const channel_ &channel(const int &index) { return model().ch[index]; }
+  inline uint8_t flags(const int &index) { return raw_(chReg_(index).CHINTFLAG.reg.raw); }
+
+}
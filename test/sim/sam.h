@@ -0,0 +1,954 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+// Host stand-in for the SAMD51 device header, used by the native test env.
+// DMAC registers are proxies that call into the model in dmac_model.h on
+// every access; every other peripheral is plain memory. Descriptors hold
+// 32-bit addresses, so the native env links with -no-pie and anything the
+// DMA touches (buffers and descriptors) must be static, not on the stack.
+// taskDescriptor objects may live anywhere, their descriptors are static.
+
+#define __SAMD51__
+#define _U_(x) x##U
+#define _UL_(x) x##UL
+#define __IO volatile
+#define __I volatile
+#define __O volatile
+#define __PACKED_STRUCT struct __attribute__((packed))
+#define __ALIGNED(x) __attribute__((aligned(x)))
+#define SECTION_DMAC_DESCRIPTOR
+
+namespace sim {
+
+  void dmacRead_(const volatile void *reg);
+  void dmacWrite_(const volatile void *reg, const uint32_t &old);
+  uint32_t readCycles_();
+  void writeCycles_(const uint32_t &value);
+  uint32_t getPrimask_();
+  uint32_t getIpsr_();
+  void setPrimask_(const uint32_t &value);
+  void setIrq_(const int &irq, const bool &enabled);
+  uint32_t loadExclusive_(volatile uint32_t *addr);
+  uint32_t storeExclusive_(const uint32_t &value, volatile uint32_t *addr);
+  void clearExclusive_();
+
+  // Whole register: reads run the model one step, writes apply the register's
+  // side effects (W1C, commands, triggers) and let the channels run.
+  template<typename T> struct reg_ {
+    T raw;
+
+    operator T() const volatile {
+      dmacRead_(this);
+      return raw;
+    }
+    void operator=(T value) volatile {
+      const uint32_t old = raw;
+      raw = value;
+      dmacWrite_(this, old);
+    }
+    template<typename V> void operator|=(V value) volatile { *this = T(T(*this) | value); }
+    template<typename V> void operator&=(V value) volatile { *this = T(T(*this) & value); }
+  };
+
+  // Bit field of a register: a write is a read-modify-write of the whole
+  // register, exactly like the bitfield store the compiler emits on target,
+  // so writing one W1C flag through .bit also clears the others.
+  template<typename T, int POS, int WIDTH> struct field_ {
+    T raw;
+
+    static constexpr T MASK = T(((1ull << WIDTH) - 1) << POS);
+
+    operator T() const volatile {
+      dmacRead_(this);
+      return T((raw & MASK) >> POS);
+    }
+    template<typename E, typename = typename std::enable_if<std::is_enum<E>::value>::type>
+    explicit operator E() const volatile {
+      return static_cast<E>(T(*this));
+    }
+    void operator=(T value) volatile {
+      const uint32_t old = raw;
+      raw = T((raw & ~MASK) | ((T(value) << POS) & MASK));
+      dmacWrite_(this, old);
+    }
+  };
+
+  struct cycles_ {
+    uint32_t raw;
+
+    operator uint32_t() const volatile { return readCycles_(); }
+    void operator=(const uint32_t &value) volatile { writeCycles_(value); }
+  };
+
+  template<typename T, int N = 0> inline T *instance_() {
+    static T value;
+    return &value;
+  }
+
+}
+
+/******************************************************************************
+ * Core
+ ******************************************************************************/
+
+typedef enum {
+  DMAC_0_IRQn = 31,
+  DMAC_1_IRQn = 32,
+  DMAC_2_IRQn = 33,
+  DMAC_3_IRQn = 34,
+  DMAC_4_IRQn = 35,
+  EVSYS_0_IRQn = 36,
+  DAC_EMPTY_0_IRQn = 123,
+  I2S_IRQn = 128,
+  PCC_IRQn = 129
+} IRQn_Type;
+
+inline uint32_t __get_PRIMASK() { return sim::getPrimask_(); }
+inline void __set_PRIMASK(uint32_t value) { sim::setPrimask_(value); }
+inline void __disable_irq() { sim::setPrimask_(1); }
+inline void __enable_irq() { sim::setPrimask_(0); }
+inline uint32_t __get_IPSR() { return sim::getIpsr_(); }
+inline uint32_t __RBIT(uint32_t value) {
+  uint32_t result = 0;
+  for (int i = 0; i < 32; i++, value >>= 1) result = (result << 1) | (value & 1);
+  return result;
+}
+inline uint32_t __LDREXW(volatile uint32_t *addr) {
+  return sim::loadExclusive_(addr);
+}
+inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) {
+  return sim::storeExclusive_(value, addr);
+}
+inline void __CLREX() { sim::clearExclusive_(); }
+inline void __DMB() { __sync_synchronize(); }
+inline void __DSB() { __sync_synchronize(); }
+inline void __ISB() {}
+inline void __NOP() {}
+#define __BKPT(x) __builtin_trap()
+
+inline void NVIC_EnableIRQ(IRQn_Type irq) { sim::setIrq_(irq, true); }
+inline void NVIC_DisableIRQ(IRQn_Type irq) { sim::setIrq_(irq, false); }
+inline void NVIC_ClearPendingIRQ(IRQn_Type) {}
+inline void NVIC_SetPriority(IRQn_Type, uint32_t) {}
+
+typedef struct {
+  __IO uint32_t CTRL;
+  __IO sim::cycles_ CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  __IO uint32_t DHCSR;
+  __IO uint32_t DCRSR;
+  __IO uint32_t DCRDR;
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT (sim::instance_<DWT_Type>())
+#define CoreDebug (sim::instance_<CoreDebug_Type>())
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+/******************************************************************************
+ * DMAC
+ ******************************************************************************/
+
+#define DMAC_CH_NUM 32
+#define DMAC_LVL_NUM 4
+#define DMAC_TRIG_NUM 86
+
+typedef union {
+  struct {
+    uint16_t VALID:1;
+    uint16_t EVOSEL:2;
+    uint16_t BLOCKACT:2;
+    uint16_t :3;
+    uint16_t BEATSIZE:2;
+    uint16_t SRCINC:1;
+    uint16_t DSTINC:1;
+    uint16_t STEPSEL:1;
+    uint16_t STEPSIZE:3;
+  } bit;
+  uint16_t reg;
+} DMAC_BTCTRL_Type;
+
+typedef union {
+  struct { uint16_t BTCNT:16; } bit;
+  uint16_t reg;
+} DMAC_BTCNT_Type;
+
+typedef union {
+  struct { uint32_t SRCADDR:32; } bit;
+  uint32_t reg;
+} DMAC_SRCADDR_Type;
+
+typedef union {
+  struct { uint32_t DSTADDR:32; } bit;
+  uint32_t reg;
+} DMAC_DSTADDR_Type;
+
+typedef union {
+  struct { uint32_t DESCADDR:32; } bit;
+  uint32_t reg;
+} DMAC_DESCADDR_Type;
+
+typedef struct {
+  __IO DMAC_BTCTRL_Type BTCTRL;
+  __IO DMAC_BTCNT_Type BTCNT;
+  __IO DMAC_SRCADDR_Type SRCADDR;
+  __IO DMAC_DSTADDR_Type DSTADDR;
+  __IO DMAC_DESCADDR_Type DESCADDR;
+} DmacDescriptor __attribute__((aligned(8)));
+
+typedef union {
+  union {
+    sim::field_<uint16_t, 0, 1> SWRST;
+    sim::field_<uint16_t, 1, 1> DMAENABLE;
+    sim::field_<uint16_t, 8, 1> LVLEN0;
+    sim::field_<uint16_t, 9, 1> LVLEN1;
+    sim::field_<uint16_t, 10, 1> LVLEN2;
+    sim::field_<uint16_t, 11, 1> LVLEN3;
+  } bit;
+  sim::reg_<uint16_t> reg;
+} DMAC_CTRL_Type;
+
+typedef union {
+  union {
+    sim::field_<uint16_t, 0, 2> CRCBEATSIZE;
+    sim::field_<uint16_t, 2, 2> CRCPOLY;
+    sim::field_<uint16_t, 8, 6> CRCSRC;
+    sim::field_<uint16_t, 14, 2> CRCMODE;
+  } bit;
+  sim::reg_<uint16_t> reg;
+} DMAC_CRCCTRL_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> CRCDATAIN; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_CRCDATAIN_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> CRCCHKSUM; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_CRCCHKSUM_Type;
+
+typedef union {
+  union {
+    sim::field_<uint8_t, 0, 1> CRCBUSY;
+    sim::field_<uint8_t, 1, 1> CRCZERO;
+    sim::field_<uint8_t, 2, 1> CRCERR;
+  } bit;
+  sim::reg_<uint8_t> reg;
+} DMAC_CRCSTATUS_Type;
+
+typedef union {
+  union { sim::field_<uint8_t, 0, 1> DBGRUN; } bit;
+  sim::reg_<uint8_t> reg;
+} DMAC_DBGCTRL_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> SWTRIG; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_SWTRIGCTRL_Type;
+
+typedef union {
+  union {
+    sim::field_<uint32_t, 0, 5> LVLPRI0;
+    sim::field_<uint32_t, 5, 2> QOS0;
+    sim::field_<uint32_t, 7, 1> RRLVLEN0;
+    sim::field_<uint32_t, 8, 5> LVLPRI1;
+    sim::field_<uint32_t, 13, 2> QOS1;
+    sim::field_<uint32_t, 15, 1> RRLVLEN1;
+    sim::field_<uint32_t, 16, 5> LVLPRI2;
+    sim::field_<uint32_t, 21, 2> QOS2;
+    sim::field_<uint32_t, 23, 1> RRLVLEN2;
+    sim::field_<uint32_t, 24, 5> LVLPRI3;
+    sim::field_<uint32_t, 29, 2> QOS3;
+    sim::field_<uint32_t, 31, 1> RRLVLEN3;
+  } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_PRICTRL0_Type;
+
+typedef union {
+  union {
+    sim::field_<uint16_t, 0, 5> ID;
+    sim::field_<uint16_t, 8, 1> TERR;
+    sim::field_<uint16_t, 9, 1> TCMPL;
+    sim::field_<uint16_t, 10, 1> SUSP;
+    sim::field_<uint16_t, 12, 1> CRCERR;
+    sim::field_<uint16_t, 13, 1> FERR;
+    sim::field_<uint16_t, 14, 1> BUSY;
+    sim::field_<uint16_t, 15, 1> PEND;
+  } bit;
+  sim::reg_<uint16_t> reg;
+} DMAC_INTPEND_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> CHINT; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_INTSTATUS_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> BUSYCH; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_BUSYCH_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> PENDCH; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_PENDCH_Type;
+
+typedef union {
+  union {
+    sim::field_<uint32_t, 0, 1> LVLEX0;
+    sim::field_<uint32_t, 1, 1> LVLEX1;
+    sim::field_<uint32_t, 2, 1> LVLEX2;
+    sim::field_<uint32_t, 3, 1> LVLEX3;
+    sim::field_<uint32_t, 8, 5> ID;
+    sim::field_<uint32_t, 15, 1> ABUSY;
+    sim::field_<uint32_t, 16, 16> BTCNT;
+  } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_ACTIVE_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> BASEADDR; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_BASEADDR_Type;
+
+typedef union {
+  union { sim::field_<uint32_t, 0, 32> WRBADDR; } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_WRBADDR_Type;
+
+typedef union {
+  union {
+    sim::field_<uint32_t, 0, 1> SWRST;
+    sim::field_<uint32_t, 1, 1> ENABLE;
+    sim::field_<uint32_t, 6, 1> RUNSTDBY;
+    sim::field_<uint32_t, 8, 7> TRIGSRC;
+    sim::field_<uint32_t, 20, 2> TRIGACT;
+    sim::field_<uint32_t, 24, 4> BURSTLEN;
+    sim::field_<uint32_t, 28, 2> THRESHOLD;
+  } bit;
+  sim::reg_<uint32_t> reg;
+} DMAC_CHCTRLA_Type;
+
+typedef union {
+  union { sim::field_<uint8_t, 0, 2> CMD; } bit;
+  sim::reg_<uint8_t> reg;
+} DMAC_CHCTRLB_Type;
+
+typedef union {
+  union { sim::field_<uint8_t, 0, 2> PRILVL; } bit;
+  sim::reg_<uint8_t> reg;
+} DMAC_CHPRILVL_Type;
+
+typedef union {
+  union {
+    sim::field_<uint8_t, 0, 3> EVACT;
+    sim::field_<uint8_t, 4, 2> EVOMODE;
+    sim::field_<uint8_t, 6, 1> EVIE;
+    sim::field_<uint8_t, 7, 1> EVOE;
+  } bit;
+  sim::reg_<uint8_t> reg;
+} DMAC_CHEVCTRL_Type;
+
+typedef union {
+  union {
+    sim::field_<uint8_t, 0, 1> TERR;
+    sim::field_<uint8_t, 1, 1> TCMPL;
+    sim::field_<uint8_t, 2, 1> SUSP;
+  } bit;
+  sim::reg_<uint8_t> reg;
+} DMAC_CHINTENCLR_Type, DMAC_CHINTENSET_Type, DMAC_CHINTFLAG_Type;
+
+typedef union {
+  union {
+    sim::field_<uint8_t, 0, 1> PEND;
+    sim::field_<uint8_t, 1, 1> BUSY;
+    sim::field_<uint8_t, 2, 1> FERR;
+    sim::field_<uint8_t, 3, 1> CRCERR;
+  } bit;
+  sim::reg_<uint8_t> reg;
+} DMAC_CHSTATUS_Type;
+
+typedef struct {
+  __IO DMAC_CHCTRLA_Type CHCTRLA;
+  __IO DMAC_CHCTRLB_Type CHCTRLB;
+  __IO DMAC_CHPRILVL_Type CHPRILVL;
+  __IO DMAC_CHEVCTRL_Type CHEVCTRL;
+  uint8_t Reserved1[5];
+  __IO DMAC_CHINTENCLR_Type CHINTENCLR;
+  __IO DMAC_CHINTENSET_Type CHINTENSET;
+  __IO DMAC_CHINTFLAG_Type CHINTFLAG;
+  __I DMAC_CHSTATUS_Type CHSTATUS;
+} DmacChannel;
+
+typedef struct {
+  __IO DMAC_CTRL_Type CTRL;
+  __IO DMAC_CRCCTRL_Type CRCCTRL;
+  __IO DMAC_CRCDATAIN_Type CRCDATAIN;
+  __IO DMAC_CRCCHKSUM_Type CRCCHKSUM;
+  __IO DMAC_CRCSTATUS_Type CRCSTATUS;
+  __IO DMAC_DBGCTRL_Type DBGCTRL;
+  uint8_t Reserved1[2];
+  __IO DMAC_SWTRIGCTRL_Type SWTRIGCTRL;
+  __IO DMAC_PRICTRL0_Type PRICTRL0;
+  uint8_t Reserved2[8];
+  __IO DMAC_INTPEND_Type INTPEND;
+  uint8_t Reserved3[2];
+  __I DMAC_INTSTATUS_Type INTSTATUS;
+  __I DMAC_BUSYCH_Type BUSYCH;
+  __I DMAC_PENDCH_Type PENDCH;
+  __I DMAC_ACTIVE_Type ACTIVE;
+  __IO DMAC_BASEADDR_Type BASEADDR;
+  __IO DMAC_WRBADDR_Type WRBADDR;
+  uint8_t Reserved4[4];
+  DmacChannel Channel[DMAC_CH_NUM];
+} Dmac;
+
+static_assert(sizeof(DmacDescriptor) == 16, "descriptor layout");
+static_assert(sizeof(DmacChannel) == 0x10, "channel layout");
+static_assert(offsetof(Dmac, Channel) == 0x40, "dmac layout");
+
+#define DMAC (sim::instance_<Dmac>())
+#define REG_DMAC_CRCDATAIN (&DMAC->CRCDATAIN.reg)
+#define REG_DMAC_CRCCHKSUM (&DMAC->CRCCHKSUM.reg)
+
+#define DMAC_CTRL_SWRST (_U_(0x1) << 0)
+#define DMAC_CTRL_DMAENABLE (_U_(0x1) << 1)
+#define DMAC_CTRL_LVLEN0_Pos 8
+#define DMAC_CTRL_LVLEN0 (_U_(0x1) << 8)
+#define DMAC_CTRL_LVLEN1 (_U_(0x1) << 9)
+#define DMAC_CTRL_LVLEN2 (_U_(0x1) << 10)
+#define DMAC_CTRL_LVLEN3 (_U_(0x1) << 11)
+#define DMAC_CTRL_LVLEN_Pos 8
+#define DMAC_CTRL_LVLEN_Msk (_U_(0xF) << DMAC_CTRL_LVLEN_Pos)
+
+#define DMAC_CRCCTRL_CRCBEATSIZE_Pos 0
+#define DMAC_CRCCTRL_CRCBEATSIZE(value) ((value) << 0)
+#define DMAC_CRCCTRL_CRCBEATSIZE_BYTE_Val _U_(0x0)
+#define DMAC_CRCCTRL_CRCBEATSIZE_HWORD_Val _U_(0x1)
+#define DMAC_CRCCTRL_CRCBEATSIZE_WORD_Val _U_(0x2)
+#define DMAC_CRCCTRL_CRCPOLY_Pos 2
+#define DMAC_CRCCTRL_CRCPOLY(value) ((value) << 2)
+#define DMAC_CRCCTRL_CRCPOLY_CRC16_Val _U_(0x0)
+#define DMAC_CRCCTRL_CRCPOLY_CRC32_Val _U_(0x1)
+#define DMAC_CRCCTRL_CRCSRC_Pos 8
+#define DMAC_CRCCTRL_CRCSRC(value) ((value) << 8)
+#define DMAC_CRCCTRL_CRCSRC_DISABLE_Val _U_(0x0)
+#define DMAC_CRCCTRL_CRCSRC_IO_Val _U_(0x1)
+#define DMAC_CRCCTRL_CRCMODE_Pos 14
+#define DMAC_CRCCTRL_CRCMODE(value) ((value) << 14)
+#define DMAC_CRCCTRL_MASK _U_(0xFF0F)
+
+#define DMAC_CRCSTATUS_CRCBUSY (_U_(0x1) << 0)
+#define DMAC_CRCSTATUS_CRCZERO (_U_(0x1) << 1)
+#define DMAC_CRCSTATUS_CRCERR (_U_(0x1) << 2)
+
+#define DMAC_PRICTRL0_LVLPRI0_Pos 0
+#define DMAC_PRICTRL0_QOS0_Pos 5
+#define DMAC_PRICTRL0_QOS0_Msk (_U_(0x3) << 5)
+#define DMAC_PRICTRL0_RRLVLEN0_Pos 7
+#define DMAC_PRICTRL0_RRLVLEN0 (_U_(0x1) << 7)
+#define DMAC_PRICTRL0_QOS1_Pos 13
+#define DMAC_PRICTRL0_RRLVLEN1 (_U_(0x1) << 15)
+#define DMAC_PRICTRL0_QOS2_Pos 21
+#define DMAC_PRICTRL0_RRLVLEN2 (_U_(0x1) << 23)
+#define DMAC_PRICTRL0_QOS3_Pos 29
+#define DMAC_PRICTRL0_RRLVLEN3 (_U_(0x1) << 31)
+
+#define DMAC_ACTIVE_ID_Pos 8
+#define DMAC_ACTIVE_ID_Msk (_U_(0x1F) << 8)
+#define DMAC_ACTIVE_ABUSY (_U_(0x1) << 15)
+#define DMAC_ACTIVE_BTCNT_Pos 16
+#define DMAC_ACTIVE_BTCNT_Msk (_U_(0xFFFF) << 16)
+
+#define DMAC_CHCTRLA_RESETVALUE _U_(0x00000000)
+#define DMAC_CHCTRLA_SWRST (_U_(0x1) << 0)
+#define DMAC_CHCTRLA_ENABLE (_U_(0x1) << 1)
+#define DMAC_CHCTRLA_RUNSTDBY (_U_(0x1) << 6)
+#define DMAC_CHCTRLA_TRIGSRC_Pos 8
+#define DMAC_CHCTRLA_TRIGSRC_Msk (_U_(0x7F) << 8)
+#define DMAC_CHCTRLA_TRIGSRC(value) (DMAC_CHCTRLA_TRIGSRC_Msk & ((value) << 8))
+#define DMAC_CHCTRLA_TRIGACT_Pos 20
+#define DMAC_CHCTRLA_TRIGACT_Msk (_U_(0x3) << 20)
+#define DMAC_CHCTRLA_TRIGACT(value) (DMAC_CHCTRLA_TRIGACT_Msk & ((value) << 20))
+#define DMAC_CHCTRLA_TRIGACT_BLOCK_Val _U_(0x0)
+#define DMAC_CHCTRLA_TRIGACT_BURST_Val _U_(0x2)
+#define DMAC_CHCTRLA_TRIGACT_TRANSACTION_Val _U_(0x3)
+#define DMAC_CHCTRLA_BURSTLEN_Pos 24
+#define DMAC_CHCTRLA_BURSTLEN_Msk (_U_(0xF) << 24)
+#define DMAC_CHCTRLA_BURSTLEN(value) (DMAC_CHCTRLA_BURSTLEN_Msk & ((value) << 24))
+#define DMAC_CHCTRLA_BURSTLEN_SINGLE_Val _U_(0x0)
+#define DMAC_CHCTRLA_BURSTLEN_4BEAT_Val _U_(0x3)
+#define DMAC_CHCTRLA_THRESHOLD_Pos 28
+#define DMAC_CHCTRLA_THRESHOLD_Msk (_U_(0x3) << 28)
+#define DMAC_CHCTRLA_THRESHOLD(value) (DMAC_CHCTRLA_THRESHOLD_Msk & ((value) << 28))
+#define DMAC_CHCTRLA_THRESHOLD_2BEATS_Val _U_(0x1)
+
+#define DMAC_CHCTRLB_CMD_Pos 0
+#define DMAC_CHCTRLB_CMD_Msk (_U_(0x3) << 0)
+#define DMAC_CHCTRLB_CMD(value) (DMAC_CHCTRLB_CMD_Msk & ((value) << 0))
+#define DMAC_CHCTRLB_CMD_NOACT_Val _U_(0x0)
+#define DMAC_CHCTRLB_CMD_SUSPEND_Val _U_(0x1)
+#define DMAC_CHCTRLB_CMD_RESUME_Val _U_(0x2)
+
+#define DMAC_CHPRILVL_PRILVL_Pos 0
+#define DMAC_CHPRILVL_PRILVL(value) ((value) & _U_(0x3))
+
+#define DMAC_CHINTENCLR_TERR_Pos 0
+#define DMAC_CHINTENCLR_TERR (_U_(0x1) << 0)
+#define DMAC_CHINTENCLR_TCMPL_Pos 1
+#define DMAC_CHINTENCLR_TCMPL (_U_(0x1) << 1)
+#define DMAC_CHINTENCLR_SUSP_Pos 2
+#define DMAC_CHINTENCLR_SUSP (_U_(0x1) << 2)
+#define DMAC_CHINTENCLR_MASK _U_(0x07)
+#define DMAC_CHINTENSET_TERR_Pos 0
+#define DMAC_CHINTENSET_TERR (_U_(0x1) << 0)
+#define DMAC_CHINTENSET_TCMPL_Pos 1
+#define DMAC_CHINTENSET_TCMPL (_U_(0x1) << 1)
+#define DMAC_CHINTENSET_SUSP_Pos 2
+#define DMAC_CHINTENSET_SUSP (_U_(0x1) << 2)
+#define DMAC_CHINTENSET_MASK _U_(0x07)
+#define DMAC_CHINTFLAG_RESETVALUE _U_(0x00)
+#define DMAC_CHINTFLAG_TERR_Pos 0
+#define DMAC_CHINTFLAG_TERR (_U_(0x1) << 0)
+#define DMAC_CHINTFLAG_TCMPL_Pos 1
+#define DMAC_CHINTFLAG_TCMPL (_U_(0x1) << 1)
+#define DMAC_CHINTFLAG_SUSP_Pos 2
+#define DMAC_CHINTFLAG_SUSP (_U_(0x1) << 2)
+#define DMAC_CHINTFLAG_MASK _U_(0x07)
+
+#define DMAC_CHSTATUS_PEND (_U_(0x1) << 0)
+#define DMAC_CHSTATUS_BUSY (_U_(0x1) << 1)
+#define DMAC_CHSTATUS_FERR (_U_(0x1) << 2)
+#define DMAC_CHSTATUS_CRCERR (_U_(0x1) << 3)
+
+#define DMAC_BTCTRL_VALID (_U_(0x1) << 0)
+#define DMAC_BTCTRL_EVOSEL(value) (((value) & 0x3) << 1)
+#define DMAC_BTCTRL_BLOCKACT_Pos 3
+#define DMAC_BTCTRL_BLOCKACT(value) (((value) & 0x3) << 3)
+#define DMAC_BTCTRL_BLOCKACT_NOACT_Val _U_(0x0)
+#define DMAC_BTCTRL_BLOCKACT_INT_Val _U_(0x1)
+#define DMAC_BTCTRL_BLOCKACT_SUSPEND_Val _U_(0x2)
+#define DMAC_BTCTRL_BLOCKACT_BOTH_Val _U_(0x3)
+#define DMAC_BTCTRL_BLOCKACT_NOACT (DMAC_BTCTRL_BLOCKACT_NOACT_Val << 3)
+#define DMAC_BTCTRL_BLOCKACT_INT (DMAC_BTCTRL_BLOCKACT_INT_Val << 3)
+#define DMAC_BTCTRL_BLOCKACT_SUSPEND (DMAC_BTCTRL_BLOCKACT_SUSPEND_Val << 3)
+#define DMAC_BTCTRL_BLOCKACT_BOTH (DMAC_BTCTRL_BLOCKACT_BOTH_Val << 3)
+#define DMAC_BTCTRL_BEATSIZE_Pos 8
+#define DMAC_BTCTRL_BEATSIZE(value) (((value) & 0x3) << 8)
+#define DMAC_BTCTRL_BEATSIZE_BYTE_Val _U_(0x0)
+#define DMAC_BTCTRL_BEATSIZE_HWORD_Val _U_(0x1)
+#define DMAC_BTCTRL_BEATSIZE_WORD_Val _U_(0x2)
+#define DMAC_BTCTRL_SRCINC (_U_(0x1) << 10)
+#define DMAC_BTCTRL_DSTINC (_U_(0x1) << 11)
+#define DMAC_BTCTRL_STEPSEL (_U_(0x1) << 12)
+#define DMAC_BTCTRL_STEPSEL_DST_Val _U_(0x0)
+#define DMAC_BTCTRL_STEPSEL_SRC_Val _U_(0x1)
+#define DMAC_BTCTRL_STEPSIZE_Pos 13
+#define DMAC_BTCTRL_STEPSIZE(value) (((value) & 0x7) << 13)
+
+#define DMAC_SRCADDR_RESETVALUE _U_(0x00000000)
+#define DMAC_DSTADDR_RESETVALUE _U_(0x00000000)
+
+/******************************************************************************
+ * MCLK, GCLK
+ ******************************************************************************/
+
+typedef union { uint32_t reg; } MCLK_APBMASK_Type;
+
+typedef struct {
+  __IO MCLK_APBMASK_Type APBAMASK;
+  __IO MCLK_APBMASK_Type APBBMASK;
+  __IO MCLK_APBMASK_Type APBCMASK;
+  __IO MCLK_APBMASK_Type APBDMASK;
+} Mclk;
+
+#define MCLK (sim::instance_<Mclk>())
+#define MCLK_APBAMASK_TC0 (_U_(0x1) << 14)
+#define MCLK_APBAMASK_TC1 (_U_(0x1) << 15)
+#define MCLK_APBBMASK_EVSYS (_U_(0x1) << 7)
+#define MCLK_APBBMASK_TC2 (_U_(0x1) << 13)
+#define MCLK_APBBMASK_TC3 (_U_(0x1) << 14)
+#define MCLK_APBCMASK_TC4 (_U_(0x1) << 5)
+#define MCLK_APBCMASK_TC5 (_U_(0x1) << 6)
+#define MCLK_APBDMASK_I2S (_U_(0x1) << 9)
+#define MCLK_APBDMASK_PCC (_U_(0x1) << 11)
+
+typedef union {
+  struct {
+    uint32_t GEN:4;
+    uint32_t :2;
+    uint32_t CHEN:1;
+    uint32_t WRTLOCK:1;
+  } bit;
+  uint32_t reg;
+} GCLK_PCHCTRL_Type;
+
+typedef struct {
+  __IO GCLK_PCHCTRL_Type PCHCTRL[48];
+} Gclk;
+
+#define GCLK (sim::instance_<Gclk>())
+#define GCLK_GEN_NUM 12
+#define GCLK_PCHCTRL_GEN(value) ((value) & 0xF)
+#define GCLK_PCHCTRL_CHEN (_U_(0x1) << 6)
+
+/******************************************************************************
+ * EVSYS
+ ******************************************************************************/
+
+typedef union {
+  struct {
+    uint32_t EVGEN:7;
+    uint32_t :1;
+    uint32_t PATH:2;
+    uint32_t EDGSEL:2;
+    uint32_t :2;
+    uint32_t RUNSTDBY:1;
+    uint32_t ONDEMAND:1;
+  } bit;
+  uint32_t reg;
+} EVSYS_CHANNEL_Type;
+
+typedef union {
+  struct { uint8_t CHANNEL:6; } bit;
+  uint8_t reg;
+} EVSYS_USER_Type;
+
+typedef union {
+  struct { uint8_t SWRST:1; } bit;
+  uint8_t reg;
+} EVSYS_CTRLA_Type;
+
+typedef struct {
+  __IO EVSYS_CHANNEL_Type CHANNEL;
+  __IO uint8_t CHINTENCLR;
+  __IO uint8_t CHINTENSET;
+  __IO uint8_t CHINTFLAG;
+  __I uint8_t CHSTATUS;
+} EvsysChannel;
+
+typedef struct {
+  __IO EVSYS_CTRLA_Type CTRLA;
+  __IO uint32_t SWEVT;
+  EvsysChannel Channel[32];
+  __IO EVSYS_USER_Type USER[67];
+} Evsys;
+
+#define EVSYS (sim::instance_<Evsys>())
+#define EVSYS_CHANNELS 32
+#define EVSYS_USERS 67
+#define EVSYS_CHANNEL_EVGEN(value) ((value) & 0x7F)
+#define EVSYS_CHANNEL_PATH(value) (((value) & 0x3) << 8)
+#define EVSYS_CHANNEL_PATH_SYNCHRONOUS_Val _U_(0x0)
+#define EVSYS_CHANNEL_PATH_RESYNCHRONIZED_Val _U_(0x1)
+#define EVSYS_CHANNEL_PATH_ASYNCHRONOUS_Val _U_(0x2)
+#define EVSYS_CHANNEL_EDGSEL(value) (((value) & 0x3) << 10)
+#define EVSYS_CHANNEL_RUNSTDBY (_U_(0x1) << 14)
+#define EVSYS_USER_CHANNEL(value) ((value) & 0x3F)
+#define EVSYS_ID_GEN_TC0_OVF 73
+#define EVSYS_ID_GEN_TC1_OVF 76
+#define EVSYS_ID_GEN_TC2_OVF 79
+#define EVSYS_ID_GEN_TC3_OVF 82
+#define EVSYS_ID_GEN_TC4_OVF 85
+#define EVSYS_ID_GEN_TC5_OVF 88
+#define EVSYS_ID_USER_ADC0_START 55
+#define EVSYS_ID_USER_ADC1_START 57
+
+/******************************************************************************
+ * TC, TCC, ADC, DAC
+ ******************************************************************************/
+
+typedef union {
+  struct {
+    uint32_t SWRST:1;
+    uint32_t ENABLE:1;
+    uint32_t MODE:2;
+    uint32_t PRESCSYNC:2;
+    uint32_t RUNSTDBY:1;
+    uint32_t ONDEMAND:1;
+    uint32_t PRESCALER:3;
+  } bit;
+  uint32_t reg;
+} TC_CTRLA_Type;
+
+typedef union {
+  struct {
+    uint16_t EVACT:3;
+    uint16_t :1;
+    uint16_t TCINV:1;
+    uint16_t TCEI:1;
+    uint16_t :2;
+    uint16_t OVFEO:1;
+    uint16_t :3;
+    uint16_t MCEO0:1;
+    uint16_t MCEO1:1;
+  } bit;
+  uint16_t reg;
+} TC_EVCTRL_Type;
+
+typedef union {
+  struct {
+    uint32_t SWRST:1;
+    uint32_t ENABLE:1;
+    uint32_t CTRLB:1;
+    uint32_t STATUS:1;
+    uint32_t COUNT:1;
+    uint32_t PER:1;
+    uint32_t CC0:1;
+    uint32_t CC1:1;
+  } bit;
+  uint32_t reg;
+} TC_SYNCBUSY_Type;
+
+typedef union { uint8_t reg; } TC_REG8_Type;
+typedef union { uint16_t reg; } TC_REG16_Type;
+
+typedef struct {
+  __IO TC_CTRLA_Type CTRLA;
+  __IO TC_REG8_Type CTRLBCLR;
+  __IO TC_REG8_Type CTRLBSET;
+  __IO TC_EVCTRL_Type EVCTRL;
+  __IO TC_REG8_Type INTENCLR;
+  __IO TC_REG8_Type INTENSET;
+  __IO TC_REG8_Type INTFLAG;
+  __IO TC_REG8_Type STATUS;
+  __IO TC_REG8_Type WAVE;
+  __IO TC_REG8_Type DRVCTRL;
+  uint8_t Reserved1[1];
+  __IO TC_REG8_Type DBGCTRL;
+  __I TC_SYNCBUSY_Type SYNCBUSY;
+  __IO TC_REG16_Type COUNT;
+  uint8_t Reserved2[6];
+  __IO TC_REG16_Type CC[2];
+  uint8_t Reserved3[16];
+  __IO TC_REG16_Type CCBUF[2];
+} TcCount16;
+
+// Only the 16-bit view is used by the library.
+typedef union {
+  TcCount16 COUNT16;
+} Tc;
+
+#define TC0 (sim::instance_<Tc, 0>())
+#define TC1 (sim::instance_<Tc, 1>())
+#define TC2 (sim::instance_<Tc, 2>())
+#define TC3 (sim::instance_<Tc, 3>())
+#define TC4 (sim::instance_<Tc, 4>())
+#define TC5 (sim::instance_<Tc, 5>())
+#define TC_INST_NUM 6
+#define TC_INSTS { TC0, TC1, TC2, TC3, TC4, TC5 }
+#define TC_CTRLA_MODE_COUNT16 (_U_(0x0) << 2)
+#define TC_CTRLA_PRESCALER_DIV1 (_U_(0x0) << 8)
+#define TC_WAVE_WAVEGEN_MFRQ (_U_(0x1) << 0)
+
+typedef union { uint32_t reg; } TCC_REG32_Type;
+
+typedef struct {
+  __IO TCC_REG32_Type CTRLA;
+  __IO TCC_REG32_Type PER;
+  __IO TCC_REG32_Type CC[6];
+  __IO TCC_REG32_Type PERBUF;
+  __IO TCC_REG32_Type CCBUF[6];
+} Tcc;
+
+#define TCC0 (sim::instance_<Tcc, 0>())
+#define TCC1 (sim::instance_<Tcc, 1>())
+#define TCC2 (sim::instance_<Tcc, 2>())
+#define TCC3 (sim::instance_<Tcc, 3>())
+#define TCC4 (sim::instance_<Tcc, 4>())
+#define TCC_INST_NUM 5
+#define TCC_INSTS { TCC0, TCC1, TCC2, TCC3, TCC4 }
+
+typedef union {
+  struct {
+    uint16_t SWRST:1;
+    uint16_t ENABLE:1;
+  } bit;
+  uint16_t reg;
+} ADC_CTRLA_Type;
+
+typedef union {
+  struct {
+    uint8_t FLUSHEI:1;
+    uint8_t STARTEI:1;
+    uint8_t FLUSHINV:1;
+    uint8_t STARTINV:1;
+    uint8_t RESRDYEO:1;
+    uint8_t WINMONEO:1;
+  } bit;
+  uint8_t reg;
+} ADC_EVCTRL_Type;
+
+typedef union {
+  struct {
+    uint32_t SWRST:1;
+    uint32_t ENABLE:1;
+  } bit;
+  uint32_t reg;
+} ADC_SYNCBUSY_Type;
+
+typedef union { uint16_t reg; } ADC_RESULT_Type;
+
+typedef struct {
+  __IO ADC_CTRLA_Type CTRLA;
+  __IO ADC_EVCTRL_Type EVCTRL;
+  __I ADC_SYNCBUSY_Type SYNCBUSY;
+  __I ADC_RESULT_Type RESULT;
+} Adc;
+
+#define ADC0 (sim::instance_<Adc, 0>())
+#define ADC1 (sim::instance_<Adc, 1>())
+#define ADC_INST_NUM 2
+#define ADC_INSTS { ADC0, ADC1 }
+
+typedef union { uint8_t reg; } DAC_CTRLA_Type;
+typedef union { uint16_t reg; } DAC_DATA_Type;
+
+typedef struct {
+  __IO DAC_CTRLA_Type CTRLA;
+  __IO DAC_DATA_Type DATA[2];
+} Dac;
+
+#define DAC (sim::instance_<Dac>())
+
+/******************************************************************************
+ * PORT
+ ******************************************************************************/
+
+typedef union { uint32_t reg; } PORT_REG32_Type;
+
+typedef union {
+  struct {
+    uint8_t PMUXEN:1;
+    uint8_t INEN:1;
+    uint8_t PULLEN:1;
+    uint8_t :3;
+    uint8_t DRVSTR:1;
+  } bit;
+  uint8_t reg;
+} PORT_PINCFG_Type;
+
+typedef struct {
+  __IO PORT_REG32_Type DIR;
+  __IO PORT_REG32_Type DIRCLR;
+  __IO PORT_REG32_Type DIRSET;
+  __IO PORT_REG32_Type DIRTGL;
+  __IO PORT_REG32_Type OUT;
+  __IO PORT_REG32_Type OUTCLR;
+  __IO PORT_REG32_Type OUTSET;
+  __IO PORT_REG32_Type OUTTGL;
+  __I PORT_REG32_Type IN;
+  __IO PORT_REG32_Type CTRL;
+  __O PORT_REG32_Type WRCONFIG;
+  __IO PORT_REG32_Type EVCTRL;
+  __IO uint8_t PMUX[16];
+  __IO PORT_PINCFG_Type PINCFG[32];
+  uint8_t Reserved1[32];
+} PortGroup;
+
+typedef struct {
+  PortGroup Group[4];
+} Port;
+
+#define PORT (sim::instance_<Port>())
+
+/******************************************************************************
+ * I2S, PCC
+ ******************************************************************************/
+
+typedef union { uint8_t reg; } I2S_REG8_Type;
+typedef union { uint16_t reg; } I2S_REG16_Type;
+typedef union { uint32_t reg; } I2S_REG32_Type;
+
+typedef struct {
+  __IO I2S_REG8_Type CTRLA;
+  uint8_t Reserved1[3];
+  __IO I2S_REG32_Type CLKCTRL[2];
+  __IO I2S_REG16_Type INTENCLR;
+  uint8_t Reserved2[2];
+  __IO I2S_REG16_Type INTENSET;
+  uint8_t Reserved3[2];
+  __IO I2S_REG16_Type INTFLAG;
+  uint8_t Reserved4[2];
+  __I I2S_REG16_Type SYNCBUSY;
+  uint8_t Reserved5[6];
+  __IO I2S_REG32_Type TXCTRL;
+  __IO I2S_REG32_Type RXCTRL;
+  uint8_t Reserved6[8];
+  __O I2S_REG32_Type TXDATA;
+  __I I2S_REG32_Type RXDATA;
+} I2s;
+
+#define I2S (sim::instance_<I2s>())
+#define I2S_GCLK_ID_0 47
+#define I2S_CTRLA_SWRST (_U_(0x1) << 0)
+#define I2S_CTRLA_ENABLE (_U_(0x1) << 1)
+#define I2S_CTRLA_CKEN0 (_U_(0x1) << 2)
+#define I2S_CTRLA_CKEN1 (_U_(0x1) << 3)
+#define I2S_CTRLA_TXEN (_U_(0x1) << 4)
+#define I2S_CTRLA_RXEN (_U_(0x1) << 5)
+#define I2S_CLKCTRL_SLOTSIZE(value) ((value) & 0x3)
+#define I2S_CLKCTRL_NBSLOTS(value) (((value) & 0x7) << 2)
+#define I2S_CLKCTRL_FSWIDTH(value) (((value) & 0x3) << 5)
+#define I2S_CLKCTRL_FSWIDTH_HALF_Val _U_(0x1)
+#define I2S_CLKCTRL_BITDELAY (_U_(0x1) << 7)
+#define I2S_CLKCTRL_FSSEL (_U_(0x1) << 8)
+#define I2S_CLKCTRL_SCKSEL (_U_(0x1) << 12)
+#define I2S_CLKCTRL_MCKDIV(value) (((value) & 0x3F) << 16)
+#define I2S_RXCTRL_SERMODE(value) ((value) & 0x3)
+#define I2S_RXCTRL_SERMODE_RX_Val _U_(0x0)
+#define I2S_RXCTRL_SLOTADJ (_U_(0x1) << 7)
+#define I2S_RXCTRL_DATASIZE(value) (((value) & 0x7) << 8)
+#define I2S_RXCTRL_DATASIZE_32_Val _U_(0x0)
+#define I2S_RXCTRL_DATASIZE_24_Val _U_(0x1)
+#define I2S_RXCTRL_DATASIZE_16_Val _U_(0x4)
+#define I2S_RXCTRL_DATASIZE_8_Val _U_(0x6)
+#define I2S_INTFLAG_RXOR0 (_U_(0x1) << 4)
+#define I2S_INTFLAG_RXOR1 (_U_(0x1) << 5)
+
+typedef union {
+  struct {
+    uint32_t PCEN:1;
+    uint32_t :3;
+    uint32_t DSIZE:2;
+    uint32_t :2;
+    uint32_t SCALE:1;
+    uint32_t ALWYS:1;
+    uint32_t HALFS:1;
+    uint32_t FRSTS:1;
+    uint32_t :4;
+    uint32_t ISIZE:3;
+    uint32_t :5;
+    uint32_t CID:2;
+  } bit;
+  uint32_t reg;
+} PCC_MR_Type;
+
+typedef union { uint32_t reg; } PCC_REG32_Type;
+
+typedef struct {
+  __IO PCC_MR_Type MR;
+  __O PCC_REG32_Type IER;
+  __O PCC_REG32_Type IDR;
+  __I PCC_REG32_Type IMR;
+  __I PCC_REG32_Type ISR;
+  __I PCC_REG32_Type RHR;
+} Pcc;
+
+#define PCC (sim::instance_<Pcc>())
+#define PCC_MR_PCEN (_U_(0x1) << 0)
+#define PCC_MR_DSIZE(value) (((value) & 0x3) << 4)
+#define PCC_MR_SCALE (_U_(0x1) << 8)
+#define PCC_MR_ALWYS (_U_(0x1) << 9)
+#define PCC_MR_HALFS (_U_(0x1) << 10)
+#define PCC_MR_ISIZE(value) (((value) & 0x7) << 16)
+#define PCC_ISR_OVRE (_U_(0x1) << 1)
+
+#include "dmac_model.h"
@@ -0,0 +1,74 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// channelConfig register values and channelCtrl<index>::setConfig bring-up
+// on the DMAC model, with the configGroup priority levels left at defaults.
+
+using namespace samc::dma;
+
+static uint32_t src[8];
+static uint32_t dst[8];
+
+void setUp(void) {
+  sim::reset();
+  sys::setInit(true);
+  sys::setEnabled(true);
+  for (int i = 0; i < 8; i++) {
+    src[i] = 0x5EED0000 + i;
+  }
+  memset(dst, 0, sizeof(dst));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+void test_register_values() {
+  typedef channelConfig<LINK_TC0_OOB, MODE_TRANSFER_4VALUE, 2, true, 2> burst;
+  TEST_ASSERT_EQUAL_HEX32(DMAC_CHCTRLA_TRIGSRC(LINK_TC0_OOB)
+    | DMAC_CHCTRLA_TRIGACT(DMAC_CHCTRLA_TRIGACT_BURST_Val)
+    | DMAC_CHCTRLA_BURSTLEN(DMAC_CHCTRLA_BURSTLEN_4BEAT_Val)
+    | DMAC_CHCTRLA_THRESHOLD(DMAC_CHCTRLA_THRESHOLD_2BEATS_Val)
+    | DMAC_CHCTRLA_RUNSTDBY, (uint32_t)burst::chctrla);
+  TEST_ASSERT_EQUAL_HEX8(2, (uint8_t)burst::chprilvl);
+
+  typedef channelConfig<LINK_NONE, MODE_TRANSFER_TASK> block;
+  TEST_ASSERT_EQUAL_HEX32(DMAC_CHCTRLA_TRIGACT(DMAC_CHCTRLA_TRIGACT_BLOCK_Val),
+    (uint32_t)block::chctrla);
+
+  typedef channelConfig<LINK_NONE> transaction;
+  TEST_ASSERT_EQUAL_HEX32(DMAC_CHCTRLA_TRIGACT(DMAC_CHCTRLA_TRIGACT_TRANSACTION_Val),
+    (uint32_t)transaction::chctrla);
+}
+
+// The two stores land as computed and the channel's priority level is
+// switched on, so it runs without touching configGroup::prilvl_enabled.
+void test_set_config() {
+  typedef channelConfig<LINK_NONE, MODE_TRANSFER_ALL, 3> config;
+  channelCtrl<4> dma;
+  TEST_ASSERT_TRUE(dma.setConfig<config>());
+  TEST_ASSERT_EQUAL_HEX32((uint32_t)config::chctrla,
+    DMAC->Channel[4].CHCTRLA.reg);
+  TEST_ASSERT_EQUAL_HEX8(3, DMAC->Channel[4].CHPRILVL.reg);
+  TEST_ASSERT_TRUE(DMAC->CTRL.bit.LVLEN3);
+  TEST_ASSERT_EQUAL(MODE_TRANSFER_ALL, dma.getTransferMode());
+
+  taskDescriptor task;
+  task.setSource(&src);
+  task.setDestination(&dst);
+  task.setLength(8);
+  task.setEnabled(true);
+  dma.addTask(0, task);
+  dma.setState(STATE_ACTIVE);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, sizeof(src));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_register_values);
+  RUN_TEST(test_set_config);
+  return UNITY_END();
+}
@@ -0,0 +1,508 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// Runs taskDescriptor chains and channel control on the DMAC model. Anything
+// a descriptor points at is static, see test/sim/sam.h.
+
+using namespace samc::dma;
+
+static uint32_t srcWords[16];
+static uint32_t dstWords[16];
+static uint8_t dstBytes[16];
+static uint16_t srcHalves[8];
+static uint16_t dstHalves[8];
+static volatile uint16_t fifo;
+
+static int transfers[DMAC_CH_NUM];
+static int errors[DMAC_CH_NUM];
+static CHANNEL_ERROR lastError;
+
+static void onTransfer(int index, void *context) {
+  transfers[index]++;
+}
+
+static void onError(int index, CHANNEL_ERROR error, void *context) {
+  errors[index]++;
+  lastError = error;
+}
+
+static void fill() {
+  for (int i = 0; i < 16; i++) {
+    srcWords[i] = 0x11111111u * (i + 1) + 0x00010203u;
+  }
+  for (int i = 0; i < 8; i++) {
+    srcHalves[i] = 0x0101 * (i + 1);
+  }
+  memset(dstWords, 0, sizeof(dstWords));
+  memset(dstBytes, 0, sizeof(dstBytes));
+  memset(dstHalves, 0, sizeof(dstHalves));
+}
+
+static void setInterrupt(taskDescriptor &task) {
+  ((DmacDescriptor*)task)->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  memset(transfers, 0, sizeof(transfers));
+  memset(errors, 0, sizeof(errors));
+  lastError = ERROR_NONE;
+  fill();
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setTransferCallback(nullptr, nullptr, i);
+    ch::setErrorCallback(nullptr, nullptr, i);
+    ch::setInit(false, i);
+  }
+}
+
+void test_end_addresses() {
+  taskDescriptor task;
+  TEST_ASSERT_TRUE(task.setSource(&srcWords));
+  TEST_ASSERT_TRUE(task.setDestination(&dstWords));
+  TEST_ASSERT_TRUE(task.setLength(16));
+
+  DmacDescriptor *desc = (DmacDescriptor*)task;
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)srcWords + 64, desc->SRCADDR.reg);
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)dstWords + 64, desc->DSTADDR.reg);
+  TEST_ASSERT_EQUAL_PTR(srcWords, task.getSource());
+  TEST_ASSERT_EQUAL_PTR(dstWords, task.getDestination());
+
+  TEST_ASSERT_TRUE(task.setLength(4));
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)srcWords + 16, desc->SRCADDR.reg);
+  TEST_ASSERT_EQUAL_PTR(srcWords, task.getSource());
+  TEST_ASSERT_EQUAL_PTR(dstWords, task.getDestination());
+}
+
+void test_word_copy() {
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setDestination(&dstWords);
+  task.setLength(16);
+  task.setEnabled(true);
+  setInterrupt(task);
+
+  channelCtrl<5> dma;
+  TEST_ASSERT_TRUE((dma.setConfig<channelConfig<LINK_NONE, MODE_TRANSFER_ALL, 1>>()));
+  dma.setTransferCallback(onTransfer);
+  TEST_ASSERT_TRUE(dma.addTask(0, task));
+  TEST_ASSERT_TRUE(dma.setState(STATE_ACTIVE));
+
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, dstWords, sizeof(srcWords));
+  TEST_ASSERT_EQUAL(1, transfers[5]);
+  TEST_ASSERT_EQUAL(STATE_DISABLED, dma.getState());
+  TEST_ASSERT_EQUAL_UINT32(16, sim::channel(5).beats);
+}
+
+// Shortening a task after both sides are set must only move the end
+// addresses, the DMAC then copies exactly the first length beats.
+void test_length_rebase() {
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setDestination(&dstWords);
+  task.setLength(16);
+  task.setLength(5);
+  task.setEnabled(true);
+
+  TEST_ASSERT_TRUE(ch::addTask(0, task, 6));
+  ch::setTransferMode(MODE_TRANSFER_ALL, 6);
+  ch::setState(STATE_ACTIVE, 6);
+
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, dstWords, 5 * sizeof(uint32_t));
+  TEST_ASSERT_EQUAL_UINT32(0, dstWords[5]);
+}
+
+// A word source into a byte destination steps the source by 4 beats.
+void test_step_source() {
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setDestination(&dstBytes);
+  task.setLength(16);
+  task.setEnabled(true);
+
+  DmacDescriptor *desc = (DmacDescriptor*)task;
+  TEST_ASSERT_EQUAL(DMAC_BTCTRL_BEATSIZE_BYTE_Val, desc->BTCTRL.bit.BEATSIZE);
+  TEST_ASSERT_EQUAL(DMAC_BTCTRL_STEPSEL_SRC_Val, desc->BTCTRL.bit.STEPSEL);
+  TEST_ASSERT_EQUAL(2, desc->BTCTRL.bit.STEPSIZE);
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)srcWords + 64, desc->SRCADDR.reg);
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)dstBytes + 16, desc->DSTADDR.reg);
+
+  ch::addTask(0, task, 7);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 7);
+  ch::setState(STATE_ACTIVE, 7);
+
+  for (int i = 0; i < 16; i++) {
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)srcWords[i], dstBytes[i]);
+  }
+}
+
+// Changing one side after the length is set rebases the other side too.
+void test_resize_side() {
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setLength(8);
+  task.setDestination(&dstWords);
+  task.setDestination(&dstHalves);
+  task.setEnabled(true);
+
+  DmacDescriptor *desc = (DmacDescriptor*)task;
+  TEST_ASSERT_EQUAL_PTR(srcWords, task.getSource());
+  TEST_ASSERT_EQUAL_PTR(dstHalves, task.getDestination());
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)srcWords + 32, desc->SRCADDR.reg);
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)dstHalves + 16, desc->DSTADDR.reg);
+
+  ch::addTask(0, task, 8);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 8);
+  ch::setState(STATE_ACTIVE, 8);
+
+  for (int i = 0; i < 8; i++) {
+    TEST_ASSERT_EQUAL_HEX16((uint16_t)srcWords[i], dstHalves[i]);
+  }
+}
+
+void test_static_task() {
+  typedef staticTask<uint16_t, uint16_t, 8, 1, DMAC_BTCTRL_BLOCKACT_INT_Val> copy;
+  taskDescriptor task;
+  TEST_ASSERT_TRUE(copy::apply(task, srcHalves, dstHalves));
+
+  ch::setTransferCallback(onTransfer, nullptr, 9);
+  ch::addTask(0, task, 9);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 9);
+  ch::setState(STATE_ACTIVE, 9);
+
+  TEST_ASSERT_EQUAL_MEMORY(srcHalves, dstHalves, sizeof(srcHalves));
+  TEST_ASSERT_EQUAL(1, transfers[9]);
+}
+
+// A fixed (volatile) source is read once per beat, each trigger moves one
+// burst of BURSTLEN + 1 beats.
+void test_peripheral_burst() {
+  taskDescriptor task;
+  task.setSource(&fifo);
+  task.setDestination(&dstHalves);
+  task.setLength(8);
+  task.setEnabled(true);
+  TEST_ASSERT_FALSE(((DmacDescriptor*)task)->BTCTRL.bit.SRCINC);
+
+  channelCtrl<10> dma;
+  dma.setConfig<channelConfig<LINK_TC0_OOB, MODE_TRANSFER_4VALUE>>();
+  dma.addTask(0, task);
+  dma.setState(STATE_IDLE);
+
+  fifo = 0xA5A5;
+  sim::trigger(10);
+  TEST_ASSERT_EQUAL_HEX16(0xA5A5, dstHalves[3]);
+  TEST_ASSERT_EQUAL_HEX16(0, dstHalves[4]);
+  TEST_ASSERT_EQUAL(4, dma.getBytesRemaining() / 2);
+
+  fifo = 0x5A5A;
+  sim::trigger(10);
+  TEST_ASSERT_EQUAL_HEX16(0x5A5A, dstHalves[7]);
+  TEST_ASSERT_EQUAL(STATE_DISABLED, dma.getState());
+}
+
+void test_chain_writeback() {
+  static uint32_t a[4], b[4], c[4];
+  taskDescriptor t0, t1, t2;
+  t0.setSource(&srcWords); t0.setDestination(&a); t0.setLength(4);
+  t1.setSource(&srcWords); t1.setDestination(&b); t1.setLength(4);
+  t2.setSource(&srcWords); t2.setDestination(&c); t2.setLength(4);
+  t0.setEnabled(true);
+  t1.setEnabled(true);
+  t2.setEnabled(true);
+  setInterrupt(t2);
+
+  channelCtrl<3> dma;
+  dma.setConfig<channelConfig<LINK_NONE, MODE_TRANSFER_TASK>>();
+  dma.setTransferCallback(onTransfer);
+  dma.setTasks({ &t0, &t1, &t2 });
+  TEST_ASSERT_EQUAL(3, dma.getTaskCount());
+  TEST_ASSERT_EQUAL(2, dma.indexOf(t2));
+
+  // One block per software trigger, the write-back copy tracks the block.
+  dma.setState(STATE_ACTIVE);
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, a, sizeof(a));
+  TEST_ASSERT_EQUAL_UINT32(0, b[0]);
+  taskDescriptor current = dma.getCurrentTask();
+  TEST_ASSERT_EQUAL_HEX32((uintptr_t)b + 16,
+    ((DmacDescriptor*)current)->DSTADDR.reg);
+
+  DMAC->SWTRIGCTRL.reg = 1 << 3;
+  DMAC->SWTRIGCTRL.reg = 1 << 3;
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, b, sizeof(b));
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, c, sizeof(c));
+  TEST_ASSERT_EQUAL(1, transfers[3]);
+  TEST_ASSERT_EQUAL(STATE_DISABLED, dma.getState());
+}
+
+// Progress follows the block the write-back copy is on, three blocks of
+// halfwords from a fixed source at two beats per trigger.
+void test_progress_blocks() {
+  static uint16_t a[4], b[6], c[2];
+  taskDescriptor t0, t1, t2;
+  t0.setSource(&fifo); t0.setDestination(&a); t0.setLength(4);
+  t1.setSource(&fifo); t1.setDestination(&b); t1.setLength(6);
+  t2.setSource(&fifo); t2.setDestination(&c); t2.setLength(2);
+  t0.setEnabled(true);
+  t1.setEnabled(true);
+  t2.setEnabled(true);
+
+  channelCtrl<11> dma;
+  dma.setConfig<channelConfig<LINK_TC0_OOB, MODE_TRANSFER_2VALUE>>();
+  dma.setTasks({ &t0, &t1, &t2 });
+  dma.setState(STATE_IDLE);
+  TEST_ASSERT_EQUAL(0, dma.getBytesTransferred());
+  TEST_ASSERT_EQUAL(8, dma.getBytesRemaining());
+
+  static const int expected[][2] = {
+    { 4, 4 }, { 0, 12 }, { 4, 8 }, { 8, 4 }, { 0, 4 }
+  };
+  for (int i = 0; i < 5; i++) {
+    sim::trigger(11);
+    TEST_ASSERT_EQUAL(expected[i][0], dma.getBytesTransferred());
+    TEST_ASSERT_EQUAL(expected[i][1], dma.getBytesRemaining());
+  }
+  sim::trigger(11);
+  TEST_ASSERT_EQUAL(STATE_DISABLED, dma.getState());
+}
+
+// A looped chain links its last block back to the base descriptor, the
+// progress goes back to the first block with it.
+void test_progress_looped() {
+  static uint16_t a[2], b[4];
+  taskDescriptor t0, t1;
+  t0.setSource(&fifo); t0.setDestination(&a); t0.setLength(2);
+  t1.setSource(&fifo); t1.setDestination(&b); t1.setLength(4);
+  t0.setEnabled(true);
+  t1.setEnabled(true);
+
+  channelCtrl<12> dma;
+  dma.setConfig<channelConfig<LINK_TC0_OOB, MODE_TRANSFER_1VALUE>>();
+  dma.setTasks({ &t0, &t1 });
+  dma.setLooped(true);
+  dma.setState(STATE_IDLE);
+
+  static const int expected[][2] = {
+    { 2, 2 }, { 0, 8 }, { 2, 6 }, { 4, 4 }, { 6, 2 }, { 0, 4 }, { 2, 2 }
+  };
+  for (int i = 0; i < 7; i++) {
+    sim::trigger(12);
+    TEST_ASSERT_EQUAL(expected[i][0], dma.getBytesTransferred());
+    TEST_ASSERT_EQUAL(expected[i][1], dma.getBytesRemaining());
+  }
+  TEST_ASSERT_NOT_EQUAL(STATE_DISABLED, dma.getState());
+  dma.setState(STATE_DISABLED);
+}
+
+// A task listed twice fails partway, the tasks already linked are handed
+// back with their settings and can be used on another channel.
+void test_set_tasks_rollback() {
+  static uint32_t a[4], b[4];
+  taskDescriptor t0, t1;
+  t0.setSource(&srcWords); t0.setDestination(&a); t0.setLength(4);
+  t1.setSource(&srcWords); t1.setDestination(&b); t1.setLength(4);
+  t0.setEnabled(true);
+  t1.setEnabled(true);
+
+  TEST_ASSERT_FALSE(ch::setTasks({ &t0, &t1, &t0 }, 5));
+  TEST_ASSERT_EQUAL(0, ch::getTaskCount(5));
+  TEST_ASSERT_EQUAL(-1, t0.getAssignedChannel());
+  TEST_ASSERT_EQUAL(-1, t1.getAssignedChannel());
+  TEST_ASSERT_NULL(t0.getLinkedTask());
+  TEST_ASSERT_EQUAL(4, t0.getLength());
+  TEST_ASSERT_EQUAL_PTR(&a, t0.getDestination());
+
+  TEST_ASSERT_TRUE(ch::setTasks({ &t0, &t1 }, 6));
+  TEST_ASSERT_EQUAL(2, ch::getTaskCount(6));
+  ch::setTransferMode(MODE_TRANSFER_ALL, 6);
+  ch::setState(STATE_ACTIVE, 6);
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, a, sizeof(a));
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, b, sizeof(b));
+}
+
+void test_looped_chain() {
+  static uint32_t ring[2];
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setDestination(&ring);
+  task.setLength(2);
+  task.setEnabled(true);
+
+  ch::addTask(0, task, 11);
+  TEST_ASSERT_TRUE(ch::setLooped(true, 11));
+  TEST_ASSERT_TRUE(ch::getLooped(11));
+  ch::setTransferMode(MODE_TRANSFER_TASK, 11);
+  ch::setState(STATE_ACTIVE, 11);
+  TEST_ASSERT_EQUAL_UINT32(srcWords[1], ring[1]);
+
+  ring[0] = 0;
+  DMAC->SWTRIGCTRL.reg = 1 << 11;
+  TEST_ASSERT_EQUAL_UINT32(srcWords[0], ring[0]);
+  TEST_ASSERT_EQUAL(STATE_ACTIVE, ch::getState(11));
+  TEST_ASSERT_EQUAL_UINT32(2, sim::channel(11).blocks);
+}
+
+// BLOCKACT SUSPEND parks the channel after the block, setState(ACTIVE)
+// carries on with the next one.
+void test_suspend_resume() {
+  static uint32_t a[4], b[4];
+  taskDescriptor t0, t1;
+  t0.setSource(&srcWords); t0.setDestination(&a); t0.setLength(4);
+  t1.setSource(&srcWords); t1.setDestination(&b); t1.setLength(4);
+  t0.setEnabled(true);
+  t1.setEnabled(true);
+  t0.setSuspendChannel(true);
+
+  channelCtrl<12> dma;
+  dma.setConfig<channelConfig<LINK_NONE, MODE_TRANSFER_ALL>>();
+  dma.setTasks({ &t0, &t1 });
+  dma.setState(STATE_ACTIVE);
+
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, a, sizeof(a));
+  TEST_ASSERT_EQUAL_UINT32(0, b[0]);
+  TEST_ASSERT_EQUAL(STATE_SUSPENDED, dma.getState());
+
+  TEST_ASSERT_TRUE(dma.setState(STATE_ACTIVE));
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, b, sizeof(b));
+  TEST_ASSERT_EQUAL(STATE_DISABLED, dma.getState());
+}
+
+// Clearing SUSP by hand must not take TCMPL or TERR with it.
+void test_suspend_keeps_flags() {
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setDestination(&dstWords);
+  task.setLength(4);
+  task.setEnabled(true);
+  setInterrupt(task);
+
+  ch::addTask(0, task, 13);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 13);
+  ch::setState(STATE_ACTIVE, 13);
+  TEST_ASSERT_TRUE(sim::flags(13) & DMAC_CHINTFLAG_TCMPL);
+
+  ch::setState(STATE_SUSPENDED, 13);
+  TEST_ASSERT_EQUAL(STATE_SUSPENDED, ch::getState(13));
+  ch::setState(STATE_IDLE, 13);
+  TEST_ASSERT_TRUE(sim::flags(13) & DMAC_CHINTFLAG_TCMPL);
+  TEST_ASSERT_FALSE(sim::flags(13) & DMAC_CHINTFLAG_SUSP);
+}
+
+void test_fetch_error() {
+  static uint32_t a[4], b[4];
+  taskDescriptor t0, t1;
+  t0.setSource(&srcWords); t0.setDestination(&a); t0.setLength(4);
+  t1.setSource(&srcWords); t1.setDestination(&b); t1.setLength(4);
+  t0.setEnabled(true);
+
+  ch::setTasks({ &t0, &t1 }, 14);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 14);
+  ch::setState(STATE_ACTIVE, 14);
+
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, a, sizeof(a));
+  TEST_ASSERT_TRUE(DMAC->Channel[14].CHSTATUS.bit.FERR);
+  TEST_ASSERT_EQUAL(STATE_SUSPENDED, ch::getState(14));
+
+  t1.setEnabled(true);
+  DMAC->Channel[14].CHCTRLB.reg = DMAC_CHCTRLB_CMD_RESUME_Val;
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, b, sizeof(b));
+  TEST_ASSERT_FALSE(DMAC->Channel[14].CHSTATUS.bit.FERR);
+}
+
+void test_transfer_error() {
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setDestination((uint32_t*)0x100);
+  task.setLength(4);
+  task.setEnabled(true);
+
+  ch::setErrorCallback(onError, nullptr, 15);
+  ch::addTask(0, task, 15);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 15);
+  ch::setState(STATE_ACTIVE, 15);
+
+  TEST_ASSERT_EQUAL(1, errors[15]);
+  TEST_ASSERT_EQUAL(ERROR_TRANSFER, lastError);
+  TEST_ASSERT_EQUAL(STATE_DISABLED, ch::getState(15));
+}
+
+void test_injected_error() {
+  taskDescriptor task;
+  task.setSource(&srcWords);
+  task.setDestination(&dstWords);
+  task.setLength(16);
+  task.setEnabled(true);
+
+  ch::setErrorCallback(onError, nullptr, 1);
+  ch::addTask(0, task, 1);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 1);
+  sim::failAfter(1, 6);
+  ch::setState(STATE_ACTIVE, 1);
+
+  TEST_ASSERT_EQUAL(1, errors[1]);
+  TEST_ASSERT_EQUAL_MEMORY(srcWords, dstWords, 6 * sizeof(uint32_t));
+  TEST_ASSERT_EQUAL_UINT32(0, dstWords[6]);
+}
+
+// TCMPL reaches the handler only once PRIMASK is cleared, channels 0 - 3
+// come through their own vector and the rest through DMAC_4.
+void test_interrupt_routing() {
+  static uint32_t a[4], b[4];
+  taskDescriptor t0, t1;
+  t0.setSource(&srcWords); t0.setDestination(&a); t0.setLength(4);
+  t1.setSource(&srcWords); t1.setDestination(&b); t1.setLength(4);
+  t0.setEnabled(true);
+  t1.setEnabled(true);
+  setInterrupt(t0);
+  setInterrupt(t1);
+
+  ch::setTransferCallback(onTransfer, nullptr, 2);
+  ch::setTransferCallback(onTransfer, nullptr, 20);
+  ch::addTask(0, t0, 2);
+  ch::addTask(0, t1, 20);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 2);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 20);
+
+  __disable_irq();
+  ch::setState(STATE_ACTIVE, 2);
+  ch::setState(STATE_ACTIVE, 20);
+  TEST_ASSERT_EQUAL(0, transfers[2] + transfers[20]);
+  TEST_ASSERT_EQUAL_HEX32((1u << 2) | (1u << 20), DMAC->INTSTATUS.reg);
+
+  __enable_irq();
+  TEST_ASSERT_EQUAL(1, transfers[2]);
+  TEST_ASSERT_EQUAL(1, transfers[20]);
+  TEST_ASSERT_EQUAL_HEX32(0, DMAC->INTSTATUS.reg);
+  TEST_ASSERT_FALSE(sim::model().stuck);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_end_addresses);
+  RUN_TEST(test_word_copy);
+  RUN_TEST(test_length_rebase);
+  RUN_TEST(test_step_source);
+  RUN_TEST(test_resize_side);
+  RUN_TEST(test_static_task);
+  RUN_TEST(test_peripheral_burst);
+  RUN_TEST(test_chain_writeback);
+  RUN_TEST(test_progress_blocks);
+  RUN_TEST(test_progress_looped);
+  RUN_TEST(test_set_tasks_rollback);
+  RUN_TEST(test_looped_chain);
+  RUN_TEST(test_suspend_resume);
+  RUN_TEST(test_suspend_keeps_flags);
+  RUN_TEST(test_fetch_error);
+  RUN_TEST(test_transfer_error);
+  RUN_TEST(test_injected_error);
+  RUN_TEST(test_interrupt_routing);
+  return UNITY_END();
+}
@@ -0,0 +1,181 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// crc:: on the host model. Spans of DMA_CRC_MIN_BYTES or more go through the
+// CRC engine, which keeps CRC32 bit-reversed in CRCCHKSUM as the datasheet
+// has it; the results are checked against a bitwise reference. update_async
+// hands the result over from the CRC channel's interrupt.
+
+using namespace samc::dma;
+
+static uint8_t data[300] __ALIGNED(4);
+static uint8_t copy[128] __ALIGNED(4);
+static uint8_t large[70000] __ALIGNED(4);
+
+static int doneCount;
+static bool doneFailed;
+
+static void onDone(crc::crcState &state, bool failed, void *context) {
+  doneCount++;
+  doneFailed = failed;
+  *(uint32_t*)context = crc::finish(state);
+}
+
+static uint32_t reference32(const uint8_t *bytes, const size_t &length) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= bytes[i];
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+    }
+  }
+  return ~crc;
+}
+
+static uint16_t reference16(const uint8_t *bytes, const size_t &length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)bytes[i] << 8;
+    for (int k = 0; k < 8; k++) {
+      crc = (crc & 0x8000) ? (uint16_t)(crc << 1) ^ 0x1021 : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  uint32_t seed = 12345;
+  for (size_t i = 0; i < sizeof(data); i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+  memset(copy, 0, sizeof(copy));
+  doneCount = 0;
+  doneFailed = false;
+}
+
+void tearDown(void) {
+  crc::detach();
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+void test_check_values() {
+  const char *check = "123456789";
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc::compute(ioSpan(check, 9), CRC_TYPE_32));
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, crc::compute(ioSpan(check, 9), CRC_TYPE_16));
+}
+
+// Word beats for an aligned span, byte beats otherwise.
+void test_hardware_compute() {
+  const uint32_t fetches = sim::model().fetches;
+  TEST_ASSERT_EQUAL_HEX32(reference32(data, 256),
+    crc::compute(ioSpan(data, 256), CRC_TYPE_32));
+  TEST_ASSERT_TRUE(sim::model().fetches > fetches);
+  TEST_ASSERT_EQUAL_HEX32(reference32(data + 1, 201),
+    crc::compute(ioSpan(data + 1, 201), CRC_TYPE_32));
+  TEST_ASSERT_EQUAL_HEX16(reference16(data, 256),
+    crc::compute(ioSpan(data, 256), CRC_TYPE_16));
+  TEST_ASSERT_EQUAL_HEX16(reference16(data + 3, 97),
+    crc::compute(ioSpan(data + 3, 97), CRC_TYPE_16));
+
+  // Both polynomials were matched, not left to the software fallback.
+  TEST_ASSERT_TRUE(crc::attach(10, CRC_TYPE_16));
+  crc::detach();
+  TEST_ASSERT_TRUE(crc::attach(10, CRC_TYPE_32));
+  crc::detach();
+}
+
+// Hardware and software spans mixed in one running value.
+void test_running_value() {
+  crc::crcState state = crc::begin(CRC_TYPE_32);
+  TEST_ASSERT_TRUE(crc::update(state, ioSpan(data, 100)));
+  TEST_ASSERT_TRUE(crc::update(state, ioSpan(data + 100, 7)));
+  TEST_ASSERT_TRUE(crc::update(state, ioSpan(data + 107, 193)));
+  TEST_ASSERT_EQUAL_HEX32(reference32(data, 300), crc::finish(state));
+}
+
+// The CRC of whatever a channel moves, the engine stays locked meanwhile.
+void test_attach() {
+  taskDescriptor task;
+  task.setSource(&data);
+  task.setDestination(&copy);
+  task.setLength(sizeof(copy));
+  task.setEnabled(true);
+  ch::addTask(0, task, 9);
+  ch::setTransferMode(MODE_TRANSFER_ALL, 9);
+
+  TEST_ASSERT_TRUE(crc::attach(9, CRC_TYPE_32));
+  TEST_ASSERT_FALSE(crc::attach(10, CRC_TYPE_16));
+  ch::setState(STATE_ACTIVE, 9);
+  TEST_ASSERT_EQUAL_MEMORY(data, copy, sizeof(copy));
+  TEST_ASSERT_EQUAL_HEX32(reference32(data, sizeof(copy)), crc::detach());
+
+  // Released, so a hardware span works again.
+  TEST_ASSERT_EQUAL_HEX16(reference16(data, 128),
+    crc::compute(ioSpan(data, 128), CRC_TYPE_16));
+}
+
+// The engine stays busy until the CRC channel's interrupt is taken, the
+// callback then runs once with the running value advanced.
+void test_async() {
+  crc::crcState state = crc::begin(CRC_TYPE_32);
+  uint32_t result = 0;
+  __disable_irq();
+  TEST_ASSERT_TRUE(crc::update_async(state, ioSpan(data, 256), onDone, &result));
+  TEST_ASSERT_TRUE(crc::getBusy());
+  TEST_ASSERT_EQUAL(CRC_BUSY, crc::getStatus());
+  TEST_ASSERT_EQUAL(0, doneCount);
+  TEST_ASSERT_FALSE(crc::attach(10, CRC_TYPE_16));
+  TEST_ASSERT_EQUAL_UINT32(0, crc::detach());
+  __enable_irq();
+  TEST_ASSERT_EQUAL(1, doneCount);
+  TEST_ASSERT_FALSE(doneFailed);
+  TEST_ASSERT_FALSE(crc::getBusy());
+  TEST_ASSERT_EQUAL_HEX32(reference32(data, 256), result);
+
+  // Short spans are done in software with the callback before returning.
+  TEST_ASSERT_TRUE(crc::update_async(state, ioSpan(data + 256, 7), onDone, 
+    &result));
+  TEST_ASSERT_EQUAL(2, doneCount);
+  TEST_ASSERT_EQUAL_HEX32(reference32(data, 263), result);
+  TEST_ASSERT_FALSE(crc::update_async(state, ioSpan(nullptr, 4), onDone));
+}
+
+// A byte-wide span longer than one descriptor is fed chunk by chunk from
+// the transfer callback.
+void test_long_span() {
+  for (size_t i = 0; i < sizeof(large); i++) {
+    large[i] = data[i % sizeof(data)] ^ (i >> 8);
+  }
+  crc::crcState state = crc::begin(CRC_TYPE_16);
+  uint32_t result = 0;
+  const uint32_t fetches = sim::model().fetches;
+  TEST_ASSERT_TRUE(crc::update_async(state, ioSpan(large + 1, 69999), onDone,
+    &result));
+  TEST_ASSERT_EQUAL(1, doneCount);
+  TEST_ASSERT_EQUAL_HEX16(reference16(large + 1, 69999), result);
+  TEST_ASSERT_EQUAL_UINT32(fetches + 2, sim::model().fetches);
+
+  TEST_ASSERT_EQUAL_HEX32(reference32(large, sizeof(large)),
+    crc::compute(ioSpan(large), CRC_TYPE_32));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_check_values);
+  RUN_TEST(test_hardware_compute);
+  RUN_TEST(test_running_value);
+  RUN_TEST(test_attach);
+  RUN_TEST(test_async);
+  RUN_TEST(test_long_span);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include <unity.h>
+#include <string.h>
+#include <dma_core.h>
+
+// The software paths crc:: falls back to on the host model: a span the CRC
+// channel faults on, a span issued while the engine is attached to another
+// channel, and update() called with interrupts masked, which cannot wait
+// for the CRC channel's interrupt. Every path ends on the software value.
+
+using namespace samc::dma;
+
+static uint8_t data[256] __ALIGNED(4);
+static int doneCount;
+static bool doneFailed;
+
+static void onDone(crc::crcState &state, bool failed, void *context) {
+  doneCount++;
+  doneFailed = failed;
+}
+
+static int crcChannel() {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    const char *owner = allocCtrl::getOwner(i);
+    if (owner && !strcmp(owner, "crc")) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = i * 7 + 3;
+  }
+  doneCount = 0;
+  doneFailed = false;
+}
+
+void tearDown(void) {
+  crc::detach();
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::setInit(false, i);
+  }
+}
+
+// update() redoes a faulted span in software, update_async() reports it
+// and leaves the running value alone.
+void test_fault_fallback() {
+  const uint32_t expected = ~crc::updateSoftware(CRC_TYPE_32, 0xFFFFFFFF,
+    data, sizeof(data));
+  TEST_ASSERT_EQUAL_HEX32(expected, crc::compute(ioSpan(data), CRC_TYPE_32));
+  const int index = crcChannel();
+  TEST_ASSERT_TRUE(index >= 0);
+
+  sim::failAfter(index, 10);
+  TEST_ASSERT_EQUAL_HEX32(expected, crc::compute(ioSpan(data), CRC_TYPE_32));
+  TEST_ASSERT_FALSE(crc::getBusy());
+
+  crc::crcState state = crc::begin(CRC_TYPE_32);
+  sim::failAfter(index, 10);
+  TEST_ASSERT_TRUE(crc::update_async(state, ioSpan(data), onDone));
+  TEST_ASSERT_EQUAL(1, doneCount);
+  TEST_ASSERT_TRUE(doneFailed);
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, state.value);
+  TEST_ASSERT_FALSE(crc::getBusy());
+  TEST_ASSERT_EQUAL(CRC_DISABLED, crc::getStatus());
+
+  // The channel is taken up again by the next span.
+  const uint32_t fetches = sim::model().fetches;
+  TEST_ASSERT_EQUAL_HEX32(expected, crc::compute(ioSpan(data), CRC_TYPE_32));
+  TEST_ASSERT_TRUE(sim::model().fetches > fetches);
+}
+
+// Attached to a channel the engine is not free, spans go to software.
+void test_attached_fallback() {
+  const uint32_t expected = crc::updateSoftware(CRC_TYPE_16, 0xFFFF,
+    data, sizeof(data));
+  TEST_ASSERT_TRUE(crc::attach(4, CRC_TYPE_32));
+  const uint32_t fetches = sim::model().fetches;
+  TEST_ASSERT_EQUAL_HEX16(expected, crc::compute(ioSpan(data), CRC_TYPE_16));
+  crc::crcState state = crc::begin(CRC_TYPE_16);
+  TEST_ASSERT_TRUE(crc::update_async(state, ioSpan(data), onDone));
+  TEST_ASSERT_EQUAL(1, doneCount);
+  TEST_ASSERT_FALSE(doneFailed);
+  TEST_ASSERT_EQUAL_HEX16(expected, state.value);
+  TEST_ASSERT_EQUAL_UINT32(fetches, sim::model().fetches);
+}
+
+void test_masked_fallback() {
+  const uint32_t expected = crc::updateSoftware(CRC_TYPE_16, 0xFFFF,
+    data, sizeof(data));
+  const uint32_t fetches = sim::model().fetches;
+  __disable_irq();
+  TEST_ASSERT_EQUAL_HEX16(expected, crc::compute(ioSpan(data), CRC_TYPE_16));
+  __enable_irq();
+  TEST_ASSERT_EQUAL_UINT32(fetches, sim::model().fetches);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fault_fallback);
+  RUN_TEST(test_attached_fallback);
+  RUN_TEST(test_masked_fallback);
+  return UNITY_END();
+}
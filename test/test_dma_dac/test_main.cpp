@@ -0,0 +1,136 @@
+#include <unity.h>
+#include <dac_core.h>
+
+// dac::setPlayback and the wavePlayer behind it on the host model: the
+// channel reservation, table looping on the EMPTY trigger and a table swap
+// landing on a period boundary.
+
+using namespace samc;
+
+static const int16_t unit[4] = { 0, 32767, 0, -32767 };
+static uint16_t sine[4];
+static uint16_t ramp[3];
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    dma::configGroup::prilvl_enabled[i] = true;
+  }
+  dma::sys::setInit(true);
+  dma::sys::setEnabled(true);
+  memset((void*)DAC, 0, sizeof(Dac));
+  dac::scaleTable(unit, sine, 4, 2000, 2048);
+  for (int i = 0; i < 3; i++) {
+    ramp[i] = 100 * (i + 1);
+  }
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    dma::allocCtrl::release(i);
+    dma::ch::clearTasks(i);
+    dma::ch::setInit(false, i);
+  }
+}
+
+void test_scale_table() {
+  TEST_ASSERT_EQUAL_UINT16(2048, sine[0]);
+  TEST_ASSERT_EQUAL_UINT16(2048 + 1999, sine[1]);
+  TEST_ASSERT_EQUAL_UINT16(2048 - 2000, sine[3]);
+
+  uint16_t codes[4];
+  TEST_ASSERT_TRUE(dac::scaleTable(unit, codes, 4, 4095, 2048));
+  TEST_ASSERT_EQUAL_UINT16(DAC_MAX_CODE, codes[1]);
+  TEST_ASSERT_EQUAL_UINT16(0, codes[3]);
+  TEST_ASSERT_FALSE(dac::scaleTable(unit, codes, 4, DAC_MAX_CODE + 1, 0));
+  TEST_ASSERT_FALSE(dac::scaleTable(unit, codes, 0, 100, 0));
+}
+
+// One converter sample per EMPTY trigger, wrapping at the end of the table.
+void test_playback_loops() {
+  dma::wavePlayer player;
+  TEST_ASSERT_TRUE((dac::setPlayback<4, 0>(player)));
+  TEST_ASSERT_EQUAL_STRING("dac playback", dma::allocCtrl::getOwner(4));
+  TEST_ASSERT_EQUAL(dma::LINK_DAC_EMPTY0, dma::ch::getPeripheral(4));
+  TEST_ASSERT_EQUAL(dma::MODE_TRANSFER_1VALUE, dma::ch::getTransferMode(4));
+
+  TEST_ASSERT_TRUE(player.play(sine, 4));
+  TEST_ASSERT_EQUAL(dma::STATE_IDLE, dma::ch::getState(4));
+  for (int i = 0; i < 10; i++) {
+    sim::trigger(4);
+    TEST_ASSERT_EQUAL_UINT16(sine[i % 4], DAC->DATA[0].reg);
+  }
+  TEST_ASSERT_EQUAL_UINT16(0, DAC->DATA[1].reg);
+  TEST_ASSERT_TRUE(player.detach());
+}
+
+// A second playback on a reserved channel fails and leaves the first one
+// configured and playing; a failed attach hands the reservation back.
+void test_reserved_channel() {
+  dma::wavePlayer player, other;
+  TEST_ASSERT_TRUE((dac::setPlayback<4, 0>(player)));
+  TEST_ASSERT_TRUE(player.play(sine, 4));
+  sim::trigger(4);
+
+  TEST_ASSERT_FALSE((dac::setPlayback<4, 1>(other)));
+  TEST_ASSERT_EQUAL(-1, other.getChannel());
+  TEST_ASSERT_EQUAL(dma::LINK_DAC_EMPTY0, dma::ch::getPeripheral(4));
+  sim::trigger(4);
+  TEST_ASSERT_EQUAL_UINT16(sine[1], DAC->DATA[0].reg);
+  TEST_ASSERT_EQUAL_UINT16(0, DAC->DATA[1].reg);
+
+  TEST_ASSERT_FALSE((dac::setPlayback<5, 1>(player)));
+  TEST_ASSERT_NULL(dma::allocCtrl::getOwner(5));
+  TEST_ASSERT_TRUE(player.detach());
+}
+
+// The running period carries the old link, so the new table starts after
+// the period that follows it. The swap is folded back into the base
+// descriptor once the standby has been fetched and a further swap can follow.
+void test_table_swap() {
+  dma::wavePlayer player;
+  TEST_ASSERT_TRUE((dac::setPlayback<6, 1>(player)));
+  TEST_ASSERT_TRUE(player.play(sine, 4));
+  sim::trigger(6);
+
+  TEST_ASSERT_TRUE(player.play(ramp, 3));
+  TEST_ASSERT_TRUE(player.getPending());
+  TEST_ASSERT_FALSE(player.play(sine, 4));
+  for (int i = 1; i < 4; i++) {
+    sim::trigger(6);
+    TEST_ASSERT_EQUAL_UINT16(sine[i], DAC->DATA[1].reg);
+  }
+  TEST_ASSERT_EQUAL_PTR(ramp, player.getTable());
+  for (int i = 0; i < 4; i++) {
+    sim::trigger(6);
+    TEST_ASSERT_EQUAL_UINT16(sine[i], DAC->DATA[1].reg);
+  }
+  for (int i = 0; i < 7; i++) {
+    sim::trigger(6);
+    TEST_ASSERT_EQUAL_UINT16(ramp[i % 3], DAC->DATA[1].reg);
+  }
+  TEST_ASSERT_FALSE(player.getPending());
+
+  // One sample into a ramp period: its rest and one more period play first.
+  TEST_ASSERT_TRUE(player.play(sine, 4));
+  for (int i = 0; i < 2 + 3; i++) {
+    sim::trigger(6);
+    TEST_ASSERT_EQUAL_UINT16(ramp[(i + 1) % 3], DAC->DATA[1].reg);
+  }
+  for (int i = 0; i < 6; i++) {
+    sim::trigger(6);
+    TEST_ASSERT_EQUAL_UINT16(sine[i % 4], DAC->DATA[1].reg);
+  }
+  TEST_ASSERT_EQUAL_PTR(sine, player.getTable());
+  TEST_ASSERT_FALSE(player.getPending());
+  TEST_ASSERT_TRUE(player.detach());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_scale_table);
+  RUN_TEST(test_playback_loops);
+  RUN_TEST(test_reserved_channel);
+  RUN_TEST(test_table_swap);
+  return UNITY_END();
+}
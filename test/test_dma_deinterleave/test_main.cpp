@@ -0,0 +1,102 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// deinterleave on the host model, in both directions and with a padded
+// frame, plus the argument checks.
+
+using namespace samc::dma;
+
+static uint16_t frames[4 * 16];
+static uint16_t planes[4][16];
+static uint16_t mixed[2 * 16];
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  for (int i = 0; i < 4 * 16; i++) {
+    frames[i] = ((i % 4) << 8) | (i / 4);
+  }
+  memset(planes, 0, sizeof(planes));
+  memset(mixed, 0, sizeof(mixed));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// Channel c of frame s lands in planes[c][s].
+void test_planar() {
+  void *const out[4] = { planes[0], planes[1], planes[2], planes[3] };
+  TEST_ASSERT_TRUE(deinterleave(frames, out, 4, 16, 2));
+  for (int c = 0; c < 4; c++) {
+    for (int s = 0; s < 16; s++) {
+      TEST_ASSERT_EQUAL_HEX16((c << 8) | s, planes[c][s]);
+    }
+  }
+  TEST_ASSERT_EQUAL(STATE_DISABLED, ch::getState(2));
+}
+
+// Three channels in four-sample frames, the pad sample is skipped.
+void test_padded_frame() {
+  void *const out[3] = { planes[0], planes[1], planes[2] };
+  TEST_ASSERT_TRUE(deinterleave(frames, out, 3, 16, 2, 2, 4));
+  for (int c = 0; c < 3; c++) {
+    TEST_ASSERT_EQUAL_HEX16((c << 8) | 15, planes[c][15]);
+  }
+  TEST_ASSERT_EQUAL_HEX16(0, planes[3][0]);
+}
+
+// Planar source, strided destination: the planes are interleaved again.
+void test_interleave() {
+  for (int s = 0; s < 16; s++) {
+    planes[0][s] = 0x100 + s;
+    planes[1][s] = 0x200 + s;
+  }
+  void *const out[2] = { &mixed[0], &mixed[1] };
+  TEST_ASSERT_TRUE(deinterleave(planes, out, 2, 16, 2, 2, 1, 2));
+  for (int s = 0; s < 16; s++) {
+    TEST_ASSERT_EQUAL_HEX16(0x100 + s, mixed[2 * s]);
+    TEST_ASSERT_EQUAL_HEX16(0x200 + s, mixed[2 * s + 1]);
+  }
+}
+
+void test_rejects() {
+  void *const out[4] = { planes[0], planes[1], planes[2], planes[3] };
+  void *const odd[2] = { planes[0], (uint8_t*)planes[1] + 1 };
+  TEST_ASSERT_FALSE(deinterleave(frames, out, 3, 16, 2));
+  TEST_ASSERT_FALSE(deinterleave(frames, out, 2, 16, 2, 2, 2, 2));
+  TEST_ASSERT_FALSE(deinterleave((uint8_t*)frames + 1, out, 4, 16, 2));
+  TEST_ASSERT_FALSE(deinterleave(frames, odd, 2, 16, 2));
+  TEST_ASSERT_FALSE(deinterleave(frames, out, 4, 16, 2, 3));
+  TEST_ASSERT_FALSE(deinterleave(frames, out, 4, 16, DMAC_CH_NUM));
+}
+
+// A peripheral triggered channel is left armed instead of started.
+void test_peripheral_trigger() {
+  ch::setPeripheral(LINK_TC0_OOB, 7);
+  ch::setTransferMode(MODE_TRANSFER_4VALUE, 7);
+  void *const out[4] = { planes[0], planes[1], planes[2], planes[3] };
+  TEST_ASSERT_TRUE(deinterleave(frames, out, 4, 16, 7));
+  TEST_ASSERT_EQUAL(STATE_IDLE, ch::getState(7));
+  TEST_ASSERT_EQUAL_HEX16(0, planes[0][0]);
+
+  sim::trigger(7, 16);
+  TEST_ASSERT_EQUAL_HEX16((3 << 8) | 15, planes[3][15]);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_planar);
+  RUN_TEST(test_padded_frame);
+  RUN_TEST(test_interleave);
+  RUN_TEST(test_rejects);
+  RUN_TEST(test_peripheral_trigger);
+  return UNITY_END();
+}
@@ -0,0 +1,92 @@
+#include <unity.h>
+#include <evsys_core.h>
+
+// evsys::setSamplingChain on the host: the event route and peripheral
+// event bits it sets up, the DMA channel reservation, and one beat per
+// ADC result once the channel has its task.
+
+using namespace samc;
+
+static uint16_t samples[4];
+
+void setUp(void) {
+  sim::reset();
+  dma::sys::setInit(true);
+  dma::sys::setEnabled(true);
+  memset((void*)EVSYS, 0, sizeof(Evsys));
+  memset((void*)TC3, 0, sizeof(Tc));
+  memset((void*)ADC1, 0, sizeof(Adc));
+  memset(samples, 0, sizeof(samples));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < EVSYS_CHANNELS; i++) {
+    evsys::releaseChannel(i);
+  }
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    dma::allocCtrl::release(i);
+    dma::ch::clearTasks(i);
+    dma::ch::setInit(false, i);
+  }
+}
+
+void test_chain_routing() {
+  TC3->COUNT16.CTRLA.bit.ENABLE = 1;
+  const int channel = evsys::setSamplingChain<6, 3, 1>();
+  TEST_ASSERT_NOT_EQUAL(EVSYS_NO_CHANNEL, channel);
+
+  TEST_ASSERT_EQUAL(EVSYS_ID_GEN_TC3_OVF, EVSYS->Channel[channel].CHANNEL.bit.EVGEN);
+  TEST_ASSERT_EQUAL(channel + 1, EVSYS->USER[EVSYS_ID_USER_ADC1_START].reg);
+  TEST_ASSERT_TRUE(TC3->COUNT16.EVCTRL.bit.OVFEO);
+  TEST_ASSERT_TRUE(TC3->COUNT16.CTRLA.bit.ENABLE);
+  TEST_ASSERT_TRUE(ADC1->EVCTRL.bit.STARTEI);
+  TEST_ASSERT_FALSE(ADC1->CTRLA.bit.ENABLE);
+
+  TEST_ASSERT_EQUAL(dma::LINK_ADC1_RESRDY, dma::ch::getPeripheral(6));
+  TEST_ASSERT_EQUAL(dma::MODE_TRANSFER_1VALUE, dma::ch::getTransferMode(6));
+  TEST_ASSERT_EQUAL_STRING("evsys sampling", dma::allocCtrl::getOwner(6));
+}
+
+// A second chain on the same DMA channel fails without taking an EVSYS
+// channel or touching the first chain's DMA configuration.
+void test_reserved_channel() {
+  const int channel = evsys::setSamplingChain<7, 0>();
+  TEST_ASSERT_NOT_EQUAL(EVSYS_NO_CHANNEL, channel);
+  const uint32_t allocated = evsys::getAllocated();
+
+  TEST_ASSERT_EQUAL(EVSYS_NO_CHANNEL, (evsys::setSamplingChain<7, 3, 1>()));
+  TEST_ASSERT_EQUAL_HEX32(allocated, evsys::getAllocated());
+  TEST_ASSERT_EQUAL(dma::LINK_ADC0_RESRDY, dma::ch::getPeripheral(7));
+  TEST_ASSERT_EQUAL_STRING("evsys sampling", dma::allocCtrl::getOwner(7));
+
+  TEST_ASSERT_FALSE(dma::allocCtrl::reserve(7));
+}
+
+// Each RESRDY trigger moves one result into the next sample slot.
+void test_sampling() {
+  TEST_ASSERT_NOT_EQUAL(EVSYS_NO_CHANNEL, (evsys::setSamplingChain<8, 2>()));
+  dma::taskDescriptor task;
+  task.setSource(&ADC0->RESULT.reg);
+  task.setDestination(&samples);
+  task.setLength(4);
+  task.setEnabled(true);
+  dma::ch::addTask(0, task, 8);
+  dma::ch::setState(dma::STATE_IDLE, 8);
+
+  for (int i = 0; i < 4; i++) {
+    ADC0->RESULT.reg = 100 + i;
+    sim::trigger(8);
+  }
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL_UINT16(100 + i, samples[i]);
+  }
+  TEST_ASSERT_EQUAL(dma::STATE_DISABLED, dma::ch::getState(8));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_chain_routing);
+  RUN_TEST(test_reserved_channel);
+  RUN_TEST(test_sampling);
+  return UNITY_END();
+}
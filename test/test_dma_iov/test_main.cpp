@@ -0,0 +1,77 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// gather/scatter span chains on the host model.
+
+using namespace samc::dma;
+
+static uint8_t head[6];
+static uint8_t body[20];
+static uint8_t tail[3];
+static volatile uint8_t port;
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  memset(head, 0, sizeof(head));
+  memset(body, 0, sizeof(body));
+  memset(tail, 0, sizeof(tail));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// Software triggered, every span moves on the one start, whatever trigger
+// action the channel was left with.
+void test_gather_all_spans() {
+  ch::setTransferMode(MODE_TRANSFER_TASK, 4);
+  for (int i = 0; i < 6; i++) head[i] = i;
+  for (int i = 0; i < 20; i++) body[i] = 10 + i;
+  for (int i = 0; i < 3; i++) tail[i] = 40 + i;
+
+  TEST_ASSERT_TRUE(gather(&port, { head, body, tail }, 4));
+  TEST_ASSERT_EQUAL_UINT32(29, sim::channel(4).beats);
+  TEST_ASSERT_EQUAL_UINT32(3, sim::channel(4).blocks);
+  TEST_ASSERT_EQUAL_HEX8(42, port);
+  TEST_ASSERT_EQUAL(STATE_DISABLED, ch::getState(4));
+}
+
+void test_scatter_peripheral() {
+  ch::setPeripheral(LINK_TC0_OOB, 5);
+  ch::setTransferMode(MODE_TRANSFER_1VALUE, 5);
+  TEST_ASSERT_TRUE(scatter(&port, { head, tail }, 5));
+  TEST_ASSERT_EQUAL(STATE_IDLE, ch::getState(5));
+
+  for (int i = 0; i < 9; i++) {
+    port = 0x80 + i;
+    sim::trigger(5);
+  }
+  TEST_ASSERT_EQUAL_HEX8(0x80, head[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x85, head[5]);
+  TEST_ASSERT_EQUAL_HEX8(0x88, tail[2]);
+  TEST_ASSERT_EQUAL(STATE_DISABLED, ch::getState(5));
+}
+
+// Span chains come from the pool and go back to it with clearTasks.
+void test_pool_return() {
+  for (int i = 0; i < DMA_DESC_POOL_SIZE; i++) {
+    TEST_ASSERT_TRUE(gather(&port, { head, body, tail }, 6));
+    ch::clearTasks(6);
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_gather_all_spans);
+  RUN_TEST(test_scatter_peripheral);
+  RUN_TEST(test_pool_return);
+  return UNITY_END();
+}
@@ -0,0 +1,174 @@
+#include <unity.h>
+#include <stdio.h>
+#include <dma_core.h>
+
+// Interrupt dispatch on the DMAC model: dedicated vectors for channels 0 - 3,
+// one drained entry of DMAC_4 for the rest, and the cost (in model cycles)
+// from interrupts being unmasked to each channel's callback.
+
+using namespace samc::dma;
+
+static uint32_t src[4];
+static uint32_t dst[DMAC_CH_NUM][4];
+
+static int transfers[DMAC_CH_NUM];
+static int globalTransfers;
+static void *contexts[DMAC_CH_NUM];
+static uint32_t stamps[DMAC_CH_NUM];
+
+static void onTransfer(int index, void *context) {
+  transfers[index]++;
+  contexts[index] = context;
+  stamps[index] = DWT->CYCCNT;
+}
+
+static void onGlobalTransfer(int index) {
+  globalTransfers++;
+}
+
+static void onGlobalError(int index, CHANNEL_ERROR error) {}
+
+static void start(taskDescriptor &task, const int &index) {
+  task.setSource(&src);
+  task.setDestination(&dst[index]);
+  task.setLength(4);
+  task.setEnabled(true);
+  ((DmacDescriptor*)task)->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+  ch::addTask(0, task, index);
+  ch::setTransferMode(MODE_TRANSFER_ALL, index);
+  ch::setState(STATE_ACTIVE, index);
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  memset(transfers, 0, sizeof(transfers));
+  memset(contexts, 0, sizeof(contexts));
+  memset(stamps, 0, sizeof(stamps));
+  globalTransfers = 0;
+  for (int i = 0; i < 4; i++) {
+    src[i] = 0xC0DE0000 + i;
+  }
+}
+
+void tearDown(void) {
+  __enable_irq();
+  sys::setTransferCallback(nullptr);
+  sys::setErrorCallback(nullptr);
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setTransferCallback(nullptr, nullptr, i);
+    ch::setErrorCallback(nullptr, nullptr, i);
+    ch::setInit(false, i);
+  }
+}
+
+// Eight channels complete while masked, a single DMAC_4 entry services all.
+void test_shared_drain() {
+  taskDescriptor tasks[8];
+  __disable_irq();
+  for (int i = 0; i < 8; i++) {
+    ch::setTransferCallback(onTransfer, &tasks[i], 8 + i);
+    start(tasks[i], 8 + i);
+  }
+  TEST_ASSERT_EQUAL_HEX32(0xFF00, DMAC->INTSTATUS.reg);
+
+  const uint32_t before = sim::model().interrupts;
+  __enable_irq();
+  TEST_ASSERT_EQUAL_UINT32(1, sim::model().interrupts - before);
+  for (int i = 0; i < 8; i++) {
+    TEST_ASSERT_EQUAL(1, transfers[8 + i]);
+    TEST_ASSERT_EQUAL_PTR(&tasks[i], contexts[8 + i]);
+  }
+  TEST_ASSERT_EQUAL_HEX32(0, DMAC->INTSTATUS.reg);
+}
+
+// Channels 0 - 3 come in on their own lines, one entry each.
+void test_dedicated_vectors() {
+  taskDescriptor tasks[5];
+  const int channels[5] = { 0, 1, 2, 3, 17 };
+  __disable_irq();
+  for (int i = 0; i < 5; i++) {
+    ch::setTransferCallback(onTransfer, nullptr, channels[i]);
+    start(tasks[i], channels[i]);
+  }
+  const uint32_t before = sim::model().interrupts;
+  __enable_irq();
+  TEST_ASSERT_EQUAL_UINT32(5, sim::model().interrupts - before);
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL(1, transfers[channels[i]]);
+  }
+}
+
+// A channel's own callback replaces the global one, others still get it.
+void test_callback_precedence() {
+  taskDescriptor a, b;
+  sys::setTransferCallback(onGlobalTransfer);
+  ch::setTransferCallback(onTransfer, nullptr, 5);
+  start(a, 5);
+  start(b, 6);
+  TEST_ASSERT_EQUAL(1, transfers[5]);
+  TEST_ASSERT_EQUAL(0, transfers[6]);
+  TEST_ASSERT_EQUAL(1, globalTransfers);
+}
+
+// Dropping the global error callback must leave TCMPL enabled, and a
+// pending TCMPL set, on channels that still want them.
+void test_global_clear_keeps_tcmpl() {
+  taskDescriptor a, b;
+  ch::setTransferCallback(onTransfer, nullptr, 7);
+  sys::setErrorCallback(onGlobalError);
+  sys::setErrorCallback(nullptr);
+  TEST_ASSERT_TRUE(DMAC->Channel[7].CHINTENSET.bit.TCMPL);
+
+  start(a, 7);
+  TEST_ASSERT_EQUAL(1, transfers[7]);
+
+  __disable_irq();
+  start(b, 7);
+  sys::setTransferCallback(onGlobalTransfer);
+  sys::setTransferCallback(nullptr);
+  sys::setErrorCallback(onGlobalError);
+  sys::setErrorCallback(nullptr);
+  TEST_ASSERT_TRUE(sim::flags(7) & DMAC_CHINTFLAG_TCMPL);
+  __enable_irq();
+  TEST_ASSERT_EQUAL(2, transfers[7]);
+}
+
+// Unmask-to-callback cost: a dedicated channel against the last channel
+// drained by the shared handler. Model cycles only, see dmac_model.h.
+void test_dispatch_latency() {
+  taskDescriptor tasks[9];
+  const int channels[9] = { 0, 4, 5, 6, 7, 8, 9, 10, 31 };
+  __disable_irq();
+  for (int i = 0; i < 9; i++) {
+    ch::setTransferCallback(onTransfer, nullptr, channels[i]);
+    start(tasks[i], channels[i]);
+  }
+  const uint32_t unmasked = DWT->CYCCNT;
+  __enable_irq();
+
+  const uint32_t dedicated = stamps[0] - unmasked;
+  const uint32_t first = stamps[4] - stamps[0];
+  const uint32_t last = stamps[31] - stamps[0];
+  char line[96];
+  snprintf(line, sizeof(line), "dedicated %lu, shared first %lu, shared 8th %lu",
+    (unsigned long)dedicated, (unsigned long)first, (unsigned long)last);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_TRUE(first < last);
+  TEST_ASSERT_TRUE(dedicated <= first);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_shared_drain);
+  RUN_TEST(test_dedicated_vectors);
+  RUN_TEST(test_callback_precedence);
+  RUN_TEST(test_global_clear_keeps_tcmpl);
+  RUN_TEST(test_dispatch_latency);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// Handler entry to callback latency on the host model, built with
+// DMA_IRQ_LATENCY_ENABLED (pio test -e native_switches): capture on the
+// dedicated and the shared vectors, the running maximum, and clearing.
+// The model takes interrupts with no exception entry cost, so the values
+// are the handler's own register traffic in model cycles.
+
+#if !DMA_IRQ_LATENCY_ENABLED
+  #error "test_dma_latency needs -D DMA_IRQ_LATENCY_ENABLED=true"
+#endif
+
+using namespace samc::dma;
+
+static uint8_t src[64] __ALIGNED(4);
+static uint8_t dst[2][64] __ALIGNED(4);
+static volatile uint32_t stamp[DMAC_CH_NUM];
+
+static void onTransfer(int index, void *context) {
+  stamp[index] = DWT->CYCCNT;
+}
+
+static void prepare(taskDescriptor &task, const int &index, uint8_t *to) {
+  task.setSource((const uint8_t(*)[64])&src);
+  task.setDestination((uint8_t(*)[64])to);
+  task.setLength(64);
+  task.setEnabled(true);
+  ((DmacDescriptor*)task)->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+  ch::clearTasks(index);
+  ch::addTask(0, task, index);
+  ch::setTransferMode(MODE_TRANSFER_ALL, index);
+  ch::setTransferCallback(onTransfer, nullptr, index);
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  sys::clearIrqLatency();
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::setTransferCallback(nullptr, nullptr, i);
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// A dedicated vector measures from its own entry, the value is non-zero and
+// inside the window from the start to the callback.
+void test_dedicated() {
+  taskDescriptor task;
+  prepare(task, 1, dst[0]);
+  const uint32_t start = DWT->CYCCNT;
+  TEST_ASSERT_TRUE(ch::setState(STATE_ACTIVE, 1));
+  const uint32_t latency = sys::getIrqLatency(1);
+  TEST_ASSERT_TRUE(latency > 0);
+  TEST_ASSERT_TRUE(latency < stamp[1] - start);
+  TEST_ASSERT_EQUAL_UINT32(latency, sys::getIrqLatencyMax(1));
+  TEST_ASSERT_EQUAL_UINT32(0, sys::getIrqLatency(2));
+  TEST_ASSERT_EQUAL_MEMORY(src, dst[0], 64);
+}
+
+// Two channels pending on the shared vector are served in one entry, so the
+// second one's latency includes the first one's service.
+void test_shared() {
+  taskDescriptor first, second;
+  prepare(first, 6, dst[0]);
+  prepare(second, 9, dst[1]);
+  __disable_irq();
+  ch::setState(STATE_ACTIVE, 6);
+  ch::setState(STATE_ACTIVE, 9);
+  TEST_ASSERT_EQUAL_UINT32(0, sys::getIrqLatency(6));
+  __enable_irq();
+  TEST_ASSERT_TRUE(sys::getIrqLatency(6) > 0);
+  TEST_ASSERT_TRUE(sys::getIrqLatency(9) > sys::getIrqLatency(6));
+  TEST_ASSERT_EQUAL_MEMORY(src, dst[1], 64);
+}
+
+// The maximum holds the worst entry until cleared, last follows each one.
+void test_max_and_clear() {
+  taskDescriptor first, second;
+  prepare(first, 6, dst[0]);
+  prepare(second, 9, dst[1]);
+  __disable_irq();
+  ch::setState(STATE_ACTIVE, 6);
+  ch::setState(STATE_ACTIVE, 9);
+  __enable_irq();
+  const uint32_t worst = sys::getIrqLatency(9);
+
+  prepare(second, 9, dst[1]);
+  ch::setState(STATE_ACTIVE, 9);
+  TEST_ASSERT_TRUE(sys::getIrqLatency(9) < worst);
+  TEST_ASSERT_EQUAL_UINT32(worst, sys::getIrqLatencyMax(9));
+
+  sys::clearIrqLatency();
+  TEST_ASSERT_EQUAL_UINT32(0, sys::getIrqLatency(9));
+  TEST_ASSERT_EQUAL_UINT32(0, sys::getIrqLatencyMax(9));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_dedicated);
+  RUN_TEST(test_shared);
+  RUN_TEST(test_max_and_clear);
+  return UNITY_END();
+}
@@ -0,0 +1,205 @@
+#include <unity.h>
+#include <port_core.h>
+
+// port::logicCapture on the host model: one IN sample per timer overflow
+// trigger, the trigger edge with its pre- and post-trigger window, a ring
+// that wraps before the trigger, a window lapped by a late poll, the run
+// length view and the pin settings put back on stop. The only pin the board
+// map defines is PB01, so the group is a single pin.
+
+using namespace samc;
+
+static uint8_t ring[8];
+
+static void sample(const int &index, const uint32_t &state) {
+  const_cast<uint32_t&>(PORT->Group[1].IN.reg) = state << 1;
+  sim::trigger(index);
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    dma::configGroup::prilvl_enabled[i] = true;
+  }
+  dma::sys::setInit(true);
+  dma::sys::setEnabled(true);
+  memset((void*)PORT, 0, sizeof(Port));
+  memset((void*)TC1, 0, sizeof(Tc));
+  memset(ring, 0, sizeof(ring));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    dma::allocCtrl::release(i);
+    dma::ch::setInit(false, i);
+  }
+}
+
+// The window opens preTrigger samples before the rising edge and closes
+// postTrigger samples after it, stopping the channel on the poll that sees it.
+void test_trigger_window() {
+  static const uint32_t input[] = { 0, 0, 1, 0, 0, 1, 1, 0, 1, 1 };
+  port::logicCapture capture;
+  TEST_ASSERT_TRUE(capture.setPins({ 0 }));
+  TEST_ASSERT_TRUE(capture.setTrigger(1, 1, 3, 4));
+  TEST_ASSERT_TRUE(capture.setBuffer(ring, 8));
+  TEST_ASSERT_TRUE(capture.start(1, 50));
+  const int index = capture.getChannel();
+  TEST_ASSERT_EQUAL_STRING("capture", dma::allocCtrl::getOwner(index));
+  TEST_ASSERT_EQUAL(dma::LINK_TC1_OOB, dma::ch::getPeripheral(index));
+
+  // The edge at sample 2 has too little history, the one at 5 triggers.
+  int i = 0;
+  for (; i < 5; i++) {
+    sample(index, input[i]);
+    TEST_ASSERT_FALSE(capture.poll());
+  }
+  TEST_ASSERT_FALSE(capture.getTriggered());
+  for (; i < 8; i++) {
+    sample(index, input[i]);
+    TEST_ASSERT_FALSE(capture.poll());
+  }
+  TEST_ASSERT_TRUE(capture.getTriggered());
+  TEST_ASSERT_EQUAL(0, capture.getLength());
+  sample(index, input[i++]);
+  TEST_ASSERT_TRUE(capture.poll());
+  TEST_ASSERT_TRUE(capture.getDone());
+  TEST_ASSERT_FALSE(capture.getOverrun());
+  TEST_ASSERT_EQUAL(-1, capture.getChannel());
+  TEST_ASSERT_NULL(dma::allocCtrl::getOwner(index));
+
+  TEST_ASSERT_EQUAL(7, capture.getLength());
+  for (int k = 0; k < 7; k++) {
+    TEST_ASSERT_EQUAL_UINT32(input[2 + k], capture.getSample(k));
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, capture.getSample(7));
+
+  // The channel is stopped, a further overflow writes nothing.
+  uint8_t kept[8];
+  memcpy(kept, ring, sizeof(ring));
+  sample(index, 1);
+  TEST_ASSERT_EQUAL_MEMORY(kept, ring, sizeof(ring));
+}
+
+// Three laps of idle input before the edge, polled often enough: the window
+// straddles the end of the ring and reads back in order.
+void test_ring_wrap() {
+  port::logicCapture capture;
+  capture.setPins({ 0 });
+  capture.setTrigger(1, 1, 2, 3);
+  capture.setBuffer(ring, 8);
+  TEST_ASSERT_TRUE(capture.start(1, 50));
+  const int index = capture.getChannel();
+  for (int i = 0; i < 22; i++) {
+    sample(index, 0);
+    capture.poll();
+  }
+  sample(index, 1);
+  sample(index, 0);
+  capture.poll();
+  TEST_ASSERT_TRUE(capture.getTriggered());
+  sample(index, 1);
+  TEST_ASSERT_TRUE(capture.poll());
+  TEST_ASSERT_FALSE(capture.getOverrun());
+
+  static const uint32_t window[] = { 0, 0, 1, 0, 1 };
+  TEST_ASSERT_EQUAL(5, capture.getLength());
+  for (int k = 0; k < 5; k++) {
+    TEST_ASSERT_EQUAL_UINT32(window[k], capture.getSample(k));
+  }
+}
+
+// A poll that comes after the ring has lapped the start of the window marks
+// the capture overrun.
+void test_late_poll() {
+  port::logicCapture capture;
+  capture.setPins({ 0 });
+  capture.setTrigger(1, 1, 2, 2);
+  capture.setBuffer(ring, 8);
+  capture.start(1, 50);
+  const int index = capture.getChannel();
+  sample(index, 0);
+  sample(index, 0);
+  sample(index, 1);
+  TEST_ASSERT_FALSE(capture.poll());
+  for (int i = 0; i < 6; i++) {
+    sample(index, i & 1);
+  }
+  TEST_ASSERT_TRUE(capture.poll());
+  TEST_ASSERT_TRUE(capture.getOverrun());
+}
+
+// A zero mask triggers as soon as the history is there; runs fold equal
+// neighbours and report -1 when they do not fit.
+void test_runs() {
+  static const uint32_t input[] = { 1, 1, 0, 0, 0, 1, 0, 0 };
+  port::logicCapture capture;
+  capture.setPins({ 0 });
+  TEST_ASSERT_TRUE(capture.setTrigger(0, 0, 2, 6));
+  capture.setBuffer(ring, 8);
+  capture.start(1, 50);
+  const int index = capture.getChannel();
+  for (int i = 0; i < 8; i++) {
+    sample(index, input[i]);
+    capture.poll();
+  }
+  TEST_ASSERT_TRUE(capture.getDone());
+
+  port::captureRun runs[4];
+  TEST_ASSERT_EQUAL(4, capture.getRuns(runs, 4));
+  TEST_ASSERT_EQUAL_UINT32(1, runs[0].state);
+  TEST_ASSERT_EQUAL_UINT32(2, runs[0].count);
+  TEST_ASSERT_EQUAL_UINT32(0, runs[1].state);
+  TEST_ASSERT_EQUAL_UINT32(3, runs[1].count);
+  TEST_ASSERT_EQUAL_UINT32(1, runs[2].state);
+  TEST_ASSERT_EQUAL_UINT32(1, runs[2].count);
+  TEST_ASSERT_EQUAL_UINT32(2, runs[3].count);
+  TEST_ASSERT_EQUAL(-1, capture.getRuns(runs, 3));
+  TEST_ASSERT_EQUAL(0, capture.getRuns(nullptr, 4));
+}
+
+// start() makes the pins sampled inputs, stop() puts direction, input
+// enable and continuous sampling back.
+void test_restores_pins() {
+  PortGroup &port = PORT->Group[1];
+  port.DIR.reg = 0x2;
+  port.CTRL.reg = 0x80;
+  port.PINCFG[1].bit.PULLEN = 1;
+  port::logicCapture capture;
+  capture.setPins({ 0 });
+  capture.setTrigger(1, 1, 0, 1);
+  capture.setBuffer(ring, 8);
+  TEST_ASSERT_TRUE(capture.start(1, 50));
+  TEST_ASSERT_EQUAL_HEX32(0x2, port.DIRCLR.reg);
+  TEST_ASSERT_EQUAL_HEX32(0x82, port.CTRL.reg);
+  TEST_ASSERT_TRUE(port.PINCFG[1].bit.INEN);
+
+  TEST_ASSERT_TRUE(capture.stop());
+  TEST_ASSERT_EQUAL_HEX32(0x80, port.CTRL.reg);
+  TEST_ASSERT_FALSE(port.PINCFG[1].bit.INEN);
+  TEST_ASSERT_TRUE(port.PINCFG[1].bit.PULLEN);
+  TEST_ASSERT_EQUAL_HEX32(0x2, port.DIRSET.reg);
+  TEST_ASSERT_FALSE(capture.stop());
+
+  // Through the trigger path as well, with sampling already on.
+  port.CTRL.reg = 0x2;
+  port.PINCFG[1].bit.INEN = 1;
+  port.DIR.reg = 0;
+  port.DIRSET.reg = 0;
+  capture.start(1, 50);
+  sample(capture.getChannel(), 1);
+  TEST_ASSERT_TRUE(capture.poll());
+  TEST_ASSERT_EQUAL_HEX32(0x2, port.CTRL.reg);
+  TEST_ASSERT_TRUE(port.PINCFG[1].bit.INEN);
+  TEST_ASSERT_EQUAL_HEX32(0, port.DIRSET.reg);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_trigger_window);
+  RUN_TEST(test_ring_wrap);
+  RUN_TEST(test_late_poll);
+  RUN_TEST(test_runs);
+  RUN_TEST(test_restores_pins);
+  return UNITY_END();
+}
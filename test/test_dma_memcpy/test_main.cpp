@@ -0,0 +1,144 @@
+#include <unity.h>
+#include <stdio.h>
+#include <dma_core.h>
+
+// memcpy_async and memset_async on the host model across sizes and
+// alignments: the copy itself, the beat width picked for each alignment
+// pair, the size past which a copy falls back to the CPU, and a table of
+// DMA beats and model cycles per size and alignment. Model cycles are fixed
+// per-beat, per-burst and per-fetch costs, so the table compares alignments
+// and sizes with each other; timing the CPU memcpy it replaces needs the
+// bench.
+
+using namespace samc::dma;
+
+#define MEM_BYTES 8192
+#define MEM_GUARD 8
+#define MEM_SPLIT_WORDS (DMA_MEMCPY_TASKS * 0xFFFF * 4)
+
+static uint8_t from[MEM_BYTES + MEM_GUARD] __ALIGNED(4);
+static uint8_t to[MEM_BYTES + MEM_GUARD] __ALIGNED(4);
+static uint8_t expect[MEM_BYTES + MEM_GUARD] __ALIGNED(4);
+static uint8_t bigFrom[MEM_SPLIT_WORDS + MEM_GUARD] __ALIGNED(4);
+static uint8_t bigTo[MEM_SPLIT_WORDS + MEM_GUARD] __ALIGNED(4);
+
+static uint32_t totalBeats() {
+  uint32_t beats = 0;
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    beats += sim::channel(i).beats;
+  }
+  return beats;
+}
+
+void setUp(void) {
+  for (int i = 0; i < MEM_BYTES + MEM_GUARD; i++) {
+    from[i] = i * 7 + 3;
+  }
+  memset(to, 0xA5, sizeof(to));
+  memset(expect, 0xA5, sizeof(expect));
+}
+
+void tearDown(void) {}
+
+// Equal offsets get a byte head and tail around a word body, unequal ones
+// drop to the widest beat both sides allow.
+void test_copy_alignments() {
+  static const int offsets[][2] = { {0, 0}, {1, 1}, {3, 3}, {2, 0}, {1, 0}, {0, 3} };
+  static const uint32_t beats[] = { 256, 259, 259, 512, 1024, 1024 };
+  for (int k = 0; k < 6; k++) {
+    memset(to, 0xA5, sizeof(to));
+    memset(expect, 0xA5, sizeof(expect));
+    const uint8_t *src = from + offsets[k][0];
+    uint8_t *dst = to + offsets[k][1];
+    memcpy(expect + offsets[k][1], src, 1024);
+
+    const uint32_t before = totalBeats();
+    transferToken token = memcpy_async(dst, src, 1024);
+    TEST_ASSERT_NOT_EQUAL(-1, token.getChannel());
+    TEST_ASSERT_TRUE(token.wait());
+    TEST_ASSERT_EQUAL_UINT32(beats[k], totalBeats() - before);
+    TEST_ASSERT_EQUAL_MEMORY(expect, to, sizeof(to));
+  }
+}
+
+// Below DMA_MEMCPY_MIN_BYTES the copy is done on the CPU and the token
+// comes back complete.
+void test_short_copy() {
+  const uint32_t before = totalBeats();
+  transferToken token = memcpy_async(to + 1, from, DMA_MEMCPY_MIN_BYTES - 1);
+  TEST_ASSERT_TRUE(token.getDone());
+  TEST_ASSERT_EQUAL(-1, token.getChannel());
+  TEST_ASSERT_EQUAL_UINT32(0, totalBeats() - before);
+  TEST_ASSERT_EQUAL_MEMORY(from, to + 1, DMA_MEMCPY_MIN_BYTES - 1);
+}
+
+// A copy split into more than DMA_MEMCPY_TASKS blocks runs on the CPU: one
+// beat past the last size that fits, for word beats with no head or tail
+// and for byte beats.
+void test_split_limit() {
+  static const int sizes[] = { MEM_SPLIT_WORDS, DMA_MEMCPY_TASKS * 0xFFFF };
+  static const int offsets[] = { 0, 1 };
+  static const int beats[] = { 4, 1 };
+  for (int i = 0; i < MEM_SPLIT_WORDS + MEM_GUARD; i++) {
+    bigFrom[i] = i * 13 + 1;
+  }
+  for (int k = 0; k < 2; k++) {
+    for (int extra = 0; extra < 2; extra++) {
+      const size_t bytes = sizes[k] + extra * beats[k];
+      memset(bigTo, 0, sizeof(bigTo));
+      transferToken token = memcpy_async(bigTo, bigFrom + offsets[k], bytes);
+      TEST_ASSERT_EQUAL(extra != 0, token.getChannel() == -1);
+      TEST_ASSERT_TRUE(token.wait());
+      TEST_ASSERT_EQUAL_MEMORY(bigFrom + offsets[k], bigTo, bytes);
+      TEST_ASSERT_EQUAL_UINT8(0, bigTo[bytes]);
+    }
+  }
+}
+
+void test_fill() {
+  transferToken token = memset_async(to + 1, 0x3C, 1000);
+  TEST_ASSERT_TRUE(token.wait());
+  memset(expect + 1, 0x3C, 1000);
+  TEST_ASSERT_EQUAL_MEMORY(expect, to, sizeof(to));
+}
+
+void test_cost_table() {
+  static const int sizes[] = { 64, 256, 1024, 4096, 8192 };
+  static const int offsets[][2] = { {0, 0}, {1, 1}, {2, 0}, {1, 0} };
+  char line[96];
+  TEST_MESSAGE("bytes src dst  beats  model cycles  cycles/byte");
+  for (int s = 0; s < 5; s++) {
+    for (int k = 0; k < 4; k++) {
+      const uint32_t beats = totalBeats();
+      const uint32_t cycles = sim::cycles();
+      transferToken token = memcpy_async(to + offsets[k][1],
+        from + offsets[k][0], sizes[s]);
+      TEST_ASSERT_TRUE(token.wait());
+      const uint32_t spent = sim::cycles() - cycles;
+      snprintf(line, sizeof(line), "%5d %3d %3d %6lu %13lu %12.2f", sizes[s],
+        offsets[k][0], offsets[k][1], (unsigned long)(totalBeats() - beats),
+        (unsigned long)spent, (double)spent / sizes[s]);
+      TEST_MESSAGE(line);
+      TEST_ASSERT_EQUAL_MEMORY(from + offsets[k][0], to + offsets[k][1],
+        sizes[s]);
+    }
+  }
+}
+
+// The memory channels are claimed once and kept, so the model and the DMAC
+// are set up once for the whole run rather than per test.
+int main(int argc, char **argv) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_copy_alignments);
+  RUN_TEST(test_short_copy);
+  RUN_TEST(test_split_limit);
+  RUN_TEST(test_fill);
+  RUN_TEST(test_cost_table);
+  return UNITY_END();
+}
@@ -0,0 +1,121 @@
+#include <unity.h>
+#include <port_core.h>
+
+// port::patternGen on the host model: states turned into OUTTGL beats, one
+// beat per timer overflow trigger, the pins parked on the last state before
+// playback, looped and one-shot runs, and the channel handed back on stop.
+// The only pin the board map defines is PB01, so the group is a single pin.
+
+using namespace samc;
+
+static uint8_t beats[8];
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    dma::configGroup::prilvl_enabled[i] = true;
+  }
+  dma::sys::setInit(true);
+  dma::sys::setEnabled(true);
+  memset((void*)PORT, 0, sizeof(Port));
+  memset((void*)TC2, 0, sizeof(Tc));
+  memset(beats, 0, sizeof(beats));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    dma::allocCtrl::release(i);
+    dma::ch::setInit(false, i);
+  }
+}
+
+// Each beat toggles against the previous state, the first against the last,
+// and the pins start on the last state.
+void test_pattern_toggles() {
+  static const uint32_t states[] = { 1, 0, 0, 1, 1 };
+  port::patternGen gen;
+  TEST_ASSERT_TRUE(gen.setPins({ 0 }));
+  TEST_ASSERT_EQUAL(1, gen.getBeatSize());
+  TEST_ASSERT_TRUE(gen.setPattern(states, beats, 5));
+  TEST_ASSERT_EQUAL_HEX8(0x00, beats[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, beats[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x00, beats[2]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, beats[3]);
+  TEST_ASSERT_EQUAL_HEX8(0x00, beats[4]);
+
+  TEST_ASSERT_TRUE(gen.start(2, 100, false));
+  const int index = gen.getChannel();
+  TEST_ASSERT_EQUAL_STRING("pattern", dma::allocCtrl::getOwner(index));
+  TEST_ASSERT_EQUAL(dma::LINK_TC2_OOB, dma::ch::getPeripheral(index));
+  TEST_ASSERT_EQUAL(dma::MODE_TRANSFER_1VALUE, dma::ch::getTransferMode(index));
+  TEST_ASSERT_EQUAL(dma::STATE_IDLE, dma::ch::getState(index));
+  TEST_ASSERT_EQUAL_HEX32(0x2, PORT->Group[1].OUTSET.reg);
+  TEST_ASSERT_EQUAL_HEX32(0x2, PORT->Group[1].DIRSET.reg);
+  TEST_ASSERT_EQUAL(99, TC2->COUNT16.CC[0].reg);
+  TEST_ASSERT_TRUE(TC2->COUNT16.CTRLA.bit.ENABLE);
+
+  for (int i = 0; i < 5; i++) {
+    PORT->Group[1].OUTTGL.reg = 0xFF;
+    TEST_ASSERT_FALSE(gen.getDone());
+    sim::trigger(index);
+    TEST_ASSERT_EQUAL_HEX32(beats[i], PORT->Group[1].OUTTGL.reg);
+  }
+  TEST_ASSERT_TRUE(gen.getDone());
+  TEST_ASSERT_EQUAL_UINT32(5, sim::channel(index).beats);
+
+  TEST_ASSERT_TRUE(gen.stop());
+  TEST_ASSERT_NULL(dma::allocCtrl::getOwner(index));
+  TEST_ASSERT_FALSE(TC2->COUNT16.CTRLA.bit.ENABLE);
+  TEST_ASSERT_EQUAL(-1, gen.getChannel());
+  TEST_ASSERT_FALSE(gen.stop());
+}
+
+// A looped pattern goes round until stopped and never reports done.
+void test_pattern_looped() {
+  static const uint32_t states[] = { 1, 0, 1 };
+  port::patternGen gen;
+  gen.setPins({ 0 });
+  gen.setPattern(states, beats, 3);
+  TEST_ASSERT_TRUE(gen.start(2, 10, true));
+  const int index = gen.getChannel();
+  for (int i = 0; i < 7; i++) {
+    sim::trigger(index);
+    TEST_ASSERT_EQUAL_HEX32(beats[i % 3], PORT->Group[1].OUTTGL.reg);
+  }
+  TEST_ASSERT_FALSE(gen.getDone());
+  TEST_ASSERT_NOT_EQUAL(dma::STATE_DISABLED, dma::ch::getState(index));
+  TEST_ASSERT_TRUE(gen.stop());
+  TEST_ASSERT_TRUE(gen.getDone());
+}
+
+void test_pattern_rejects() {
+  static const uint32_t states[] = { 1, 0 };
+  port::patternGen gen, other;
+  TEST_ASSERT_FALSE(gen.setPattern(states, beats, 2));
+  TEST_ASSERT_FALSE(gen.setPins({ 1 }));
+  TEST_ASSERT_FALSE(gen.setPins({ 0, 0 }));
+  gen.setPins({ 0 });
+  TEST_ASSERT_FALSE(gen.start(2, 10, false));
+  TEST_ASSERT_FALSE(gen.setPattern(states, beats, 0));
+  gen.setPattern(states, beats, 2);
+  TEST_ASSERT_FALSE(gen.start(TC_INST_NUM, 10, false));
+  TEST_ASSERT_FALSE(gen.start(2, 0, false));
+  TEST_ASSERT_EQUAL(0, dma::allocCtrl::getAllocated());
+
+  TEST_ASSERT_TRUE(gen.start(2, 10, false));
+  TEST_ASSERT_FALSE(gen.start(2, 10, false));
+  TEST_ASSERT_FALSE(gen.setPattern(states, beats, 2));
+  TEST_ASSERT_FALSE(gen.setPins({ 0 }));
+  other.setPins({ 0 });
+  other.setPattern(states, beats, 2);
+  TEST_ASSERT_TRUE(other.start(3, 10, false));
+  TEST_ASSERT_NOT_EQUAL(gen.getChannel(), other.getChannel());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_pattern_toggles);
+  RUN_TEST(test_pattern_looped);
+  RUN_TEST(test_pattern_rejects);
+  return UNITY_END();
+}
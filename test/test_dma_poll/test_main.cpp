@@ -0,0 +1,160 @@
+#include <unity.h>
+#include <stdio.h>
+#include <dma_core.h>
+
+// Polled completion on the host model: short transfers finish without an
+// interrupt and are picked up by wait(), long ones fall back to the ISR,
+// plus timeout and error returns and a round-trip comparison of the two
+// modes. The model dispatches interrupts with no exception entry or exit
+// cost, so the irq column understates a part and the table only orders the
+// two modes; it does not place the crossover.
+
+using namespace samc::dma;
+
+static uint8_t src[256] __ALIGNED(4);
+static uint8_t dst[256] __ALIGNED(4);
+static volatile uint8_t port;
+static volatile uint32_t stamp;
+static volatile int transfers;
+
+static void onTransfer(int index, void *context) {
+  stamp = DWT->CYCCNT;
+  transfers++;
+}
+
+static void prepare(taskDescriptor &task, const int &bytes, const int &index) {
+  task.setSource((const uint8_t(*)[256])&src);
+  task.setDestination((uint8_t(*)[256])&dst);
+  task.setLength(bytes);
+  task.setEnabled(true);
+  ((DmacDescriptor*)task)->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+  ch::clearTasks(index);
+  ch::addTask(0, task, index);
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  for (int i = 0; i < 256; i++) {
+    src[i] = i;
+  }
+  memset(dst, 0, sizeof(dst));
+  transfers = 0;
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::setPolled(false, DMA_POLL_THRESHOLD, i);
+    ch::setTransferCallback(nullptr, nullptr, i);
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+void test_polled_short() {
+  channelCtrl<2> channel;
+  taskDescriptor task;
+  prepare(task, 16, 2);
+  channel.setTransferMode(MODE_TRANSFER_ALL);
+  ch::setTransferCallback(onTransfer, nullptr, 2);
+  TEST_ASSERT_TRUE(channel.setPolled(true));
+
+  const uint32_t interrupts = sim::model().interrupts;
+  TEST_ASSERT_TRUE(channel.setState(STATE_ACTIVE));
+  TEST_ASSERT_TRUE(channel.wait(1000));
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, 16);
+  TEST_ASSERT_EQUAL_UINT32(interrupts, sim::model().interrupts);
+  TEST_ASSERT_EQUAL(0, transfers);
+  TEST_ASSERT_FALSE(DMAC->Channel[2].CHINTENSET.bit.TCMPL);
+}
+
+// Above the threshold the transfer interrupts as usual and wait() returns
+// once the ISR has marked it done.
+void test_long_fallback() {
+  channelCtrl<2> channel;
+  taskDescriptor task;
+  prepare(task, 256, 2);
+  channel.setTransferMode(MODE_TRANSFER_ALL);
+  ch::setTransferCallback(onTransfer, nullptr, 2);
+  TEST_ASSERT_TRUE(channel.setPolled(true, 64));
+
+  const uint32_t interrupts = sim::model().interrupts;
+  TEST_ASSERT_TRUE(channel.setState(STATE_ACTIVE));
+  TEST_ASSERT_TRUE(channel.wait(1000));
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, 256);
+  TEST_ASSERT_TRUE(sim::model().interrupts > interrupts);
+  TEST_ASSERT_EQUAL(1, transfers);
+}
+
+void test_timeout_and_error() {
+  channelCtrl<5> channel;
+  taskDescriptor task;
+  TEST_ASSERT_FALSE(channel.wait(100));
+
+  task.setSource(&port);
+  task.setDestination((uint8_t(*)[256])&dst);
+  task.setLength(4);
+  task.setEnabled(true);
+  ((DmacDescriptor*)task)->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+  ch::addTask(0, task, 5);
+  channel.setPeripheral(LINK_TC0_OOB);
+  channel.setTransferMode(MODE_TRANSFER_1VALUE);
+  channel.setPolled(true);
+  TEST_ASSERT_TRUE(channel.setState(STATE_IDLE));
+  TEST_ASSERT_FALSE(channel.wait(500));
+  sim::trigger(5, 4);
+  TEST_ASSERT_TRUE(channel.wait(500));
+
+  prepare(task, 16, 5);
+  channel.setPeripheral(LINK_NONE);
+  channel.setTransferMode(MODE_TRANSFER_ALL);
+  sim::failAfter(5, 3);
+  channel.setState(STATE_ACTIVE);
+  TEST_ASSERT_FALSE(channel.wait(500));
+}
+
+// Start to completion seen by the caller: wait() returning in polled mode,
+// the transfer callback running in IRQ mode.
+void test_round_trip() {
+  static const int sizes[] = { 4, 8, 16, 32 };
+  channelCtrl<3> channel;
+  taskDescriptor task;
+  char line[96];
+  channel.setTransferMode(MODE_TRANSFER_ALL);
+  ch::setTransferCallback(onTransfer, nullptr, 3);
+  TEST_MESSAGE("bytes  polled  irq  (model cycles)");
+  for (int s = 0; s < 4; s++) {
+    prepare(task, sizes[s], 3);
+    channel.setPolled(true);
+    uint32_t start = DWT->CYCCNT;
+    channel.setState(STATE_ACTIVE);
+    TEST_ASSERT_TRUE(channel.wait(1000));
+    const uint32_t polled = DWT->CYCCNT - start;
+
+    prepare(task, sizes[s], 3);
+    channel.setPolled(false);
+    const int before = transfers;
+    start = DWT->CYCCNT;
+    channel.setState(STATE_ACTIVE);
+    TEST_ASSERT_EQUAL(before + 1, transfers);
+    const uint32_t irq = stamp - start;
+
+    snprintf(line, sizeof(line), "%5d %7lu %4lu", sizes[s],
+      (unsigned long)polled, (unsigned long)irq);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_MEMORY(src, dst, sizes[s]);
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_polled_short);
+  RUN_TEST(test_long_fallback);
+  RUN_TEST(test_timeout_and_error);
+  RUN_TEST(test_round_trip);
+  return UNITY_END();
+}
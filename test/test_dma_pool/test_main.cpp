@@ -0,0 +1,143 @@
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include <dma_core.h>
+
+// The descriptor pool behind taskDescriptor: alignment, exhaustion and
+// reuse, plus a host benchmark of the pool path against the heap path it
+// replaced. Timings are host nanoseconds and are reported, not asserted;
+// they compare the two paths on one machine and say nothing about the M4.
+
+using namespace samc::dma;
+
+#define BENCH_ROUNDS 20000
+
+static uint32_t src[8];
+static uint32_t dst[8];
+
+typedef std::chrono::steady_clock benchClock;
+
+static uint32_t elapsedNs(const benchClock::time_point &start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    benchClock::now() - start).count();
+}
+
+static void report(const char *name, const uint32_t &total,
+  const uint32_t &worst) {
+  char line[96];
+  snprintf(line, sizeof(line), "%-22s mean %4lu ns, worst %6lu ns", name,
+    (unsigned long)(total / BENCH_ROUNDS), (unsigned long)worst);
+  TEST_MESSAGE(line);
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// Every descriptor is 16-byte aligned; once the pool is drained (static
+// tasks elsewhere hold part of it) a task has no descriptor, and one
+// released is handed out again.
+void test_exhaustion() {
+  static taskDescriptor *tasks[DMA_DESC_POOL_SIZE + 1];
+  int count = 0;
+  bool aligned = true;
+  for (; count <= DMA_DESC_POOL_SIZE; count++) {
+    tasks[count] = new taskDescriptor();
+    DmacDescriptor *desc = (DmacDescriptor*)*tasks[count];
+    if (!desc) break;
+    aligned = aligned && !((uintptr_t)desc & 15);
+  }
+  const bool drained = count > 8 && count < DMA_DESC_POOL_SIZE;
+
+  DmacDescriptor *freed = (DmacDescriptor*)*tasks[7];
+  delete tasks[7];
+  tasks[7] = new taskDescriptor();
+  const bool reused = (DmacDescriptor*)*tasks[7] == freed;
+  for (int i = 0; i <= count && i <= DMA_DESC_POOL_SIZE; i++) {
+    delete tasks[i];
+  }
+  TEST_ASSERT_TRUE(aligned);
+  TEST_ASSERT_TRUE(drained);
+  TEST_ASSERT_TRUE(reused);
+}
+
+// Acquire/release through taskDescriptor against new/delete of a bare
+// descriptor, then link/unlink through addTask/clearTasks against the heap
+// copy the old clearTasks made of the base.
+void test_pool_vs_heap() {
+  uint32_t total = 0, worst = 0;
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    const benchClock::time_point start = benchClock::now();
+    {
+      taskDescriptor task;
+      task.setLength(1);
+    }
+    const uint32_t ns = elapsedNs(start);
+    total += ns;
+    if (ns > worst) worst = ns;
+  }
+  report("pool acquire/release", total, worst);
+
+  total = 0;
+  worst = 0;
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    const benchClock::time_point start = benchClock::now();
+    DmacDescriptor *desc = new DmacDescriptor();
+    desc->BTCNT.reg = 1;
+    delete desc;
+    const uint32_t ns = elapsedNs(start);
+    total += ns;
+    if (ns > worst) worst = ns;
+  }
+  report("heap new/delete", total, worst);
+
+  taskDescriptor task;
+  task.setSource(&src);
+  task.setDestination(&dst);
+  task.setLength(8);
+  total = 0;
+  worst = 0;
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    const benchClock::time_point start = benchClock::now();
+    TEST_ASSERT_TRUE(ch::addTask(0, task, 3));
+    ch::clearTasks(3);
+    const uint32_t ns = elapsedNs(start);
+    total += ns;
+    if (ns > worst) worst = ns;
+  }
+  report("pool link/unlink", total, worst);
+
+  total = 0;
+  worst = 0;
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    const benchClock::time_point start = benchClock::now();
+    TEST_ASSERT_TRUE(ch::addTask(0, task, 3));
+    DmacDescriptor *copy = new DmacDescriptor();
+    memcpy(copy, (DmacDescriptor*)task, sizeof(DmacDescriptor));
+    ch::clearTasks(3);
+    delete copy;
+    const uint32_t ns = elapsedNs(start);
+    total += ns;
+    if (ns > worst) worst = ns;
+  }
+  report("heap link/unlink", total, worst);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_exhaustion);
+  RUN_TEST(test_pool_vs_heap);
+  return UNITY_END();
+}
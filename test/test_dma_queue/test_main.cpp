@@ -0,0 +1,129 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// taskQueue on the host model: the first push on a software triggered
+// channel, recovery from the fence fetch error, peripheral triggered queues
+// and descriptor reclaim over many pushes.
+
+using namespace samc::dma;
+
+static uint32_t src[8];
+static uint32_t dst[4][8];
+static volatile uint32_t fifo;
+
+static void prepare(taskDescriptor &task, uint32_t (*to)[8]) {
+  task.setSource(&src);
+  task.setDestination(to);
+  task.setLength(8);
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  for (int i = 0; i < 8; i++) {
+    src[i] = 0xA0000000 + i;
+  }
+  memset(dst, 0, sizeof(dst));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+void test_first_push() {
+  taskQueue queue;
+  ch::setTransferMode(MODE_TRANSFER_ALL, 3);
+  TEST_ASSERT_TRUE(queue.attach(3));
+  TEST_ASSERT_EQUAL(STATE_IDLE, ch::getState(3));
+
+  taskDescriptor task;
+  prepare(task, &dst[0]);
+  TEST_ASSERT_TRUE(queue.push(task));
+  TEST_ASSERT_EQUAL_MEMORY(src, dst[0], sizeof(src));
+}
+
+// Once drained the channel parks on the fence with a fetch error, the next
+// push resumes it.
+void test_fence_recovery() {
+  taskQueue queue;
+  ch::setTransferMode(MODE_TRANSFER_ALL, 3);
+  queue.attach(3);
+
+  taskDescriptor a, b, c;
+  prepare(a, &dst[0]);
+  prepare(b, &dst[1]);
+  prepare(c, &dst[2]);
+  queue.push(a);
+  TEST_ASSERT_TRUE(DMAC->Channel[3].CHSTATUS.bit.FERR);
+  TEST_ASSERT_EQUAL(STATE_SUSPENDED, ch::getState(3));
+
+  queue.push(b);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst[1], sizeof(src));
+  queue.push(c);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst[2], sizeof(src));
+  TEST_ASSERT_TRUE(queue.getPending() <= 1);
+}
+
+// Queued while the channel waits for its peripheral, nothing moves until
+// it triggers.
+void test_peripheral_queue() {
+  taskQueue queue;
+  ch::setPeripheral(LINK_TC0_OOB, 5);
+  ch::setTransferMode(MODE_TRANSFER_1VALUE, 5);
+  queue.attach(5);
+
+  taskDescriptor a, b;
+  a.setSource(&fifo);
+  a.setDestination(&dst[0]);
+  a.setLength(2);
+  b.setSource(&fifo);
+  b.setDestination(&dst[1]);
+  b.setLength(2);
+  queue.push(a);
+  queue.push(b);
+  TEST_ASSERT_EQUAL_UINT32(0, dst[0][0]);
+
+  for (uint32_t i = 0; i < 4; i++) {
+    fifo = 100 + i;
+    sim::trigger(5);
+    queue.poll();
+  }
+  TEST_ASSERT_EQUAL_UINT32(100, dst[0][0]);
+  TEST_ASSERT_EQUAL_UINT32(101, dst[0][1]);
+  TEST_ASSERT_EQUAL_UINT32(102, dst[1][0]);
+  TEST_ASSERT_EQUAL_UINT32(103, dst[1][1]);
+}
+
+// Far more pushes than the pool holds, completed blocks must be reclaimed.
+void test_reclaim() {
+  taskQueue queue;
+  ch::setTransferMode(MODE_TRANSFER_ALL, 6);
+  queue.attach(6);
+
+  taskDescriptor task;
+  prepare(task, &dst[3]);
+  for (int i = 0; i < DMA_DESC_POOL_SIZE * 3; i++) {
+    src[0] = i;
+    TEST_ASSERT_TRUE(queue.push(task));
+    TEST_ASSERT_EQUAL_UINT32(i, dst[3][0]);
+  }
+  TEST_ASSERT_TRUE(queue.getPending() <= 1);
+  TEST_ASSERT_TRUE(queue.detach());
+  TEST_ASSERT_FALSE(queue.push(task));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_push);
+  RUN_TEST(test_fence_recovery);
+  RUN_TEST(test_peripheral_queue);
+  RUN_TEST(test_reclaim);
+  return UNITY_END();
+}
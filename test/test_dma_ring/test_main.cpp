@@ -0,0 +1,109 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// ringBuffer on the host model, one halfword per timer trigger: reading
+// across the wrap, overrun when the writer reaches the read index between
+// polls, reading on from the write index afterwards, and the documented
+// blind spot of a consumer that misses a whole lap. The rings are static as
+// the descriptors point into them, see test/sim/sam.h.
+
+using namespace samc::dma;
+
+static volatile uint16_t fifo;
+static ringBuffer<uint16_t, 8> ring;
+static uint16_t next;
+
+static void push(const int &count) {
+  for (int i = 0; i < count; i++) {
+    fifo = next++;
+    sim::trigger(4);
+  }
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  next = 100;
+  ch::setPeripheral(LINK_TC0_OOB, 4);
+  ch::setTransferMode(MODE_TRANSFER_1VALUE, 4);
+  TEST_ASSERT_TRUE(ring.attach(&fifo, 4));
+  ch::setState(STATE_IDLE, 4);
+}
+
+void tearDown(void) {
+  ring.detach();
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// The span stops at the end of the storage, read() carries on from the
+// start in order.
+void test_wrap() {
+  uint16_t out[8];
+  TEST_ASSERT_EQUAL(0, ring.getAvailable());
+  push(5);
+  TEST_ASSERT_EQUAL(5, ring.getAvailable());
+  TEST_ASSERT_EQUAL(5, ring.read(out, 8));
+  TEST_ASSERT_EQUAL_UINT16(104, out[4]);
+
+  push(6);
+  int count = 0;
+  const uint16_t *span = ring.getSpan(count);
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL_UINT16(105, span[0]);
+  TEST_ASSERT_EQUAL(6, ring.read(out, 8));
+  for (int i = 0; i < 6; i++) {
+    TEST_ASSERT_EQUAL_UINT16(105 + i, out[i]);
+  }
+  TEST_ASSERT_FALSE(ring.getOverrun());
+  TEST_ASSERT_FALSE(ring.consume(1));
+}
+
+// Reaching the read index is an overrun: the unread samples are dropped and
+// reading resumes with what is written after the poll that saw it.
+void test_overrun_recovery() {
+  uint16_t out[8];
+  push(3);
+  TEST_ASSERT_EQUAL(3, ring.getAvailable());
+  push(5);
+  TEST_ASSERT_EQUAL(0, ring.getAvailable());
+  TEST_ASSERT_TRUE(ring.getOverrun());
+
+  push(2);
+  TEST_ASSERT_EQUAL(2, ring.read(out, 8));
+  TEST_ASSERT_EQUAL_UINT16(108, out[0]);
+  TEST_ASSERT_EQUAL_UINT16(109, out[1]);
+  TEST_ASSERT_TRUE(ring.getOverrun());
+  ring.clearOverrun();
+  TEST_ASSERT_FALSE(ring.getOverrun());
+
+  push(7);
+  TEST_ASSERT_EQUAL(7, ring.read(out, 8));
+  TEST_ASSERT_EQUAL_UINT16(110, out[0]);
+  TEST_ASSERT_FALSE(ring.getOverrun());
+}
+
+// A whole lap between polls leaves the write index where it was, which
+// reads as nothing written.
+void test_missed_lap() {
+  uint16_t out[8];
+  push(2);
+  TEST_ASSERT_EQUAL(2, ring.read(out, 8));
+  push(8);
+  TEST_ASSERT_EQUAL(0, ring.getAvailable());
+  TEST_ASSERT_FALSE(ring.getOverrun());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_wrap);
+  RUN_TEST(test_overrun_recovery);
+  RUN_TEST(test_missed_lap);
+  return UNITY_END();
+}
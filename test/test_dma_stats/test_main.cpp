@@ -0,0 +1,165 @@
+#include <unity.h>
+#include <string.h>
+#include <dma_core.h>
+
+// Per-channel statistics on the host model, built with DMA_STATS_ENABLED
+// (pio test -e native_switches): transfer and byte counts, the log2 latency
+// bins, error and suspend counts, and the dumpStats report.
+
+#if !DMA_STATS_ENABLED
+  #error "test_dma_stats needs -D DMA_STATS_ENABLED=true"
+#endif
+
+using namespace samc::dma;
+
+static uint8_t src[1024] __ALIGNED(4);
+static uint8_t dst[1024] __ALIGNED(4);
+static volatile uint32_t stamp;
+static char lines[4][128];
+static int lineCount;
+
+static void onTransfer(int index, void *context) {
+  stamp = DWT->CYCCNT;
+}
+
+static void onError(int index, CHANNEL_ERROR error, void *context) {}
+
+static void onLine(const char *line) {
+  if (lineCount < 4) {
+    strncpy(lines[lineCount], line, sizeof(lines[0]) - 1);
+  }
+  lineCount++;
+}
+
+static int binOf(const uint32_t &cycles) {
+  return cycles ? 32 - __builtin_clz(cycles) : 0;
+}
+
+static void prepare(taskDescriptor &task, const int &bytes, const int &index) {
+  task.setSource((const uint8_t(*)[1024])&src);
+  task.setDestination((uint8_t(*)[1024])&dst);
+  task.setLength(bytes);
+  task.setEnabled(true);
+  ((DmacDescriptor*)task)->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+  ch::clearTasks(index);
+  ch::addTask(0, task, index);
+}
+
+static int usedBins(const channelStats &stats, int &bin) {
+  int used = 0;
+  for (int i = 0; i < DMA_STATS_BINS; i++) {
+    if (stats.latency[i]) {
+      bin = i;
+      used += stats.latency[i];
+    }
+  }
+  return used;
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  memset(lines, 0, sizeof(lines));
+  lineCount = 0;
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    sys::clearStats(i);
+  }
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    ch::setTransferCallback(nullptr, nullptr, i);
+    ch::setErrorCallback(nullptr, nullptr, i);
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// One transfer lands in exactly one bin, the bin of the start to TCMPL time,
+// which lies inside the window the caller sees from setState to the callback.
+void test_latency_bins() {
+  channelCtrl<2> channel;
+  taskDescriptor task;
+  channelStats stats;
+  channel.setTransferMode(MODE_TRANSFER_ALL);
+  ch::setTransferCallback(onTransfer, nullptr, 2);
+  prepare(task, 16, 2);
+
+  const uint32_t start = DWT->CYCCNT;
+  TEST_ASSERT_TRUE(channel.setState(STATE_ACTIVE));
+  const uint32_t shortWindow = stamp - start;
+  TEST_ASSERT_TRUE(sys::getStats(2, stats));
+  int shortBin = -1;
+  TEST_ASSERT_EQUAL(1, usedBins(stats, shortBin));
+  TEST_ASSERT_EQUAL_UINT32(1, stats.transfers);
+  TEST_ASSERT_EQUAL_UINT32(16, (uint32_t)stats.bytes);
+  TEST_ASSERT_TRUE(shortBin > 0 && shortBin <= binOf(shortWindow));
+
+  // Sixty-four times the beats moves the second transfer at least a few bins up.
+  prepare(task, 1024, 2);
+  channel.setState(STATE_ACTIVE);
+  TEST_ASSERT_TRUE(sys::getStats(2, stats));
+  int longBin = -1;
+  TEST_ASSERT_EQUAL(2, usedBins(stats, longBin));
+  TEST_ASSERT_EQUAL_UINT32(1, stats.latency[shortBin]);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.latency[longBin]);
+  TEST_ASSERT_TRUE(longBin >= shortBin + 4);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.transfers);
+  TEST_ASSERT_EQUAL_UINT32(16 + 1024, (uint32_t)stats.bytes);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, 1024);
+
+  sys::clearStats(2);
+  TEST_ASSERT_TRUE(sys::getStats(2, stats));
+  TEST_ASSERT_EQUAL(0, usedBins(stats, longBin));
+  TEST_ASSERT_EQUAL_UINT32(0, stats.transfers);
+}
+
+void test_errors_and_suspends() {
+  channelCtrl<4> channel;
+  taskDescriptor task;
+  channelStats stats;
+  channel.setTransferMode(MODE_TRANSFER_ALL);
+  ch::setTransferCallback(onTransfer, nullptr, 4);
+  ch::setErrorCallback(onError, nullptr, 4);
+  prepare(task, 64, 4);
+  sim::failAfter(4, 3);
+  channel.setState(STATE_ACTIVE);
+  TEST_ASSERT_TRUE(sys::getStats(4, stats));
+  TEST_ASSERT_EQUAL_UINT32(1, stats.errors[ERROR_TRANSFER]);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.transfers);
+
+  prepare(task, 64, 4);
+  channel.setState(STATE_SUSPENDED);
+  channel.setState(STATE_IDLE);
+  TEST_ASSERT_TRUE(sys::getStats(4, stats));
+  TEST_ASSERT_EQUAL_UINT32(1, stats.suspends);
+  TEST_ASSERT_FALSE(sys::getStats(DMAC_CH_NUM, stats));
+}
+
+void test_dump() {
+  channelCtrl<6> channel;
+  taskDescriptor task;
+  channel.setTransferMode(MODE_TRANSFER_ALL);
+  ch::setTransferCallback(onTransfer, nullptr, 6);
+  prepare(task, 32, 6);
+  channel.setState(STATE_ACTIVE);
+
+  TEST_ASSERT_FALSE(sys::dumpStats(6, nullptr));
+  TEST_ASSERT_TRUE(sys::dumpStats(6, onLine));
+  TEST_ASSERT_EQUAL(2, lineCount);
+  TEST_ASSERT_EQUAL_STRING("ch6 transfers=1 bytes=32 suspends=0 "
+    "errors(crc/desc/xfer/stall)=0/0/0/0", lines[0]);
+  TEST_ASSERT_EQUAL(0, strncmp(lines[1], "ch6 latency<2^", 14));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_latency_bins);
+  RUN_TEST(test_errors_and_suspends);
+  RUN_TEST(test_dump);
+  return UNITY_END();
+}
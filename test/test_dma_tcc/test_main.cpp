@@ -0,0 +1,142 @@
+#include <unity.h>
+#include <new>
+#include <tcc_core.h>
+
+// tcc::dutyStream and tcc::dutyBurst on the host model: duty values landing
+// in CCBUF one trigger at a time, the trigger source and transfer mode each
+// one picks, looped and one-shot runs, and dutyBurst keeping its rows on
+// descriptor alignment inside an object placed off it. dutyBurst objects are
+// static as the descriptors they hold must sit at 32-bit addresses, see
+// test/sim/sam.h.
+
+using namespace samc;
+
+static const uint32_t duty[4] = { 100, 200, 300, 400 };
+static const uint32_t rows[3][3] = { { 1, 2, 3 }, { 4, 5, 6 }, { 7, 8, 9 } };
+static const uint32_t pairs[2][2] = { { 10, 20 }, { 30, 40 } };
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    dma::configGroup::prilvl_enabled[i] = true;
+  }
+  dma::sys::setInit(true);
+  dma::sys::setEnabled(true);
+  memset((void*)TCC0, 0, sizeof(Tcc));
+  memset((void*)TCC1, 0, sizeof(Tcc));
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    dma::allocCtrl::release(i);
+    dma::ch::setInit(false, i);
+  }
+}
+
+// One value per overflow into CCBUF[2], done after the last one.
+void test_stream_once() {
+  tcc::dutyStream<0, 2> stream;
+  TEST_ASSERT_TRUE(stream.start(duty, 4, false));
+  const int index = stream.getChannel();
+  TEST_ASSERT_EQUAL_STRING("tcc", dma::allocCtrl::getOwner(index));
+  TEST_ASSERT_EQUAL(dma::LINK_TCC0_OOB, dma::ch::getPeripheral(index));
+  TEST_ASSERT_EQUAL(dma::MODE_TRANSFER_1VALUE, dma::ch::getTransferMode(index));
+  TEST_ASSERT_EQUAL(dma::STATE_IDLE, dma::ch::getState(index));
+  TEST_ASSERT_FALSE(stream.start(duty, 4, false));
+
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_FALSE(stream.getDone());
+    sim::trigger(index);
+    TEST_ASSERT_EQUAL_UINT32(duty[i], TCC0->CCBUF[2].reg);
+  }
+  TEST_ASSERT_TRUE(stream.getDone());
+  TEST_ASSERT_EQUAL_UINT32(0, TCC0->CCBUF[1].reg);
+  TEST_ASSERT_EQUAL_UINT32(0, TCC0->CCBUF[3].reg);
+
+  TEST_ASSERT_TRUE(stream.stop());
+  TEST_ASSERT_NULL(dma::allocCtrl::getOwner(index));
+  TEST_ASSERT_FALSE(stream.stop());
+}
+
+// Triggered on the compare match, wrapping until stopped.
+void test_stream_looped() {
+  tcc::dutyStream<1, 1, false> stream;
+  TEST_ASSERT_FALSE(stream.start(duty, 0, true));
+  TEST_ASSERT_TRUE(stream.start(duty, 3, true));
+  const int index = stream.getChannel();
+  TEST_ASSERT_EQUAL(dma::LINK_TCC1_OOB + 2, dma::ch::getPeripheral(index));
+  for (int i = 0; i < 7; i++) {
+    sim::trigger(index);
+    TEST_ASSERT_EQUAL_UINT32(duty[i % 3], TCC1->CCBUF[1].reg);
+  }
+  TEST_ASSERT_FALSE(stream.getDone());
+  TEST_ASSERT_TRUE(stream.stop());
+  TEST_ASSERT_TRUE(stream.getDone());
+}
+
+// Three channels go as a block per trigger from the descriptors held in the
+// object, a looped run goes back to the first row.
+void test_burst_rows() {
+  static tcc::dutyBurst<0, 1, 3, 3> burst;
+  TEST_ASSERT_TRUE(burst.start(rows, true));
+  const int index = burst.getChannel();
+  TEST_ASSERT_EQUAL(dma::MODE_TRANSFER_TASK, dma::ch::getTransferMode(index));
+  for (int i = 0; i < 5; i++) {
+    sim::trigger(index);
+    TEST_ASSERT_EQUAL_UINT32(rows[i % 3][0], TCC0->CCBUF[1].reg);
+    TEST_ASSERT_EQUAL_UINT32(rows[i % 3][1], TCC0->CCBUF[2].reg);
+    TEST_ASSERT_EQUAL_UINT32(rows[i % 3][2], TCC0->CCBUF[3].reg);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, TCC0->CCBUF[0].reg);
+  TEST_ASSERT_EQUAL_UINT32(0, TCC0->CCBUF[4].reg);
+  TEST_ASSERT_FALSE(burst.getDone());
+  TEST_ASSERT_TRUE(burst.stop());
+}
+
+// Two channels go as one burst per trigger.
+void test_burst_pairs() {
+  static tcc::dutyBurst<1, 2, 2, 2> burst;
+  TEST_ASSERT_TRUE(burst.start(pairs, false));
+  const int index = burst.getChannel();
+  TEST_ASSERT_EQUAL(dma::MODE_TRANSFER_2VALUE, dma::ch::getTransferMode(index));
+  sim::trigger(index);
+  TEST_ASSERT_EQUAL_UINT32(10, TCC1->CCBUF[2].reg);
+  TEST_ASSERT_EQUAL_UINT32(20, TCC1->CCBUF[3].reg);
+  TEST_ASSERT_FALSE(burst.getDone());
+  sim::trigger(index);
+  TEST_ASSERT_EQUAL_UINT32(30, TCC1->CCBUF[2].reg);
+  TEST_ASSERT_EQUAL_UINT32(40, TCC1->CCBUF[3].reg);
+  TEST_ASSERT_TRUE(burst.getDone());
+}
+
+// An object placed 8 bytes off a 16-byte boundary, as new may under gnu++14,
+// still links its rows on descriptor alignment.
+void test_burst_alignment() {
+  typedef tcc::dutyBurst<0, 0, 3, 2> burstType;
+  static uint8_t storage[sizeof(burstType) + 16] __ALIGNED(16);
+  burstType *burst = new (storage + 8) burstType();
+  TEST_ASSERT_TRUE(burst->start(*(const uint32_t(*)[2][3])rows, false));
+  const int index = burst->getChannel();
+  const uintptr_t next = dma::ch::getBaseDescriptor(index)->DESCADDR.reg;
+  TEST_ASSERT_EQUAL_UINT32(0, next & 15);
+  TEST_ASSERT_TRUE(next >= (uintptr_t)storage + 8);
+  TEST_ASSERT_TRUE(next + sizeof(DmacDescriptor) <= (uintptr_t)burst 
+    + sizeof(burstType));
+  sim::trigger(index);
+  sim::trigger(index);
+  TEST_ASSERT_EQUAL_UINT32(4, TCC0->CCBUF[0].reg);
+  TEST_ASSERT_EQUAL_UINT32(6, TCC0->CCBUF[2].reg);
+  TEST_ASSERT_TRUE(burst->getDone());
+  burst->stop();
+  burst->~burstType();
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_stream_once);
+  RUN_TEST(test_stream_looped);
+  RUN_TEST(test_burst_rows);
+  RUN_TEST(test_burst_pairs);
+  RUN_TEST(test_burst_alignment);
+  return UNITY_END();
+}
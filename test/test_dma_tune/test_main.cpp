@@ -0,0 +1,193 @@
+#include <unity.h>
+#include <string.h>
+#include <dma_tune.h>
+
+// tune::run and tune::emit on the host model. The model charges a fixed cost
+// per burst and ignores QoS and FIFO thresholds, so only the BURSTLEN pick is
+// meaningful here; what is checked is that the sweep runs every row, moves
+// the data, hands its channels back and that emit writes a usable header.
+
+using namespace samc::dma;
+
+static uint32_t src[64];
+static uint32_t dst[64];
+static uint32_t loadSrc[16];
+static uint32_t loadDst[16];
+
+static char lines[256][128];
+static int lineCount;
+
+static void collect(const char *line) {
+  if (lineCount < 256) {
+    strncpy(lines[lineCount], line, sizeof(lines[0]) - 1);
+    lines[lineCount][sizeof(lines[0]) - 1] = 0;
+  }
+  lineCount++;
+}
+
+// CHCTRLA of the measured channel as each row is written.
+static uint32_t rowCtrla;
+
+static void collectCtrla(const char *line) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    const char *owner = allocCtrl::getOwner(i);
+    if (owner && !strcmp(owner, "tune")) {
+      rowCtrla = DMAC->Channel[i].CHCTRLA.reg;
+    }
+  }
+  collect(line);
+}
+
+static bool contains(const char *text) {
+  for (int i = 0; i < lineCount && i < 256; i++) {
+    if (strstr(lines[i], text)) return true;
+  }
+  return false;
+}
+
+static tuneShape shape() {
+  tuneShape value;
+  value.source = src;
+  value.destination = dst;
+  value.length = 64;
+  value.repetitions = 4;
+  return value;
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  for (int i = 0; i < 64; i++) {
+    src[i] = 0xC0DE0000 + i;
+  }
+  for (int i = 0; i < 16; i++) {
+    loadSrc[i] = 0x10AD0000 + i;
+  }
+  memset(loadDst, 0, sizeof(loadDst));
+  memset(dst, 0, sizeof(dst));
+  memset(lines, 0, sizeof(lines));
+  lineCount = 0;
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    allocCtrl::release(i);
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// 18 BURSTLEN/THRESHOLD pairs times 4 QoS values, one row each plus the
+// heading. Fixed burst cost makes the longest burst the winner.
+void test_sweep() {
+  tuneResult best;
+  DMAC->PRICTRL0.reg = 0x00000101;
+  TEST_ASSERT_TRUE(tune::run(shape(), best, collect));
+  TEST_ASSERT_EQUAL(1 + 18 * 4, lineCount);
+  TEST_ASSERT_EQUAL_STRING("burst,threshold,qos,rr,worst,mean", lines[0]);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, sizeof(src));
+
+  TEST_ASSERT_EQUAL(MODE_TRANSFER_16VALUE, best.mode);
+  TEST_ASSERT_TRUE(best.meanCycles <= best.worstCycles);
+  TEST_ASSERT_TRUE(best.worstCycles > 0);
+  TEST_ASSERT_EQUAL_HEX32(0x00000101, DMAC->PRICTRL0.reg);
+  TEST_ASSERT_EQUAL_HEX32(0, allocCtrl::getAllocated());
+}
+
+// The rows are measured with the trigger action, burst length and threshold
+// that emit would write for them, the last one being 16 beats at 8.
+void test_measured_as_emitted() {
+  tuneResult best;
+  TEST_ASSERT_TRUE(tune::run(shape(), best, collectCtrla));
+  TEST_ASSERT_EQUAL(0, strncmp(lines[lineCount - 1], "16,8,3,0,", 9));
+  const uint32_t mask = DMAC_CHCTRLA_TRIGSRC_Msk | DMAC_CHCTRLA_TRIGACT_Msk 
+    | DMAC_CHCTRLA_BURSTLEN_Msk | DMAC_CHCTRLA_THRESHOLD_Msk;
+  TEST_ASSERT_EQUAL_HEX32((channelConfig<LINK_NONE, MODE_TRANSFER_16VALUE, 3, 
+    false, 8>::chctrla), rowCtrla & mask);
+}
+
+// Self-linked load channels keep running under the measured one and are
+// stopped and released afterwards; with two of them the round-robin rows
+// are swept as well.
+void test_background_load() {
+  tuneShape value = shape();
+  value.loadChannels = 2;
+  value.loadSource = loadSrc;
+  value.loadDestination = loadDst;
+  value.loadLength = 16;
+
+  tuneResult best;
+  TEST_ASSERT_TRUE(tune::run(value, best, collect));
+  TEST_ASSERT_EQUAL(1 + 18 * 4 * 2, lineCount);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, sizeof(src));
+  TEST_ASSERT_EQUAL_MEMORY(loadSrc, loadDst, sizeof(loadSrc));
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    TEST_ASSERT_FALSE(DMAC->Channel[i].CHCTRLA.bit.ENABLE);
+  }
+  TEST_ASSERT_EQUAL_HEX32(0, allocCtrl::getAllocated());
+}
+
+void test_rejects() {
+  tuneResult best;
+  tuneShape value = shape();
+  value.length = 0;
+  TEST_ASSERT_FALSE(tune::run(value, best));
+  value = shape();
+  value.beatSize = 3;
+  TEST_ASSERT_FALSE(tune::run(value, best));
+  value = shape();
+  value.prilvl = 0;
+  TEST_ASSERT_FALSE(tune::run(value, best));
+  value = shape();
+  value.loadChannels = 1;
+  TEST_ASSERT_FALSE(tune::run(value, best));
+  value = shape();
+  value.loadChannels = DMA_TUNE_MAX_LOAD + 1;
+  TEST_ASSERT_FALSE(tune::run(value, best));
+  TEST_ASSERT_EQUAL_HEX32(0, allocCtrl::getAllocated());
+}
+
+// A transfer that faults fails the sweep instead of reporting a winner.
+void test_fault() {
+  tuneShape value = shape();
+  value.destination = (void*)(uintptr_t)0x4;
+  tuneResult best;
+  TEST_ASSERT_FALSE(tune::run(value, best));
+  TEST_ASSERT_EQUAL_HEX32(0, allocCtrl::getAllocated());
+}
+
+void test_emit() {
+  tuneShape value = shape();
+  value.link = LINK_TC0_OOB;
+  tuneResult best;
+  best.mode = MODE_TRANSFER_8VALUE;
+  best.threshold = 4;
+  best.qos = 2;
+  best.roundRobin = true;
+  best.worstCycles = 120;
+  best.meanCycles = 100;
+
+  TEST_ASSERT_FALSE(tune::emit(value, best, nullptr));
+  TEST_ASSERT_TRUE(tune::emit(value, best, collect));
+  TEST_ASSERT_EQUAL_STRING("#pragma once", lines[0]);
+  TEST_ASSERT_TRUE(contains("worst 120 cycles, mean 100 cycles, 64 beats of 4 bytes"));
+  TEST_ASSERT_TRUE(contains("samc::dma::MODE_TRANSFER_8VALUE, 3, false, 4>;"));
+  TEST_ASSERT_TRUE(contains("static constexpr int qos = 2;"));
+  TEST_ASSERT_TRUE(contains("static constexpr bool loadRoundRobin = true;"));
+  TEST_ASSERT_EQUAL_STRING("}", lines[lineCount - 1]);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sweep);
+  RUN_TEST(test_measured_as_emitted);
+  RUN_TEST(test_background_load);
+  RUN_TEST(test_rejects);
+  RUN_TEST(test_fault);
+  RUN_TEST(test_emit);
+  return UNITY_END();
+}
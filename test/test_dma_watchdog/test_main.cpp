@@ -0,0 +1,134 @@
+#include <unity.h>
+#include <dma_core.h>
+
+// watchdogCtrl on the host model: a channel left pending on a disabled
+// priority level is restarted after stallTicks services, one stopped by a
+// transfer error on the next service, both rerun from the base descriptor
+// and report ERROR_STALL. taskQueue channels cannot be watched.
+
+using namespace samc::dma;
+
+static uint32_t src[32];
+static uint32_t dst[32];
+static int stalls;
+
+static void onError(int index, CHANNEL_ERROR error, void *context) {
+  if (error == ERROR_STALL) {
+    stalls++;
+  }
+}
+
+static void prepare(taskDescriptor &task, const int &index) {
+  task.setSource(&src);
+  task.setDestination(&dst);
+  task.setLength(32);
+  task.setEnabled(true);
+  ((DmacDescriptor*)task)->BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;
+  ch::addTask(0, task, index);
+  ch::setTransferMode(MODE_TRANSFER_ALL, index);
+  ch::setErrorCallback(onError, nullptr, index);
+}
+
+void setUp(void) {
+  sim::reset();
+  for (int i = 0; i < DMA_PRILVL_COUNT; i++) {
+    configGroup::prilvl_enabled[i] = true;
+  }
+  sys::setInit(true);
+  sys::setEnabled(true);
+  for (int i = 0; i < 32; i++) {
+    src[i] = 0x5EED0000 + i;
+  }
+  memset(dst, 0, sizeof(dst));
+  stalls = 0;
+}
+
+void tearDown(void) {
+  for (int i = 0; i < DMAC_CH_NUM; i++) {
+    watchdogCtrl::setEnabled(i, false);
+    ch::setErrorCallback(nullptr, nullptr, i);
+    ch::clearTasks(i);
+    ch::setInit(false, i);
+  }
+}
+
+// Pending without moving for three services, restarted on the third; the
+// restart goes through once the level is enabled again.
+void test_stalled() {
+  taskDescriptor task;
+  prepare(task, 2);
+  TEST_ASSERT_TRUE(watchdogCtrl::setEnabled(2, true, 3));
+  DMAC->CTRL.reg &= ~DMAC_CTRL_LVLEN0;
+  ch::setState(STATE_ACTIVE, 2);
+  TEST_ASSERT_EQUAL(STATE_ACTIVE, ch::getState(2));
+
+  TEST_ASSERT_EQUAL(0, watchdogCtrl::service());
+  TEST_ASSERT_EQUAL(0, watchdogCtrl::service());
+  TEST_ASSERT_EQUAL(1, watchdogCtrl::service());
+  TEST_ASSERT_EQUAL(1, stalls);
+  TEST_ASSERT_EQUAL_UINT32(1, watchdogCtrl::getRestarts(2));
+  TEST_ASSERT_EQUAL(STATE_ACTIVE, ch::getState(2));
+  TEST_ASSERT_EQUAL(0, watchdogCtrl::service());
+
+  DMAC->CTRL.reg |= DMAC_CTRL_LVLEN0;
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, sizeof(src));
+  TEST_ASSERT_NOT_EQUAL(STATE_ACTIVE, ch::getState(2));
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL(0, watchdogCtrl::service());
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, watchdogCtrl::getRestarts(2));
+}
+
+// A transfer error is restarted on the next service, from the first beat.
+void test_transfer_error() {
+  taskDescriptor task;
+  prepare(task, 5);
+  TEST_ASSERT_TRUE(watchdogCtrl::setEnabled(5, true));
+  sim::failAfter(5, 10);
+  ch::setState(STATE_ACTIVE, 5);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, 10 * sizeof(uint32_t));
+  TEST_ASSERT_EQUAL_UINT32(0, dst[10]);
+
+  memset(dst, 0, sizeof(dst));
+  TEST_ASSERT_EQUAL(1, watchdogCtrl::service());
+  TEST_ASSERT_EQUAL(1, stalls);
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, sizeof(src));
+  TEST_ASSERT_EQUAL(0, watchdogCtrl::service());
+}
+
+// A queue's base descriptor has already run, so the watchdog and a queue
+// refuse each other's channel.
+void test_queue_channel() {
+  taskQueue queue;
+  ch::setTransferMode(MODE_TRANSFER_ALL, 3);
+  TEST_ASSERT_TRUE(queue.attach(3));
+  TEST_ASSERT_FALSE(watchdogCtrl::setEnabled(3, true));
+  TEST_ASSERT_FALSE(watchdogCtrl::getEnabled(3));
+  TEST_ASSERT_TRUE(watchdogCtrl::setEnabled(3, false));
+
+  taskDescriptor task;
+  task.setSource(&src);
+  task.setDestination(&dst);
+  task.setLength(32);
+  TEST_ASSERT_TRUE(queue.push(task));
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, sizeof(src));
+  memset(dst, 0, sizeof(dst));
+  for (int i = 0; i < 8; i++) {
+    TEST_ASSERT_EQUAL(0, watchdogCtrl::service());
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, dst[0]);
+
+  queue.detach();
+  TEST_ASSERT_TRUE(watchdogCtrl::setEnabled(3, true));
+  TEST_ASSERT_FALSE(queue.attach(3));
+  watchdogCtrl::setEnabled(3, false);
+  TEST_ASSERT_TRUE(queue.attach(3));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_stalled);
+  RUN_TEST(test_transfer_error);
+  RUN_TEST(test_queue_channel);
+  return UNITY_END();
+}